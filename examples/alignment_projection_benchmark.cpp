@@ -0,0 +1,171 @@
+/**
+ * @file alignment_projection_benchmark.cpp
+ * @brief Timing comparison of the VertexAlignment Phase 3 solvers over the input/ corpus
+ *
+ * For every map in the input directory, builds Phase 3 style constraints (1D line
+ * detection with the VertexAlignment score, nearest line within tolerance per axis),
+ * then solves the resulting QP with the Gurobi model Phase 3 used to build and with
+ * the closed-form solveAlignmentProjection(), and compares time and coordinates.
+ *
+ * Usage: alignment_projection_benchmark [inputDir=input] [tolerance=20]
+ */
+
+#include "VertexAlignment.h"
+#include "MapFileReader.h"
+#include "Clustering1D.h"
+#include "AxisLineIndex.h"
+#include "gurobi_c++.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+using namespace Map;
+
+// Cluster centers chosen with the VertexAlignment score wcss + 50k
+std::vector<double> detectLines(std::vector<double> coords) {
+    std::sort(coords.begin(), coords.end());
+    coords.erase(std::unique(coords.begin(), coords.end()), coords.end());
+    if (coords.size() < 3) return {};
+
+    int maxK = std::min(static_cast<int>(coords.size() / 3), static_cast<int>(std::sqrt(coords.size())) + 2);
+    Clustering1D clustering(coords, maxK);
+    double bestScore = std::numeric_limits<double>::max();
+    int bestK = 1;
+    for (int k = 1; k <= clustering.getMaxK(); ++k) {
+        double score = clustering.getWCSS(k) + k * 50.0;
+        if (score < bestScore) {
+            bestScore = score;
+            bestK = k;
+        }
+    }
+    return clustering.getCenters(bestK);
+}
+
+// The Phase 3 Gurobi model; returns false if it is not solved to optimality
+bool solveWithGurobi(GRBEnv& env, const std::vector<BaseVertexProperty>& vertexList,
+                     const std::vector<AxisConstraint>& constraints,
+                     double x_min, double x_max, double y_min, double y_max,
+                     std::vector<double>& X, std::vector<double>& Y) {
+    GRBModel model(env);
+    const int vertexNum = vertexList.size();
+    std::vector<GRBVar> x(vertexNum), y(vertexNum);
+    for (int i = 0; i < vertexNum; ++i) {
+        x[i] = model.addVar(x_min, x_max, 0.0, GRB_CONTINUOUS);
+        y[i] = model.addVar(y_min, y_max, 0.0, GRB_CONTINUOUS);
+    }
+    for (const auto& constraint : constraints) {
+        if (constraint.isHorizontal) model.addConstr(y[constraint.vertexIdx] == constraint.value);
+        else model.addConstr(x[constraint.vertexIdx] == constraint.value);
+    }
+    GRBQuadExpr objective = 0;
+    for (int i = 0; i < vertexNum; ++i) {
+        double px = vertexList[i].getCoord().x();
+        double py = vertexList[i].getCoord().y();
+        objective += (x[i] - px) * (x[i] - px) + (y[i] - py) * (y[i] - py);
+    }
+    model.setObjective(objective, GRB_MINIMIZE);
+    model.optimize();
+    if (model.get(GRB_IntAttr_Status) != GRB_OPTIMAL) return false;
+
+    X.resize(vertexNum);
+    Y.resize(vertexNum);
+    for (int i = 0; i < vertexNum; ++i) {
+        X[i] = x[i].get(GRB_DoubleAttr_X);
+        Y[i] = y[i].get(GRB_DoubleAttr_X);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string inputDir = (argc >= 2) ? argv[1] : "input";
+    double tolerance = (argc >= 3) ? std::stod(argv[2]) : 20.0;
+
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(inputDir)) {
+        if (entry.path().extension() == ".txt") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+
+    GRBEnv env(true);
+    env.set(GRB_IntParam_OutputFlag, 0);
+    env.start();
+
+    double totalGurobiMs = 0.0, totalProjectionMs = 0.0, worstDiff = 0.0;
+    int solvedNum = 0;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::left << std::setw(24) << "map" << std::right << std::setw(8) << "V" << std::setw(8) << "C"
+              << std::setw(12) << "gurobi ms" << std::setw(12) << "closed ms" << std::setw(12) << "max diff" << std::endl;
+
+    for (const auto& file : files) {
+        std::vector<BaseVertexProperty> vertexList;
+        std::vector<BaseEdgeProperty> edgeList;
+        BaseUGraphProperty graph;
+
+        // the reader is verbose
+        std::ostringstream sink;
+        std::streambuf* coutBuf = std::cout.rdbuf(sink.rdbuf());
+        bool loaded = readMapFileToGraph(file, vertexList, edgeList, graph);
+        std::cout.rdbuf(coutBuf);
+        if (!loaded || vertexList.empty()) continue;
+
+        double x_min = vertexList[0].getCoord().x(), x_max = x_min;
+        double y_min = vertexList[0].getCoord().y(), y_max = y_min;
+        std::vector<double> xs, ys;
+        for (const auto& vertex : vertexList) {
+            xs.push_back(vertex.getCoord().x());
+            ys.push_back(vertex.getCoord().y());
+            x_min = std::min(x_min, xs.back()); x_max = std::max(x_max, xs.back());
+            y_min = std::min(y_min, ys.back()); y_max = std::max(y_max, ys.back());
+        }
+
+        std::vector<double> hLines = detectLines(ys), vLines = detectLines(xs);
+        std::vector<int> hLine = AxisLineIndex(hLines).nearestWithin(ys, tolerance);
+        std::vector<int> vLine = AxisLineIndex(vLines).nearestWithin(xs, tolerance);
+        std::vector<AxisConstraint> constraints;
+        for (int i = 0; i < vertexList.size(); ++i) {
+            if (hLine[i] >= 0) constraints.push_back({i, true, hLines[hLine[i]]});
+            if (vLine[i] >= 0) constraints.push_back({i, false, vLines[vLine[i]]});
+        }
+
+        std::vector<double> gx, gy, px, py;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        bool gurobiOK = solveWithGurobi(env, vertexList, constraints, x_min, x_max, y_min, y_max, gx, gy);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        bool projectionOK = solveAlignmentProjection(vertexList, constraints, x_min, x_max, y_min, y_max, px, py);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        if (!gurobiOK || !projectionOK) {
+            std::cout << std::left << std::setw(24) << file << std::right << "  skipped (gurobi "
+                      << gurobiOK << ", projection " << projectionOK << ")" << std::endl;
+            continue;
+        }
+
+        double diff = 0.0;
+        for (int i = 0; i < vertexList.size(); ++i) {
+            diff = std::max(diff, std::max(std::abs(gx[i] - px[i]), std::abs(gy[i] - py[i])));
+        }
+        double gurobiMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double projectionMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        totalGurobiMs += gurobiMs;
+        totalProjectionMs += projectionMs;
+        worstDiff = std::max(worstDiff, diff);
+        ++solvedNum;
+
+        std::cout << std::left << std::setw(24) << file << std::right << std::setw(8) << vertexList.size()
+                  << std::setw(8) << constraints.size() << std::setw(12) << gurobiMs
+                  << std::setw(12) << projectionMs << std::setw(12) << diff << std::endl;
+    }
+
+    std::cout << "\nMaps: " << solvedNum << ", Gurobi " << totalGurobiMs << " ms, closed form "
+              << totalProjectionMs << " ms";
+    if (totalProjectionMs > 0.0) {
+        std::cout << " (" << std::setprecision(1) << totalGurobiMs / totalProjectionMs << "x)";
+    }
+    std::cout << std::setprecision(6) << ", max coordinate difference " << worstDiff << std::endl;
+    return worstDiff < 1e-4 ? 0 : 1;
+}
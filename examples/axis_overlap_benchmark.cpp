@@ -0,0 +1,221 @@
+/**
+ * @file axis_overlap_benchmark.cpp
+ * @brief Generic against axis-aligned overlap predicates over the edges of the input/ corpus
+ *
+ * For every map in the input directory, takes its edges as segments (with snap=1, edges
+ * within 10 degrees of an axis are made exactly horizontal or vertical, as after the
+ * orientation step) and draws blocks of blockSize points, or segments, against one edge,
+ * as overlapBatch tests candidates: a third random, a third on the line of the edge and a
+ * third sharing its range. Every block is answered by pointInsideSegment / segmentsOverlap
+ * <AXIS_GENERIC> and by the specialization for the axis of the edge, looked up once per
+ * edge beforehand. Reports the axis-aligned share of the edges, ns per pair and the
+ * speedup; both paths must agree on every pair.
+ *
+ * Usage: axis_overlap_benchmark [inputDir=input] [pairsPerMap=200000] [seed=1] [snap=1] [blockSize=16]
+ */
+
+#include "OverlapPredicates.h"
+#include "MapFileReader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Map;
+
+struct Segment {
+    double  xA, yA, xB, yB;
+};
+
+// Pairs of one block share their edge; struct of arrays so that the blocks vectorize
+struct Pairs {
+    std::vector<int>        edges;          // of every block
+    std::vector<double>     x, y;           // P, or C of CD
+    std::vector<double>     xD, yD;
+};
+
+// Edges within SNAP_DEGREES of an axis are snapped to it
+const double SNAP_DEGREES = 10.0;
+
+std::vector<Segment> readSegments(const std::string& file, bool snap) {
+    std::vector<BaseVertexProperty> vertexList;
+    std::vector<BaseEdgeProperty> edgeList;
+    BaseUGraphProperty graph;
+
+    // the reader is verbose
+    std::ostringstream sink;
+    std::streambuf* coutBuf = std::cout.rdbuf(sink.rdbuf());
+    bool loaded = readMapFileToGraph(file, vertexList, edgeList, graph);
+    std::cout.rdbuf(coutBuf);
+
+    std::vector<Segment> segments;
+    if (!loaded) return segments;
+    const double snapTan = std::tan(SNAP_DEGREES * M_PI / 180.0);
+    auto ep = boost::edges(graph);
+    for (auto eit = ep.first; eit != ep.second; ++eit) {
+        Segment s = {graph[*eit].Source().getCoord().x(), graph[*eit].Source().getCoord().y(),
+                     graph[*eit].Target().getCoord().x(), graph[*eit].Target().getCoord().y()};
+        double dx = std::abs(s.xB - s.xA), dy = std::abs(s.yB - s.yA);
+        if (snap && dy <= snapTan * dx) s.yB = s.yA;
+        else if (snap && dx <= snapTan * dy) s.xB = s.xA;
+        segments.push_back(s);
+    }
+    return segments;
+}
+
+// Random, on the line of the edge, or inside its range
+Pairs drawPairs(const std::vector<Segment>& segments, int count, int blockSize, std::mt19937& gen) {
+    double xMin = segments[0].xA, xMax = xMin, yMin = segments[0].yA, yMax = yMin;
+    for (const Segment& s : segments) {
+        xMin = std::min({xMin, s.xA, s.xB}); xMax = std::max({xMax, s.xA, s.xB});
+        yMin = std::min({yMin, s.yA, s.yB}); yMax = std::max({yMax, s.yA, s.yB});
+    }
+    std::uniform_int_distribution<int> anyEdge(0, static_cast<int>(segments.size()) - 1);
+    std::uniform_real_distribution<double> x(xMin, xMax), y(yMin, yMax), t(-0.5, 1.5);
+
+    count -= count % blockSize;
+    Pairs pairs;
+    pairs.x.resize(count); pairs.y.resize(count); pairs.xD.resize(count); pairs.yD.resize(count);
+    for (int p = 0; p < count; ++p) {
+        if (p % blockSize == 0) pairs.edges.push_back(anyEdge(gen));
+        const Segment& s = segments[pairs.edges.back()];
+        double tC = t(gen), tD = t(gen);
+        switch (gen() % 3) {
+            case 0:
+                pairs.x[p] = x(gen); pairs.y[p] = y(gen); pairs.xD[p] = x(gen); pairs.yD[p] = y(gen);
+                break;
+            case 1:
+                pairs.x[p] = s.xA + tC * (s.xB - s.xA); pairs.y[p] = s.yA + tC * (s.yB - s.yA);
+                pairs.xD[p] = s.xA + tD * (s.xB - s.xA); pairs.yD[p] = s.yA + tD * (s.yB - s.yA);
+                break;
+            default:
+                pairs.x[p] = s.xA + tC * (s.xB - s.xA); pairs.y[p] = y(gen);
+                pairs.xD[p] = x(gen); pairs.yD[p] = s.yA + tD * (s.yB - s.yA);
+        }
+    }
+    return pairs;
+}
+
+// One block against edge s; uint64_t results, as a char would alias the coordinates
+template <SegmentAxis Axis>
+void insideBlock(const Segment& s, const Pairs& pairs, int first, int last, std::uint64_t* result) {
+    for (int p = first; p < last; ++p) {
+        result[p] = pointInsideSegment<Axis>(pairs.x[p], pairs.y[p], s.xA, s.yA, s.xB, s.yB);
+    }
+}
+
+template <SegmentAxis Axis>
+void alongBlock(const Segment& s, const Pairs& pairs, int first, int last, std::uint64_t* result) {
+    for (int p = first; p < last; ++p) {
+        result[p] = segmentsOverlap<Axis>(s.xA, s.yA, s.xB, s.yB, pairs.x[p], pairs.y[p], pairs.xD[p], pairs.yD[p]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string inputDir = (argc >= 2) ? argv[1] : "input";
+    int pairsPerMap = (argc >= 3) ? std::stoi(argv[2]) : 200000;
+    unsigned seed = (argc >= 4) ? static_cast<unsigned>(std::stoul(argv[3])) : 1u;
+    bool snap = (argc >= 5) ? std::stoi(argv[4]) != 0 : true;
+    int blockSize = (argc >= 6) ? std::max(1, std::stoi(argv[5])) : 16;
+
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(inputDir)) {
+        if (entry.path().extension() == ".txt") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+
+    std::mt19937 gen(seed);
+    const char* names[] = {"pointInsideSegment generic", "pointInsideSegment by axis",
+                           "segmentsOverlap generic", "segmentsOverlap by axis"};
+    double ns[4] = {0.0, 0.0, 0.0, 0.0};
+    long hits[4] = {0, 0, 0, 0};
+    long edgeNum = 0, horizontalNum = 0, verticalNum = 0, pairNum = 0, mismatchNum = 0;
+
+    for (const auto& file : files) {
+        std::vector<Segment> segments = readSegments(file, snap);
+        if (segments.empty()) continue;
+
+        // the axis of every edge, once
+        std::vector<SegmentAxis> axes(segments.size());
+        for (std::size_t e = 0; e < segments.size(); ++e) {
+            axes[e] = segmentAxis(segments[e].xA, segments[e].yA, segments[e].xB, segments[e].yB);
+            horizontalNum += (axes[e] == AXIS_HORIZONTAL);
+            verticalNum += (axes[e] == AXIS_VERTICAL);
+        }
+        edgeNum += segments.size();
+
+        Pairs pairs = drawPairs(segments, pairsPerMap, blockSize, gen);
+        const int count = static_cast<int>(pairs.x.size());
+        std::vector<std::uint64_t> results[4];
+        for (int m = 0; m < 4; ++m) {
+            results[m].resize(count);
+            std::uint64_t* result = results[m].data();
+            auto t0 = std::chrono::high_resolution_clock::now();
+            for (std::size_t b = 0; b < pairs.edges.size(); ++b) {
+                const Segment& s = segments[pairs.edges[b]];
+                int first = static_cast<int>(b) * blockSize, last = first + blockSize;
+                switch (m) {
+                    case 0:
+                        insideBlock<AXIS_GENERIC>(s, pairs, first, last, result);
+                        break;
+                    case 1:
+                        switch (axes[pairs.edges[b]]) {
+                            case AXIS_HORIZONTAL:   insideBlock<AXIS_HORIZONTAL>(s, pairs, first, last, result); break;
+                            case AXIS_VERTICAL:     insideBlock<AXIS_VERTICAL>(s, pairs, first, last, result); break;
+                            default:                insideBlock<AXIS_GENERIC>(s, pairs, first, last, result);
+                        }
+                        break;
+                    case 2:
+                        alongBlock<AXIS_GENERIC>(s, pairs, first, last, result);
+                        break;
+                    default:
+                        switch (axes[pairs.edges[b]]) {
+                            case AXIS_HORIZONTAL:   alongBlock<AXIS_HORIZONTAL>(s, pairs, first, last, result); break;
+                            case AXIS_VERTICAL:     alongBlock<AXIS_VERTICAL>(s, pairs, first, last, result); break;
+                            default:                alongBlock<AXIS_GENERIC>(s, pairs, first, last, result);
+                        }
+                }
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+            ns[m] += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            for (std::uint64_t hit : results[m]) hits[m] += hit;
+        }
+
+        for (int m = 1; m < 4; m += 2) {
+            for (int p = 0; p < count; ++p) {
+                if (results[m][p] != results[m - 1][p] && ++mismatchNum <= 10) {
+                    const Segment& s = segments[pairs.edges[p / blockSize]];
+                    std::cout << file << ": " << names[m] << " " << results[m][p]
+                              << ", generic " << results[m - 1][p] << " for edge ("
+                              << s.xA << ", " << s.yA << ")-(" << s.xB << ", " << s.yB << ") and ("
+                              << pairs.x[p] << ", " << pairs.y[p] << ")-(" << pairs.xD[p] << ", " << pairs.yD[p] << ")" << std::endl;
+                }
+            }
+        }
+        pairNum += count;
+    }
+
+    if (pairNum == 0) {
+        std::cout << "No maps in " << inputDir << std::endl;
+        return 1;
+    }
+    std::cout << "Maps: " << files.size() << ", edges: " << edgeNum << " (horizontal "
+              << std::fixed << std::setprecision(1) << 100.0 * horizontalNum / edgeNum << "%, vertical "
+              << 100.0 * verticalNum / edgeNum << "%), pairs per predicate: " << pairNum << std::endl;
+    std::cout << std::left << std::setw(30) << "predicate" << std::right << std::setw(10) << "ns/pair"
+              << std::setw(10) << "hits" << std::setw(12) << "speedup" << std::endl;
+    for (int m = 0; m < 4; ++m) {
+        std::cout << std::left << std::setw(30) << names[m] << std::right << std::setprecision(2)
+                  << std::setw(10) << ns[m] / pairNum << std::setw(10) << hits[m] << std::setprecision(1)
+                  << std::setw(11) << ns[m & ~1] / std::max(ns[m], 1.0) << "x" << std::endl;
+    }
+    std::cout << "Mismatches against the generic predicates: " << mismatchNum << std::endl;
+    return mismatchNum == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file clustering_1d_benchmark.cpp
+ * @brief Timing and quality comparison of the VertexAlignment 1D line detection
+ *
+ * Runs the previous k-means elbow sweep (k-means from evenly spaced seeds for
+ * every k up to sqrt(n)+2) and the exact Clustering1D dynamic program on the same
+ * deduplicated coordinates, then compares time, selected k and score = wcss + 50k.
+ *
+ * Usage: clustering_1d_benchmark [coordinates=20000] [lines=150]
+ */
+
+#include "Clustering1D.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+
+using namespace Map;
+
+// The previous sweep; returns the best score and sets bestK
+double legacySweep(const std::vector<double>& sortedCoords, int maxK, int& bestK) {
+    double bestScore = std::numeric_limits<double>::max();
+    bestK = 1;
+    for (int k = 1; k <= maxK; ++k) {
+        std::vector<double> centroids(k);
+        for (int i = 0; i < k; ++i) {
+            int idx = (k == 1) ? sortedCoords.size() / 2 : i * (sortedCoords.size() - 1) / (k - 1);
+            centroids[i] = sortedCoords[idx];
+        }
+
+        bool converged = false;
+        for (int iter = 0; iter < 50 && !converged; ++iter) {
+            std::vector<std::vector<double>> clusters(k);
+            for (double coord : sortedCoords) {
+                int nearestCluster = 0;
+                double minDist = std::abs(coord - centroids[0]);
+                for (int i = 1; i < k; ++i) {
+                    double dist = std::abs(coord - centroids[i]);
+                    if (dist < minDist) {
+                        minDist = dist;
+                        nearestCluster = i;
+                    }
+                }
+                clusters[nearestCluster].push_back(coord);
+            }
+            converged = true;
+            for (int i = 0; i < k; ++i) {
+                if (!clusters[i].empty()) {
+                    double newCentroid = std::accumulate(clusters[i].begin(), clusters[i].end(), 0.0) / clusters[i].size();
+                    if (std::abs(newCentroid - centroids[i]) > 1e-6) converged = false;
+                    centroids[i] = newCentroid;
+                }
+            }
+        }
+
+        double wcss = 0.0;
+        for (double coord : sortedCoords) {
+            double minDist = std::numeric_limits<double>::max();
+            for (double centroid : centroids) minDist = std::min(minDist, std::abs(coord - centroid));
+            wcss += minDist * minDist;
+        }
+        double score = wcss + k * 50.0;
+        if (score < bestScore) {
+            bestScore = score;
+            bestK = k;
+        }
+    }
+    return bestScore;
+}
+
+int main(int argc, char* argv[]) {
+    int coordNum = (argc >= 2) ? std::stoi(argv[1]) : 20000;
+    int lineNum = (argc >= 3) ? std::stoi(argv[2]) : 150;
+
+    // Coordinates scattered around lineNum street positions
+    std::mt19937 gen(2315);
+    std::uniform_real_distribution<> street(0.0, 50.0 * lineNum);
+    std::normal_distribution<> noise(0.0, 3.0);
+    std::vector<double> streets(lineNum);
+    for (double& s : streets) s = street(gen);
+    std::vector<double> coords(coordNum);
+    for (int i = 0; i < coordNum; ++i) coords[i] = streets[i % lineNum] + noise(gen);
+
+    std::sort(coords.begin(), coords.end());
+    coords.erase(std::unique(coords.begin(), coords.end()), coords.end());
+    int maxK = std::min(static_cast<int>(coords.size() / 3), static_cast<int>(std::sqrt(coords.size())) + 2);
+    std::cout << "Coordinates: " << coords.size() << ", k = 1.." << maxK << std::endl;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    Clustering1D clustering(coords, maxK);
+    double bestScore = std::numeric_limits<double>::max();
+    int bestK = 1;
+    for (int k = 1; k <= clustering.getMaxK(); ++k) {
+        double score = clustering.getWCSS(k) + k * 50.0;
+        if (score < bestScore) {
+            bestScore = score;
+            bestK = k;
+        }
+    }
+    std::vector<double> centers = clustering.getCenters(bestK);
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    int legacyK = 0;
+    double legacyScore = legacySweep(coords, maxK, legacyK);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    double exactMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double legacyMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Exact DP:  " << exactMs << " ms, k = " << bestK << ", score = " << bestScore << std::endl;
+    std::cout << "k-means:   " << legacyMs << " ms, k = " << legacyK << ", score = " << legacyScore << std::endl;
+    std::cout << "Speedup:   " << std::setprecision(1) << legacyMs / exactMs << "x" << std::endl;
+    return bestScore <= legacyScore + 1e-6 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file dynamic_grid_build_benchmark.cpp
+ * @brief Timing comparison of DynamicGrid::buildAuxLines against the previous builder
+ *
+ * The previous builder walked the whole std::map of candidates for every vertex and
+ * copied the member lists out of per-position maps. Both builders run on the same
+ * street-like point set; the resulting lines (position, votes, vertex IDs in order)
+ * must be identical.
+ *
+ * Usage: dynamic_grid_build_benchmark [vertices=100000] [streets=2000] [skipLegacy=0]
+ */
+
+#include "DynamicGrid.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace Map;
+
+// The previous builder, returning (position, votes, vertex IDs) per line of one axis
+struct LegacyLine {
+    double              position;
+    int                 votes;
+    std::vector<int>    vertexIDs;
+};
+
+void legacyBuild(const BaseUGraphProperty& graph, double tolerance, double minVotes,
+                 std::vector<LegacyLine>& hLines, std::vector<LegacyLine>& vLines) {
+    std::map<double, int> vALVotes, hALVotes;
+    std::map<double, std::vector<int>> vAL2Vertices, hAL2Vertices;
+
+    auto vp = boost::vertices(graph);
+    for (auto vit = vp.first; vit != vp.second; ++vit) {
+        const BaseVertexProperty& vertex = graph[*vit];
+        double x = vertex.getCoord().x();
+        double y = vertex.getCoord().y();
+
+        bool foundVAL = false;
+        for (auto& pair : vALVotes) {
+            if (std::abs(pair.first - x) <= tolerance) {
+                pair.second++;
+                vAL2Vertices[pair.first].push_back(vertex.getID());
+                foundVAL = true;
+                break;
+            }
+        }
+        if (!foundVAL) {
+            vALVotes[x] = 1;
+            vAL2Vertices[x].push_back(vertex.getID());
+        }
+
+        bool foundHAL = false;
+        for (auto& pair : hALVotes) {
+            if (std::abs(pair.first - y) <= tolerance) {
+                pair.second++;
+                hAL2Vertices[pair.first].push_back(vertex.getID());
+                foundHAL = true;
+                break;
+            }
+        }
+        if (!foundHAL) {
+            hALVotes[y] = 1;
+            hAL2Vertices[y].push_back(vertex.getID());
+        }
+    }
+
+    for (const auto& pair : hALVotes) {
+        if (pair.second >= minVotes) hLines.push_back({pair.first, pair.second, hAL2Vertices[pair.first]});
+    }
+    for (const auto& pair : vALVotes) {
+        if (pair.second >= minVotes) vLines.push_back({pair.first, pair.second, vAL2Vertices[pair.first]});
+    }
+}
+
+bool sameLines(const std::vector<LegacyLine>& legacy, const std::vector<AuxiliaryLine>& lines) {
+    if (legacy.size() != lines.size()) return false;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (legacy[i].position != lines[i].getPosition() ||
+            legacy[i].votes != lines[i].getVoteCount() ||
+            legacy[i].vertexIDs != lines[i].getVertexIDs().toVector()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int vertexNum = (argc >= 2) ? std::stoi(argv[1]) : 100000;
+    int streetNum = (argc >= 3) ? std::stoi(argv[2]) : 2000;
+    bool skipLegacy = (argc >= 4) && std::stoi(argv[3]) != 0;
+    const double tolerance = 2.315;
+    const double minVotes = 2.0;
+
+    // Vertices scattered around streetNum x- and y-street positions
+    std::mt19937 gen(2315);
+    std::uniform_real_distribution<> street(0.0, 20.0 * streetNum);
+    std::uniform_int_distribution<> pick(0, streetNum - 1);
+    std::normal_distribution<> noise(0.0, 1.0);
+    std::vector<double> xStreets(streetNum), yStreets(streetNum);
+    for (double& s : xStreets) s = street(gen);
+    for (double& s : yStreets) s = street(gen);
+
+    BaseUGraphProperty graph;
+    for (int i = 0; i < vertexNum; ++i) {
+        BaseVertexProperty vertex(i, xStreets[pick(gen)] + noise(gen), yStreets[pick(gen)] + noise(gen), std::to_string(i));
+        boost::add_vertex(vertex, graph);
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    DynamicGrid grid(tolerance, minVotes);
+    grid.buildAuxLines(graph);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double buildMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Vertices: " << vertexNum << ", lines: " << grid.getHorizontalAuxLines().size() << " H / "
+              << grid.getVerticalAuxLines().size() << " V" << std::endl;
+    std::cout << "Sweep builder:    " << buildMs << " ms" << std::endl;
+    if (skipLegacy) return 0;
+
+    std::vector<LegacyLine> hLines, vLines;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    legacyBuild(graph, tolerance, minVotes, hLines, vLines);
+    auto t3 = std::chrono::high_resolution_clock::now();
+    double legacyMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+
+    bool same = sameLines(hLines, grid.getHorizontalAuxLines()) && sameLines(vLines, grid.getVerticalAuxLines());
+    std::cout << "Previous builder: " << legacyMs << " ms" << std::endl;
+    std::cout << "Speedup:          " << std::setprecision(1) << legacyMs / buildMs << "x" << std::endl;
+    std::cout << "Identical lines:  " << (same ? "yes" : "NO") << std::endl;
+    return same ? 0 : 1;
+}
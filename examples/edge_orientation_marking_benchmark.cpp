@@ -0,0 +1,193 @@
+/**
+ * @file edge_orientation_marking_benchmark.cpp
+ * @brief Timing comparison of the EdgeOrientation anti-overlap marking phase
+ *
+ * Compares the previous marking loop (listS iterator advanced for every vertex,
+ * neighbor out-edges rescanned for every candidate edge) against the indexed
+ * markEdgeOrientations() on a jittered grid with ~100k edges, and times the
+ * color-class parallel variant with 1 and N threads (results must agree).
+ *
+ * Usage: edge_orientation_marking_benchmark [gridSide=225] [skipLegacy=0] [threads=4]
+ */
+
+#define _USE_MATH_DEFINES
+#include "EdgeOrientation.h"
+#include "IndexedAdjacency.h"
+#include "ThreadPool.h"
+#include "MapFileReader.h"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+using namespace Map;
+
+// Jittered gridSide x gridSide lattice with 4-neighborhood edges plus a few diagonals
+void buildJitteredGrid(int gridSide, BaseUGraphProperty& graph, std::vector<BaseEdgeProperty>& edgeList) {
+    std::mt19937 gen(2315);
+    std::uniform_real_distribution<> jitter(-4.0, 4.0);
+    std::uniform_real_distribution<> coin(0.0, 1.0);
+
+    std::vector<BaseUGraphProperty::vertex_descriptor> descs;
+    for (int r = 0; r < gridSide; ++r) {
+        for (int c = 0; c < gridSide; ++c) {
+            unsigned int id = r * gridSide + c;
+            BaseVertexProperty vertex(id, c * 50.0 + jitter(gen), r * 50.0 + jitter(gen), std::to_string(id));
+            descs.push_back(boost::add_vertex(vertex, graph));
+        }
+    }
+
+    unsigned int edgeID = 0;
+    auto addEdge = [&](int a, int b) {
+        BaseVertexProperty& source = graph[descs[a]];
+        BaseVertexProperty& target = graph[descs[b]];
+        BaseEdgeProperty edge(source, target, edgeID++, calculateAngle(source, target));
+        boost::add_edge(descs[a], descs[b], edge, graph);
+        edgeList.push_back(edge);
+    };
+
+    for (int r = 0; r < gridSide; ++r) {
+        for (int c = 0; c < gridSide; ++c) {
+            int v = r * gridSide + c;
+            if (c + 1 < gridSide) addEdge(v, v + 1);
+            if (r + 1 < gridSide) addEdge(v, v + gridSide);
+            if (r + 1 < gridSide && c + 1 < gridSide && coin(gen) < 0.05) addEdge(v, v + gridSide + 1);
+        }
+    }
+}
+
+// The previous marking loop, with its console output removed
+void legacyMarking(
+    const std::vector<BaseEdgeProperty>& edgeList,
+    BaseUGraphProperty& graph,
+    std::vector<int>& edgeOriented2V,
+    std::vector<int>& edgeOriented2H) {
+
+    auto calculateAxisOffset = [](double angle, int axis) -> double {
+        while (angle < 0) angle += 2 * M_PI;
+        while (angle >= 2 * M_PI) angle -= 2 * M_PI;
+        if (axis == 0) {
+            return std::min(std::abs(angle - M_PI / 2), std::abs(angle - 3 * M_PI / 2));
+        }
+        return std::min(std::min(std::abs(angle), std::abs(angle - 2 * M_PI)), std::abs(angle - M_PI));
+    };
+
+    std::vector<std::pair<int, size_t>> degVertIdxPairs;
+    auto vp = boost::vertices(graph);
+    int vertexIndex = 0;
+    for (auto vi = vp.first; vi != vp.second; ++vi, ++vertexIndex) {
+        degVertIdxPairs.push_back({static_cast<int>(boost::out_degree(*vi, graph)), vertexIndex});
+    }
+    std::stable_sort(degVertIdxPairs.begin(), degVertIdxPairs.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    for (const auto& pair : degVertIdxPairs) {
+        auto vi = vp.first;
+        std::advance(vi, pair.second);
+        auto currentVertex = *vi;
+
+        for (int axis = 0; axis < 2; ++axis) {
+            std::vector<int>& marks = (axis == 0) ? edgeOriented2V : edgeOriented2H;
+            auto oep = boost::out_edges(currentVertex, graph);
+            for (auto oeit = oep.first; oeit != oep.second; ++oeit) {
+                int edgeIndex = graph[*oeit].ID();
+                if (marks[edgeIndex] != -1) continue;
+
+                if (calculateAxisOffset(edgeList[edgeIndex].Angle(), axis) <= 30.0 * M_PI / 180.0) {
+                    auto source = boost::source(*oeit, graph);
+                    auto oVertex = (source == currentVertex) ? boost::target(*oeit, graph) : source;
+                    bool flag = false;
+                    auto ooep = boost::out_edges(oVertex, graph);
+                    for (auto ooeit = ooep.first; ooeit != ooep.second; ++ooeit) {
+                        if (marks[graph[*ooeit].ID()] == 1) { flag = true; break; }
+                    }
+                    marks[edgeIndex] = flag ? 0 : 1;
+                }
+                else {
+                    marks[edgeIndex] = 0;
+                }
+            }
+
+            std::vector<int> candEdges;
+            for (auto eit = oep.first; eit != oep.second; ++eit) {
+                if (marks[graph[*eit].ID()] == 1) candEdges.push_back(graph[*eit].ID());
+            }
+            if (candEdges.size() > 1) {
+                int bestEdge = candEdges[0];
+                double minOffset = calculateAxisOffset(edgeList[bestEdge].Angle(), axis);
+                for (int e : candEdges) {
+                    double offset = calculateAxisOffset(edgeList[e].Angle(), axis);
+                    if (offset < minOffset) { minOffset = offset; bestEdge = e; }
+                }
+                for (int e : candEdges) {
+                    if (e != bestEdge) marks[e] = 0;
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int gridSide = (argc >= 2) ? std::stoi(argv[1]) : 225;
+    bool skipLegacy = (argc >= 3) && std::stoi(argv[2]) != 0;
+    int threadNum = (argc >= 4) ? std::stoi(argv[3]) : 4;
+
+    BaseUGraphProperty graph;
+    std::vector<BaseEdgeProperty> edgeList;
+    buildJitteredGrid(gridSide, graph, edgeList);
+
+    const int edgeNum = static_cast<int>(edgeList.size());
+    std::cout << "Vertices: " << boost::num_vertices(graph) << ", edges: " << edgeNum << std::endl;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    IndexedAdjacency adj = buildIndexedAdjacency(graph);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::vector<std::int8_t> newV(edgeNum, -1), newH(edgeNum, -1);
+    markEdgeOrientations(adj, edgeList, newV, newH);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    double buildMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double markMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Indexed:  adjacency " << buildMs << " ms + marking " << markMs << " ms" << std::endl;
+
+    // Parallel variant: a single-thread pool and an N-thread pool must agree
+    std::vector<std::int8_t> parV1(edgeNum, -1), parH1(edgeNum, -1), parVN(edgeNum, -1), parHN(edgeNum, -1);
+    ThreadPool serialPool(0);
+    ThreadPool widePool(std::max(1, threadNum - 1));
+    auto tp0 = std::chrono::high_resolution_clock::now();
+    markEdgeOrientationsParallel(adj, edgeList, parV1, parH1, serialPool);
+    auto tp1 = std::chrono::high_resolution_clock::now();
+    markEdgeOrientationsParallel(adj, edgeList, parVN, parHN, widePool);
+    auto tp2 = std::chrono::high_resolution_clock::now();
+    std::cout << "Parallel: " << serialPool.concurrency() << " threads "
+              << std::chrono::duration<double, std::milli>(tp1 - tp0).count() << " ms, "
+              << widePool.concurrency() << " threads "
+              << std::chrono::duration<double, std::milli>(tp2 - tp1).count() << " ms, "
+              << (parV1 == parVN && parH1 == parHN ? "deterministic" : "NOT deterministic") << std::endl;
+
+    if (skipLegacy) {
+        return 0;
+    }
+
+    std::vector<int> oldV(edgeNum, -1), oldH(edgeNum, -1);
+    auto t3 = std::chrono::high_resolution_clock::now();
+    legacyMarking(edgeList, graph, oldV, oldH);
+    auto t4 = std::chrono::high_resolution_clock::now();
+    double legacyMs = std::chrono::duration<double, std::milli>(t4 - t3).count();
+    std::cout << "Legacy:   marking " << legacyMs << " ms" << std::endl;
+    std::cout << "Speedup:  " << std::setprecision(1) << legacyMs / (buildMs + markMs) << "x" << std::endl;
+
+    int mismatches = 0;
+    for (int e = 0; e < edgeNum; ++e) {
+        mismatches += (oldV[e] != newV[e]) || (oldH[e] != newH[e]);
+    }
+    std::cout << (mismatches == 0 ? "Results identical" : "Mismatching edges: " + std::to_string(mismatches)) << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
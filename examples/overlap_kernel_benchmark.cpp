@@ -0,0 +1,259 @@
+/**
+ * @file overlap_kernel_benchmark.cpp
+ * @brief Per-call latency and allocations of the overlap checks over the input/ corpus
+ *
+ * For every map in the input directory, draws random (vertex, position) queries in
+ * batches of batchSize positions within two mean edge lengths of one vertex: a third
+ * anywhere, a third on the row or column of a nearby vertex and a third on a nearby
+ * vertex or edge midpoint. They
+ * are answered one by one with overlapHappens, overlapHappensOptimized (prebuilt
+ * SpatialGrid) and overlapKernel (with and without an OverlapReport, and over a geometry
+ * with its spatial index), and per batch with
+ * overlapHappensBatch and both overlapBatch front-ends. Reports ns and heap allocations
+ * per position; every check must agree with overlapHappens on every position, and the
+ * report with the kind of overlap it prints on request.
+ *
+ * Usage: overlap_kernel_benchmark [inputDir=input] [queriesPerMap=2000] [seed=1] [batchSize=8]
+ */
+
+#include "CheckOverlap.h"
+#include "MapFileReader.h"
+#include "Commons.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace Map;
+
+// Every heap allocation of the process goes through here
+static std::atomic<long> allocationNum(0);
+
+void* operator new(std::size_t size) {
+    ++allocationNum;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+struct Query {
+    int     vertexIndex;
+    Coord2  pos;
+};
+
+struct Method {
+    const char*     name;
+    double          ns;
+    long            allocations;
+};
+
+// Batches of positions for one vertex, drawn inside the window of +-reach around it
+std::vector<Query> drawQueries(const OverlapGeometry& geometry, const BaseUGraphProperty& graph, int count, int batchSize,
+                               double reach, std::mt19937& gen) {
+    std::vector<Coord2> midpoints;
+    auto ep = boost::edges(graph);
+    for (auto eit = ep.first; eit != ep.second; ++eit) {
+        midpoints.push_back(Coord2((graph[*eit].Source().getCoord().x() + graph[*eit].Target().getCoord().x()) / 2.0,
+                                   (graph[*eit].Source().getCoord().y() + graph[*eit].Target().getCoord().y()) / 2.0));
+    }
+
+    std::uniform_int_distribution<int> anyVertex(0, geometry.vertexNum() - 1);
+    std::uniform_real_distribution<double> offset(-reach, reach);
+    std::vector<Coord2> nearVertices, nearMidpoints;
+    std::vector<Query> queries(count);
+    for (int q = 0; q < count; ++q) {
+        Query& query = queries[q];
+        if (q % batchSize == 0) {
+            query.vertexIndex = anyVertex(gen);
+            Coord2 center = geometry.coord(query.vertexIndex);
+            auto inWindow = [&](const Coord2& p) {
+                return std::abs(p.x() - center.x()) <= reach && std::abs(p.y() - center.y()) <= reach;
+            };
+            nearVertices.clear();
+            nearMidpoints.clear();
+            for (int i = 0; i < geometry.vertexNum(); ++i) {
+                if (i != query.vertexIndex && inWindow(geometry.coord(i))) nearVertices.push_back(geometry.coord(i));
+            }
+            for (const Coord2& midpoint : midpoints) {
+                if (inWindow(midpoint)) nearMidpoints.push_back(midpoint);
+            }
+        }
+        else {
+            query.vertexIndex = queries[q - 1].vertexIndex;
+        }
+        Coord2 center = geometry.coord(query.vertexIndex);
+        Coord2 random(center.x() + offset(gen), center.y() + offset(gen));
+        Coord2 other = nearVertices.empty() ? random : nearVertices[gen() % nearVertices.size()];
+        switch (q % 6) {
+            case 0: case 1: query.pos = random; break;
+            case 2:         query.pos = Coord2(other.x(), random.y()); break;
+            case 3:         query.pos = Coord2(random.x(), other.y()); break;
+            case 4:         query.pos = other; break;
+            default:        query.pos = nearMidpoints.empty() ? other : nearMidpoints[gen() % nearMidpoints.size()];
+        }
+    }
+    return queries;
+}
+
+int main(int argc, char* argv[]) {
+    std::string inputDir = (argc >= 2) ? argv[1] : "input";
+    int queriesPerMap = (argc >= 3) ? std::stoi(argv[2]) : 2000;
+    unsigned seed = (argc >= 4) ? static_cast<unsigned>(std::stoul(argv[3])) : 1u;
+    int batchSize = (argc >= 5) ? std::max(1, std::stoi(argv[4])) : 8;
+
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(inputDir)) {
+        if (entry.path().extension() == ".txt") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+
+    std::mt19937 gen(seed);
+    Method methods[] = {{"overlapHappens", 0.0, 0}, {"overlapHappensOptimized", 0.0, 0},
+                        {"overlapKernel", 0.0, 0}, {"overlapKernel + report", 0.0, 0},
+                        {"overlapKernel (indexed)", 0.0, 0},
+                        {"overlapHappensBatch", 0.0, 0}, {"overlapBatch (graph)", 0.0, 0},
+                        {"overlapBatch (geometry)", 0.0, 0}};
+    const int firstBatchMethod = 5;
+    const int methodNum = sizeof(methods) / sizeof(methods[0]);
+    long queryNum = 0, overlapNum = 0, mismatchNum = 0;
+
+    for (const auto& file : files) {
+        std::vector<BaseVertexProperty> vertexList;
+        std::vector<BaseEdgeProperty> edgeList;
+        BaseUGraphProperty graph;
+
+        // the reader is verbose, as are the reference checks asked for their report
+        std::ostringstream sink;
+        std::streambuf* coutBuf = std::cout.rdbuf(sink.rdbuf());
+        bool loaded = readMapFileToGraph(file, vertexList, edgeList, graph);
+        std::cout.rdbuf(coutBuf);
+        if (!loaded || boost::num_vertices(graph) == 0) continue;
+
+        DescriptorMapping mapping = buildDescriptorMapping(graph);
+        ScopedDescriptorMapping scopedMapping(mapping);
+
+        OverlapGeometry geometry;
+        geometry.build(graph);
+        double totalLength = 0.0;
+        auto ep = boost::edges(graph);
+        for (auto eit = ep.first; eit != ep.second; ++eit) {
+            Coord2 d = graph[*eit].Source().getCoord() - graph[*eit].Target().getCoord();
+            totalLength += std::sqrt(d * d);
+        }
+        double meanLength = std::max(1.0, totalLength / std::max(1, geometry.edgeNum()));
+        SpatialGrid spatialGrid(1.5 * meanLength);
+        spatialGrid.buildFromGraph(graph);
+        OverlapGeometry indexedGeometry = geometry;
+        indexedGeometry.buildSpatialIndex(1.5 * meanLength);
+
+        std::vector<Query> queries = drawQueries(geometry, graph, queriesPerMap, batchSize, 2.0 * meanLength, gen);
+        std::vector<std::vector<Coord2>> batches;
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            if (q % batchSize == 0) batches.emplace_back();
+            batches.back().push_back(queries[q].pos);
+        }
+        std::vector<char> expected(queries.size()), actual(queries.size());
+        std::vector<std::string> expectedKind(queries.size());
+        std::vector<OverlapReport> reports(queries.size());
+
+        // reference answers and the kind overlapHappens prints for them, untimed
+        std::streambuf* quietBuf = std::cout.rdbuf(sink.rdbuf());
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            sink.str("");
+            expected[q] = overlapHappens(geometry.vertexID(queries[q].vertexIndex), queries[q].pos, graph, true);
+            if (expected[q]) {
+                std::string log = sink.str();
+                std::size_t end = log.rfind(" happens");
+                std::size_t begin = log.rfind('\n', end) + 1;
+                expectedKind[q] = log.substr(begin, end - begin);
+            }
+        }
+        std::cout.rdbuf(quietBuf);
+        sink.str("");
+
+        for (int m = 0; m < methodNum; ++m) {
+            quietBuf = std::cout.rdbuf(sink.rdbuf());
+            long allocationsBefore = allocationNum;
+            auto t0 = std::chrono::high_resolution_clock::now();
+            for (std::size_t b = 0; m >= firstBatchMethod && b < batches.size(); ++b) {
+                int vertexID = geometry.vertexID(queries[b * batchSize].vertexIndex);
+                if (m == firstBatchMethod) {
+                    std::vector<bool> overlaps = overlapHappensBatch(vertexID, batches[b], graph);
+                    for (std::size_t c = 0; c < overlaps.size(); ++c) actual[b * batchSize + c] = overlaps[c];
+                    sink.str("");
+                    continue;
+                }
+                boost::dynamic_bitset<> overlaps = (m == firstBatchMethod + 1) ? overlapBatch(vertexID, Span<Coord2>(batches[b]), graph)
+                                                                               : overlapBatch(geometry, vertexID, Span<Coord2>(batches[b]));
+                for (std::size_t c = 0; c < overlaps.size(); ++c) actual[b * batchSize + c] = overlaps[c];
+            }
+            for (std::size_t q = 0; m < firstBatchMethod && q < queries.size(); ++q) {
+                const Query& query = queries[q];
+                int vertexID = geometry.vertexID(query.vertexIndex);
+                switch (m) {
+                    case 0:
+                        actual[q] = overlapHappens(vertexID, query.pos, graph);
+                        break;
+                    case 1:
+                        actual[q] = overlapHappensOptimized(vertexID, query.pos, graph, &spatialGrid);
+                        break;
+                    case 2:
+                        actual[q] = overlapKernel(geometry, query.vertexIndex, query.pos.x(), query.pos.y());
+                        break;
+                    case 3:
+                        actual[q] = overlapKernel(geometry, query.vertexIndex, query.pos.x(), query.pos.y(), &reports[q]);
+                        break;
+                    default:
+                        actual[q] = overlapKernel(indexedGeometry, query.vertexIndex, query.pos.x(), query.pos.y());
+                }
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+            std::cout.rdbuf(quietBuf);
+            methods[m].ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            methods[m].allocations += allocationNum - allocationsBefore;
+            sink.str("");
+
+            if (m != 0) {
+                for (std::size_t q = 0; q < queries.size(); ++q) {
+                    bool kindMatches = (m != 3) || !expected[q] || expectedKind[q] == overlapKindName(reports[q].kind);
+                    if (actual[q] != expected[q] || !kindMatches) {
+                        if (++mismatchNum <= 10) {
+                            std::cout << file << ": vertex " << geometry.vertexID(queries[q].vertexIndex) << " at ("
+                                      << queries[q].pos.x() << ", " << queries[q].pos.y() << ") " << methods[m].name
+                                      << " " << static_cast<int>(actual[q]) << ", overlapHappens " << static_cast<int>(expected[q])
+                                      << " (" << expectedKind[q] << ")" << std::endl;
+                        }
+                    }
+                }
+            }
+        }
+        for (char overlap : expected) overlapNum += overlap;
+        queryNum += queries.size();
+    }
+
+    if (queryNum == 0) {
+        std::cout << "No maps in " << inputDir << std::endl;
+        return 1;
+    }
+    std::cout << "Maps: " << files.size() << ", queries: " << queryNum << ", overlapping: " << overlapNum << std::endl;
+    std::cout << std::left << std::setw(28) << "method" << std::right << std::setw(14) << "ns/position"
+              << std::setw(14) << "allocs/pos." << std::setw(12) << "speedup" << std::endl;
+    std::cout << std::fixed;
+    for (const Method& method : methods) {
+        std::cout << std::left << std::setw(28) << method.name << std::right << std::setprecision(1)
+                  << std::setw(14) << method.ns / queryNum << std::setprecision(2)
+                  << std::setw(14) << static_cast<double>(method.allocations) / queryNum << std::setprecision(1)
+                  << std::setw(11) << methods[0].ns / std::max(method.ns, 1.0) << "x" << std::endl;
+    }
+    std::cout << "Mismatches against overlapHappens: " << mismatchNum << std::endl;
+    return mismatchNum == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+//------------------------------------------------------------------------------
+// AxisLineIndex.h - Sorted index of the line positions on one axis
+//------------------------------------------------------------------------------
+
+#ifndef _Map_AxisLineIndex_H
+#define _Map_AxisLineIndex_H
+
+#include <vector>
+#include <utility>
+
+namespace Map {
+
+    // Line positions of one axis (y of horizontal lines or x of vertical lines) kept
+    // sorted in one contiguous array, with O(log L) queries. Queries return the line's
+    // index in the array the index was built from, and resolve ties the way a linear
+    // scan over that array with a strict '<' does: the lowest index wins.
+    class AxisLineIndex {
+    private:
+        std::vector<double>     sortedPositions;
+        std::vector<int>        lineIndices;        // original index of every sorted slot
+
+        // Nearest line given the first slot with position >= p
+        int nearestFrom(int upper, double p, double& distance) const;
+
+    public:
+        AxisLineIndex( void ) {}
+        explicit AxisLineIndex(const std::vector<double>& positions);
+
+        int     size()                  const { return static_cast<int>(sortedPositions.size()); }
+        bool    empty()                 const { return sortedPositions.empty(); }
+        double  position(int slot)      const { return sortedPositions[slot]; }
+        int     lineIndex(int slot)     const { return lineIndices[slot]; }
+
+        // Closest line, -1 if there are no lines
+        int nearest(double p) const;
+
+        // Closest line with |position - p| <= tolerance, -1 if none
+        int nearestWithin(double p, double tolerance) const;
+
+        // Lowest-index line with |position - p| < tolerance (strict), -1 if none
+        int firstWithin(double p, double tolerance) const;
+
+        // Sorted slots [first, last) of the lines with lo <= position <= hi
+        std::pair<int, int> range(double lo, double hi) const;
+
+        // Number of lines strictly below / above p
+        int countBelow(double p) const;
+        int countAbove(double p) const;
+
+        // Batch versions over a whole coordinate array, O(n log L)
+        std::vector<int> nearestWithin(const std::vector<double>& coords, double tolerance) const;
+        std::vector<int> firstWithin(const std::vector<double>& coords, double tolerance) const;
+    };
+
+} // namespace Map
+
+#endif // _Map_AxisLineIndex_H
@@ -0,0 +1,63 @@
+//------------------------------------------------------------------------------
+// ChainContraction.h - Degree-2 chain contraction around the solve stages
+//------------------------------------------------------------------------------
+
+#ifndef _Map_ChainContraction_H
+#define _Map_ChainContraction_H
+
+#include <vector>
+#include <string>
+#include "BaseUGraphProperty.h"
+#include "MapSubproblem.h"
+
+namespace Map {
+
+    // A run of degree-2 vertices replaced by one super-edge source - target
+    struct ContractedChain {
+        unsigned int                sourceID;       // kept endpoint
+        unsigned int                targetID;       // kept endpoint
+        std::vector<unsigned int>   innerIDs;       // contracted vertices, source to target
+        std::vector<unsigned int>   edgeIDs;        // original edges along the run (innerIDs.size() + 1)
+        std::vector<double>         fractions;      // arc-length position of each inner vertex in (0, 1)
+        unsigned int                superEdgeID;    // edge ID in the reduced problem
+    };
+
+    struct ContractionResult {
+        std::vector<ContractedChain>    chains;
+        std::vector<int>                reducedEdge2Original;   // original edge ID, -1 for super-edges
+        int                             contractedVertexNum = 0;
+    };
+
+    // Contract maximal degree-2 chains into super-edges. A chain is cut into runs whose
+    // inner vertices stay within maxDeviation of the run's chord, so a super-edge
+    // keeps the chain's geometry; runs that would duplicate an existing edge or close
+    // a cycle are kept as they are. Fills reduced with the kept vertices (original IDs)
+    // and the plain + super edges. Returns 0 on success, -1 on failure.
+    int contractDegree2Chains(
+        const std::vector<BaseEdgeProperty>& edgeList,
+        const BaseUGraphProperty& graph,
+        MapSubproblem& reduced,
+        ContractionResult& contraction,
+        double maxDeviation);
+
+    // Copy the solved positions of the kept vertices back, place contracted vertices
+    // on their super-edge by arc-length fraction and give every chain edge the
+    // orientation flags of its super-edge
+    void expandDegree2Chains(
+        const MapSubproblem& reduced,
+        const ContractionResult& contraction,
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph);
+
+    // contract -> optimizeEdgeOrientation + optimizeVertexAlignment on the reduced
+    // problem -> expand. Returns 0 on success, the failing stage's code otherwise.
+    int optimizeWithChainContraction(
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph,
+        const std::string& testCaseName = "");
+
+} // namespace Map
+
+#endif // _Map_ChainContraction_H
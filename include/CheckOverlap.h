@@ -3,6 +3,11 @@
 #include "BaseEdgeProperty.h"
 #include "BaseUGraphProperty.h"
 #include "SpatialGrid.h"
+#include "LineMemberPool.h"     // Span
+#include "OverlapPredicates.h"
+#include <vector>
+#include <unordered_map>
+#include <boost/dynamic_bitset.hpp>
 
 namespace Map {
 
@@ -12,23 +17,126 @@ namespace Map {
 
     bool EEOverlap(const BaseEdgeProperty& edge_1, const BaseEdgeProperty& edge_2);
 
-    // 原始实现（O(V*E)复杂度）
-    bool overlapHappens(int vertexID, const Coord2& newPos, const BaseUGraphProperty& graph);
+    // 原始实现（O(V*E)复杂度）; now overlapKernel on a geometry gathered from the graph per
+    // call. Silent unless printReport, which prints the overlap found (printOverlapReport).
+    bool overlapHappens(int vertexID, const Coord2& newPos, const BaseUGraphProperty& graph, bool printReport = false);
+
+    // overlapHappens for several candidate positions of one vertex: overlapBatch (graph) as a
+    // std::vector<bool>; result i equals overlapHappens(vertexID, newPositions[i], graph)
+    std::vector<bool> overlapHappensBatch(int vertexID, const std::vector<Coord2>& newPositions,
+                                          const BaseUGraphProperty& graph);
 
     /**
      * @brief 优化的重叠检查函数（使用空间网格加速）
      * @param vertexID 要移动的顶点ID
      * @param newPos 新位置
      * @param graph 图结构
-     * @param spatialGrid 空间网格索引（如果为nullptr则自动创建）
+     * @param spatialGrid 空间网格索引（按顶点/边ID；为nullptr时等同于 overlapHappens）
+     * @param printReport 同 overlapHappens：默认不输出，为 true 时打印找到的重叠
      * @return 是否发生重叠
      * 
+     * 从网格中收集 newPos 附近及各出边沿线的顶点和边，在这个局部几何上运行 overlapKernel。
      * 时间复杂度：O(k) 其中k是局部邻域的元素数量，通常 k << V+E
-     * 相比原始实现的 O(V*E) 有显著提升
      */
     bool overlapHappensOptimized(int vertexID, const Coord2& newPos, 
                                   const BaseUGraphProperty& graph,
-                                  SpatialGrid* spatialGrid = nullptr);
+                                  SpatialGrid* spatialGrid = nullptr, bool printReport = false);
+
+    // The checks of overlapHappens, numbered as there
+    enum OverlapKind {
+        NO_OVERLAP = 0,
+        VERTEX_ON_VERTEX,       // 1:   the vertex lands on another vertex
+        VERTEX_ON_EDGE,         // 2.1: the vertex lands inside an edge
+        EDGE_THROUGH_VERTEX,    // 2.2: one of its edges runs through an unrelated vertex
+        EDGE_ALONG_EDGE,        // 3.1: one of its edges runs along another edge
+        EDGES_FOLDED            // 3.2: two of its own edges run along each other
+    };
+
+
+    // What overlapKernel found, for callers that want to know why instead of a log
+    struct OverlapReport {
+        OverlapKind     kind;
+        int             vertexID;           // the moved vertex
+        Coord2          pos;                // its tested position
+        int             otherVertexID;      // VERTEX_ON_VERTEX, EDGE_THROUGH_VERTEX; else -1
+        int             edgeID;             // its edge: EDGE_THROUGH_VERTEX, EDGE_ALONG_EDGE, EDGES_FOLDED; else -1
+        int             otherEdgeID;        // VERTEX_ON_EDGE, EDGE_ALONG_EDGE, EDGES_FOLDED; else -1
+        Coord2          otherPos;           // position of otherVertexID
+        Coord2          segmentStart;       // the segment hit: otherEdgeID, or edgeID for EDGE_THROUGH_VERTEX
+        Coord2          segmentEnd;
+    };
+
+    const char* overlapKindName(OverlapKind kind);
+
+    // The report as the former overlapHappens log: what was hit, then "<kind name> happens"
+    void printOverlapReport(const OverlapReport& report);
+
+    // Flat copy of the graph geometry for overlapKernel: vertex coordinates by index, edges as
+    // index pairs in their Source() / Target() order with their SegmentAxis, and the edges of
+    // every vertex (CSR). Build it once per layout; after moving a vertex in the graph, mirror
+    // it with setCoord.
+    class OverlapGeometry {
+    private:
+        std::vector<double>             xs, ys;
+        std::vector<int>                vertexIDs;
+        std::vector<int>                sources, targets;
+        std::vector<int>                edgeIDs;
+        std::vector<SegmentAxis>        axes;               // of every edge, kept up to date by setCoord
+        std::vector<int>                incidentOffsets;    // edges of vertex i: [offsets[i], offsets[i + 1])
+        std::vector<int>                incidentEdges;
+        std::unordered_map<int, int>    vertexIndex;
+        SpatialGrid                     spatialIndex;       // vertex and edge indices, once buildSpatialIndex ran
+        bool                            indexed = false;
+
+        void    clear( void );
+        void    addVertex(const BaseVertexProperty& vertex);
+        void    addEdge(const BaseEdgeProperty& edge);
+        void    linkIncidentEdges( void );
+
+        template <class Elements>
+        friend bool overlapKernelOn(const OverlapGeometry& geometry, const Elements& elements, int vertexIndex,
+                                    double x, double y, OverlapReport* report);
+        friend bool overlapKernel(const OverlapGeometry& geometry, int vertexIndex, double x, double y,
+                                  OverlapReport* report);
+        friend boost::dynamic_bitset<> overlapBatch(const OverlapGeometry& geometry, int vertexID,
+                                                    Span<Coord2> candidates);
+
+    public:
+        void    build(const BaseUGraphProperty& graph);
+        // Only the given vertices and edges, plus the endpoints of those edges
+        void    build(const BaseUGraphProperty& graph, Span<int> vertexIDs, Span<int> edgeIDs);
+
+        // Index the vertices and edges in a SpatialGrid of cellSize, kept current by setCoord.
+        // overlapKernel then only tests what lies in the cells around the moved vertex and
+        // along its edges, so a check costs the local density instead of O(V + E).
+        void    buildSpatialIndex(double cellSize);
+        bool    hasSpatialIndex()       const { return indexed; }
+
+        int     vertexNum()             const { return static_cast<int>(xs.size()); }
+        int     edgeNum()               const { return static_cast<int>(sources.size()); }
+        int     indexOf(int vertexID)   const;  // -1 if absent
+        int     vertexID(int index)     const { return vertexIDs[index]; }
+        Coord2  coord(int index)        const { return Coord2(xs[index], ys[index]); }
+
+        void    setCoord(int index, double x, double y);
+    };
+
+    // overlapHappens for the vertex at index vertexIndex moved to (x, y), on the flat geometry:
+    // no output and no allocation. With a report, the first overlap found (in the order of
+    // overlapHappens) is described there; report->kind is NO_OVERLAP if there is none.
+    // Local to the spatial index of the geometry if it has one, else over all of it.
+    bool overlapKernel(const OverlapGeometry& geometry, int vertexIndex, double x, double y,
+                       OverlapReport* report = nullptr);
+
+    // overlapKernel for several candidate positions of one vertex: bit c is set if moving
+    // vertexID to candidates[c] overlaps. The vertices and edges that can interact with any
+    // candidate (those near the box of the candidates and the vertex's neighbors) are
+    // gathered once into flat arrays, and every candidate is tested against them in
+    // branch-free loops over the candidates.
+    boost::dynamic_bitset<> overlapBatch(const OverlapGeometry& geometry, int vertexID, Span<Coord2> candidates);
+
+    // The same, gathering straight from the graph; equals overlapHappens on every candidate
+    boost::dynamic_bitset<> overlapBatch(int vertexID, Span<Coord2> candidates, const BaseUGraphProperty& graph);
 }
 
 #endif // _Map_CheckOverlap_H
\ No newline at end of file
@@ -0,0 +1,55 @@
+//------------------------------------------------------------------------------
+// Clustering1D.h - Exact optimal k-means clustering of 1D data
+//------------------------------------------------------------------------------
+
+#ifndef _Map_Clustering1D_H
+#define _Map_Clustering1D_H
+
+#include <vector>
+#include "ThreadPool.h"
+
+namespace Map {
+
+    // Ckmeans.1d.dp-style dynamic program over sorted values. In 1D the optimal clusters
+    // are contiguous runs of the sorted input, so
+    //     D[k][i] = min_j D[k-1][j-1] + cost(j, i)
+    // with cost from prefix sums in O(1). The optimal split j is monotone in i, so every
+    // row is filled by divide and conquer in O(n log n). The constructor computes the
+    // optimal WCSS for all k = 1..maxK keeping only two rows; getCenters(k) reruns the
+    // first k rows with split points to recover the clusters.
+    // With a pool, the two halves left after each row's top-level splits are filled as
+    // parallel tasks; every cell is computed the same way, so results don't depend on it.
+    class Clustering1D {
+    private:
+        std::vector<double>     values;         // sorted, shifted by the median for stability
+        double                  shift;
+        std::vector<double>     prefix1;        // prefix sums of values
+        std::vector<double>     prefix2;        // prefix sums of squared values
+        std::vector<double>     optimalWCSS;    // index k, [0] unused
+        int                     maxK;
+        ThreadPool*             pool;           // nullptr: sequential
+
+        // Sum of squared deviations of values[j..i] from their mean
+        double cost(int j, int i) const;
+
+        // cur[i] for i in [lo, hi], optimal split searched in [optLo, optHi]
+        void fillRow(const std::vector<double>& prev, std::vector<double>& cur, std::vector<int>* split,
+                     int k, int lo, int hi, int optLo, int optHi, int depth) const;
+
+        // Rows 1..k; splits[k'] is filled if splits is not null
+        void solveRows(int k, std::vector<double>& last, std::vector<std::vector<int>>* splits) const;
+
+    public:
+        // sortedValues must be ascending; maxK is clamped to the number of values
+        Clustering1D(const std::vector<double>& sortedValues, int maxK, ThreadPool* pool = nullptr);
+
+        int                 getMaxK()           const { return maxK; }
+        double              getWCSS(int k)      const { return optimalWCSS[k]; }
+
+        // Cluster means of the optimal k-clustering, ascending
+        std::vector<double> getCenters(int k)   const;
+    };
+
+} // namespace Map
+
+#endif // _Map_Clustering1D_H
@@ -13,10 +13,39 @@ namespace Map {
     // Global mapping from vertex ID to vertex descriptor
     // This map is built once and used throughout the application
     extern std::map<int, boost::graph_traits<BaseUGraphProperty>::vertex_descriptor> vertexID2Desc;
+
+    // Global mapping from edge ID to edge descriptor
+    extern std::map<int, boost::graph_traits<BaseUGraphProperty>::edge_descriptor> edgeID2Desc;
     
     // Helper function to get vertex descriptor by ID
     boost::graph_traits<BaseUGraphProperty>::vertex_descriptor getVertexDescriptor(int vertexID);
+
+    // Helper function to get edge descriptor by ID
+    boost::graph_traits<BaseUGraphProperty>::edge_descriptor getEdgeDescriptor(int edgeID);
+
+    // ID -> descriptor maps of one graph, for stages running on a subproblem
+    struct DescriptorMapping {
+        std::map<int, boost::graph_traits<BaseUGraphProperty>::vertex_descriptor>  vertexID2Desc;
+        std::map<int, boost::graph_traits<BaseUGraphProperty>::edge_descriptor>    edgeID2Desc;
+    };
+
+    DescriptorMapping buildDescriptorMapping(const BaseUGraphProperty& graph);
+
+    // While alive, getVertexDescriptor / getEdgeDescriptor on the calling thread resolve
+    // IDs through the given mapping instead of the global maps. Scopes nest, so a pool
+    // thread that picks up another subproblem's task while waiting restores its own.
+    class ScopedDescriptorMapping {
+    private:
+        const DescriptorMapping*    previous;
+
+    public:
+        explicit ScopedDescriptorMapping(const DescriptorMapping& mapping);
+        ~ScopedDescriptorMapping();
+
+        ScopedDescriptorMapping(const ScopedDescriptorMapping&) = delete;
+        ScopedDescriptorMapping& operator = (const ScopedDescriptorMapping&) = delete;
+    };
     
 } // namespace Map
 
-#endif // _Map_Commons_H
\ No newline at end of file
+#endif // _Map_Commons_H
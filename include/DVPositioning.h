@@ -9,9 +9,15 @@
 #include "BaseUGraphProperty.h"
 #include "DynamicGrid.h"
 #include "Coord2.h"
+#include "ThreadPool.h"
 
 namespace Map {
 
+    enum DVPositioningMethod {
+        GREEDY_ADJACENT_LINES = 0,  // per vertex in degree order, onto an adjacent line; a new line if none fits
+        MIN_COST_ASSIGNMENT = 1     // all vertices at once onto nearby free intersections, leftovers greedily
+    };
+
     std::vector<int> findDVs(const DynamicGrid& grid, const BaseUGraphProperty& graph);
     
 
@@ -19,8 +25,10 @@ namespace Map {
     bool isOnVAL(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph);
     
     std::vector<AuxiliaryLine> getAdjHALs(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph);
+    std::vector<AuxiliaryLine> getAdjHALs(int vertexID, const Coord2& pos, const DynamicGrid& grid, const BaseUGraphProperty& graph);
     
     std::vector<AuxiliaryLine> getAdjVALs(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph);
+    std::vector<AuxiliaryLine> getAdjVALs(int vertexID, const Coord2& pos, const DynamicGrid& grid, const BaseUGraphProperty& graph);
     
     // Note: overlapHappens is declared in CheckOverlap.h
     
@@ -29,6 +37,21 @@ namespace Map {
 
     void processPDV(int vertexID, DynamicGrid& grid, BaseUGraphProperty& graph);
     void processFDV(int vertexID, DynamicGrid& grid, BaseUGraphProperty& graph);
+
+    // One greedy pass over the dangling vertices in the given order: the partially aligned
+    // ones, or (fullyDangling) the fully dangling ones. With a pool of more than one thread,
+    // batches are planned in parallel against the same layout and committed in order; a plan
+    // that read anything an earlier commit changed (vertices, edges, occupancy or lines in
+    // its footprint) is redone, so the result equals the sequential pass.
+    // Returns the number of vertices processed.
+    int positionDanglingPass(const std::vector<int>& danglingVertices, bool fullyDangling,
+                             DynamicGrid& grid, BaseUGraphProperty& graph, ThreadPool* pool = nullptr);
+
+    // Move dangling vertices onto free line intersections within a radius by one min-cost
+    // assignment (squared displacement). Chosen moves are overlap-checked lazily; rejected
+    // pairs are excluded and the rest re-assigned. Needs the grid's occupancy table.
+    // Returns the number of vertices moved.
+    int assignDanglingVertices(DynamicGrid& grid, BaseUGraphProperty& graph);
     
     // Main function for dangling vertex positioning
     // Returns the number of modified vertices on success, -1 on failure
@@ -12,6 +12,10 @@
 #include <cmath>
 #include "BaseUGraphProperty.h"
 #include "Coord2.h"
+#include "AxisLineIndex.h"
+#include "LineMemberPool.h"
+#include "IndexedHeap.h"
+#include "GridOccupancy.h"
 
 namespace Map {
 
@@ -19,35 +23,59 @@ namespace Map {
     struct AuxiliaryLine {
 
     private:
-        double              position;       // x-coordinate for vertical line, y-coordinate for horizontal line
-        bool                isHorizontal;   // true for horizontal line, false for vertical line        
-        int                 voteCount;      // number of vertices that "vote" for this line
-        std::vector<int>    vertexIDs;      // IDs of vertices on this line
+        double                  position;       // x-coordinate for vertical line, y-coordinate for horizontal line
+        bool                    isHorizontal;   // true for horizontal line, false for vertical line        
+        int                     voteCount;      // number of vertices that "vote" for this line
+        const LineMemberPool*   memberPool;     // IDs of vertices on this line, owned by the grid (nullptr: none)
+        int                     memberList;     // list handle in memberPool
 
     public:
-        AuxiliaryLine() {}
+        AuxiliaryLine(): position(0.0), isHorizontal(true), voteCount(0), memberPool(nullptr), memberList(-1) {}
 
         AuxiliaryLine(double pos, bool isH, int vc = 0): 
-            position(pos), isHorizontal(isH), voteCount(vc) {}
+            position(pos), isHorizontal(isH), voteCount(vc), memberPool(nullptr), memberList(-1) {}
 
-        void setPosition(double pos)                { position = pos; }
-        void setVoteCount(int vc)                   { voteCount = vc; }
-        void setVertexIDs(std::vector<int> vids)    { vertexIDs = vids; }
+        void setPosition(double pos)                                { position = pos; }
+        void setVoteCount(int vc)                                   { voteCount = vc; }
+        void setMembers(const LineMemberPool* pool, int list)       { memberPool = pool; memberList = list; }
 
         double              getPosition() const { return position; }
         bool                getIsHorizontal() const { return isHorizontal; }
         int                 getVoteCount() const { return voteCount; }
-        std::vector<int>    getVertexIDs() const { return vertexIDs; }
-
-        AuxiliaryLine& operator = (const AuxiliaryLine& line) {
-            if (this != &line){
-                this->position = line.position;
-                this->isHorizontal = line.isHorizontal;
-                this->voteCount = line.voteCount;
-                this->vertexIDs = line.vertexIDs;
-            }
-            return *this;
-        }
+        int                 getMemberList() const { return memberList; }
+
+        // View into the grid's pool; valid until the grid's memberships change
+        Span<int>           getVertexIDs() const { return memberPool ? memberPool->members(memberList) : Span<int>(); }
+    };
+
+    // Intersection of a horizontal and a vertical line (by handle)
+    struct GridIntersection {
+        int         hLine;
+        int         vLine;
+        Coord2      pos;
+        double      distance;       // from the query position
+    };
+
+    // Running statistics of the members of one line, kept up to date as vertices move so the
+    // line's key score never needs a rebuild. "along" is the member coordinate along the line
+    // (x on a horizontal line, y on a vertical one).
+    struct AuxLineStats {
+        bool    isHorizontal;
+        bool    pinned;         // added during DV positioning; never elected away
+        int     count;          // members
+        int     extraDegree;    // sum over the members of max(0, degree - 2)
+        double  sum;            // sum of along
+        double  sumSq;          // sum of along^2
+
+        AuxLineStats(bool isH = true, bool pinned = false):
+            isHorizontal(isH), pinned(pinned), count(0), extraDegree(0), sum(0.0), sumSq(0.0) {}
+
+        void    add(double along, int degree)       { ++count; extraDegree += std::max(0, degree - 2); sum += along; sumSq += along * along; }
+        void    remove(double along, int degree)    { --count; extraDegree -= std::max(0, degree - 2); sum -= along; sumSq -= along * along; }
+        void    merge(const AuxLineStats& other);
+
+        // Standard deviation of along, 0 for fewer than two members
+        double  spread( void ) const;
     };
 
     // Main class for managing dynamic grid of auxiliary lines
@@ -55,40 +83,140 @@ namespace Map {
     private:
         std::vector<AuxiliaryLine> horizontalAuxLines;  // horizontal auxiliary lines
         std::vector<AuxiliaryLine> verticalAuxLines;    // vertical auxiliary lines
+        LineMemberPool             memberPool;          // vertex IDs of all lines of both axes
+
+        // Key line election: stats and heap are indexed by the line's member list handle,
+        // which stays fixed while the line vectors are sorted; the heap holds the live lines
+        std::vector<AuxLineStats>  lineStats;
+        IndexedMinHeap             electionHeap;        // lowest score on top
+
+        // Line intersection of every vertex, within MEMBERSHIP_EPSILON; filled by the build and
+        // rebuild, kept up to date by moveVertex, line inserts and election, dropped by a merge
+        GridOccupancy              occupancy;
+        bool                       occupancyValid;
         
         // Parameters for line selection
         double  tolerance;          // tolerance distance for vertex alignment
         double  minVoteThreshold;   // minimum votes required for a line to be considered "key"
 
+        // Position indices of the lines, rebuilt on the first query after a change
+        mutable AxisLineIndex   hIndex;
+        mutable AxisLineIndex   vIndex;
+        mutable std::vector<int> handleSlot;    // line handle -> index in its axis vector, -1 if gone
+        mutable bool            indexValid;
+
         // Helper functions
         void sortAuxLines();
+        void invalidateLineIndex() { indexValid = false; }
+        void bindMemberPool();          // point every line at this grid's memberPool
+        double lineScore(const AuxLineStats& stats) const;
+        void rescoreLine(int list)  { electionHeap.update(list, lineScore(lineStats[list])); }
+        int createLine(AuxiliaryLine& line, Span<int> ids, const AuxLineStats& stats);
+        int insertAuxLine(double position, bool isHorizontal);
+        std::vector<int> insertAuxLines(const std::vector<double>& positions, bool isHorizontal);
+        void refreshLineIndex() const;
+        void placeVertex(int vertexID, const Coord2& pos);
+        void attachVerticesToLines(bool isHorizontal);     // after inserting lines of one axis
         
     public:
         // Constructor
         DynamicGrid();
         DynamicGrid(double tolerance = 2.315, double minVotes = 2.0);
+        DynamicGrid(const DynamicGrid& other);
+        DynamicGrid& operator = (const DynamicGrid& other);
         
         // Core functionality
         void buildAuxLines(const BaseUGraphProperty& graphProp);
+
+        // Drop every line whose key score is below minVoteThreshold + 1: one member more than
+        // building the line took (3 for the usual 2 votes), so setMinVote moves both. The score
+        // combines the members, their spread along the line and their degree beyond 2; it is
+        // maintained by the build, merge, rebuild and moveVertex, so re-electing costs
+        // O(k log L) for k dropped lines. Lines added with addHorizontalAuxLine /
+        // addVerticalAuxLine are kept.
         void electKeyAuxLines();
+
+        // Keep the memberships and scores up to date after a vertex moved from oldPos to newPos:
+        // it leaves its old lines and joins the first lines within 1e-2 of its new position, as
+        // rebuildVertexLineMappings would assign it
+        void moveVertex(int vertexID, const Coord2& oldPos, const Coord2& newPos, int degree);
+        double getLineScore(const AuxiliaryLine& line) const;
         
         // Getters
+        // Lines read their vertex IDs from this grid, so copies of them are only valid while it lives
         const std::vector<AuxiliaryLine>& getHorizontalAuxLines() const { return horizontalAuxLines; }
         const std::vector<AuxiliaryLine>& getVerticalAuxLines() const { return verticalAuxLines; }
         
         std::vector<double> getHALPositions() const;
         std::vector<double> getVALPositions() const;
+
+        // Sorted indices over the line positions; query results are indices into
+        // getHorizontalAuxLines() / getVerticalAuxLines()
+        const AxisLineIndex& getHALIndex() const;
+        const AxisLineIndex& getVALIndex() const;
         
         // Information queries
         int getKeyAuxLineCount() const;
 
+        // Intersection occupancy, O(1); only meaningful while hasOccupancy() (after a build or
+        // rebuildVertexLineMappings, until the next merge). Lines are given by handle.
+        bool hasOccupancy() const { return occupancyValid; }
+        int  horizontalLineOf(int vertexID) const { return occupancy.hLine(vertexID); }
+        int  verticalLineOf(int vertexID) const { return occupancy.vLine(vertexID); }
+        bool isOnIntersection(int vertexID) const { return occupancy.isOnIntersection(vertexID); }
+        bool isIntersectionFree(int hLine, int vLine, int ignoreVertexID = -1) const {
+            return occupancy.isFree(hLine, vLine, ignoreVertexID);
+        }
+
+        // Dangling vertices (off every intersection), maintained with the occupancy. The list
+        // is ordered by descending degree, ties in graph vertex order.
+        bool isDangling(int vertexID) const { return occupancy.isDangling(vertexID); }
+        int  getDanglingCount() const { return occupancy.danglingCount(); }
+        std::vector<int> getDanglingVertices() const { return occupancy.danglingVertices(); }
+
+        // Is a dangling vertex within tolerance of the column x (row y) strictly between lo and hi
+        // along it? O(log n) on ordered per-column / per-row indexes kept with the occupancy.
+        bool danglingInColumn(double x, double lo, double hi, double tolerance) const {
+            return occupancy.danglingInColumn(x, lo, hi, tolerance);
+        }
+        bool danglingInRow(double y, double lo, double hi, double tolerance) const {
+            return occupancy.danglingInRow(y, lo, hi, tolerance);
+        }
+
+        // Up to k free intersections (no vertex but ignoreVertexID on them) nearest to pos,
+        // in ascending distance, none farther than maxDistance. Best-first over the lines of
+        // both axes ordered by distance from pos; stops after k results or maxProbes
+        // intersections looked at. Without the occupancy every intersection counts as free.
+        std::vector<GridIntersection> nearestFreeIntersections(const Coord2& pos, int k, double maxDistance,
+                                                               int ignoreVertexID = -1, int maxProbes = 64) const;
+
         // Configuration
         void setTolerance(double tolerance) { this->tolerance = tolerance; }
-        void setMinVote(double threshold) { this->minVoteThreshold = threshold; }
-
-        // Dynamic line addition
-        void addHorizontalAuxLine(double position);
-        void addVerticalAuxLine(double position);
+        void setMinVote(double threshold) { this->minVoteThreshold = threshold; }     // build and election, see electKeyAuxLines
+
+        // Stable handle of a line; it survives inserts, merges, sorting and election of other
+        // lines, whereas positions in getHorizontalAuxLines() / getVerticalAuxLines() shift
+        static int lineHandle(const AuxiliaryLine& line) { return line.getMemberList(); }
+
+        // Current index of a line in its axis vector, -1 if it has been elected away
+        int findLine(int handle) const;
+
+        // Dynamic line addition, kept in position order with a binary search (no re-sort).
+        // Returns the handle of the new line, or of the line already at that position.
+        int addHorizontalAuxLine(double position);
+        int addVerticalAuxLine(double position);
+
+        // Batch addition: positions are sorted and deduplicated once and merged into the
+        // lines in a single pass, O(L + k log k). Returns the handles in input order.
+        std::vector<int> addHorizontalAuxLines(const std::vector<double>& positions);
+        std::vector<int> addVerticalAuxLines(const std::vector<double>& positions);
+
+        // Fold the lines of another grid (e.g. one tile's grid) into this one. A line within
+        // tolerance of an existing line on the same axis is merged into it (vote-weighted
+        // position, votes and vertex IDs summed), any other line is inserted in order.
+        // A vertex already on the existing line (e.g. from the overlap of two tiles) is
+        // counted once; the stats are then approximate until rebuildVertexLineMappings.
+        void mergeAuxLines(const DynamicGrid& other);
         
         // Update auxiliary line positions (for spacing optimization)
         void updateHorizontalLinePositions(const std::vector<double>& newPositions);
@@ -5,17 +5,46 @@
 #ifndef _Map_EdgeOrientation_H
 #define _Map_EdgeOrientation_H
 
+#include <cstdint>
 #include "BaseUGraphProperty.h"
+#include "IndexedAdjacency.h"
+#include "ThreadPool.h"
 
 namespace Map {
     
+    // Greedy anti-overlap marking of edges to be oriented vertically / horizontally.
+    // Vertices are visited by descending degree; states are -1: unprocessed,
+    // 0: explicitly not aligned, 1: aligned. Both state arrays are indexed by edge ID
+    // and must be initialized to -1. Runs in O(V + E).
+    void markEdgeOrientations(
+        const IndexedAdjacency& adj,
+        const std::vector<BaseEdgeProperty>& edgeList,
+        std::vector<std::int8_t>& edgeOriented2V,
+        std::vector<std::int8_t>& edgeOriented2H);
+
+    // Parallel variant of markEdgeOrientations. Vertices are split into distance-2 color
+    // classes (greedy coloring in degree order); classes run one after another and the
+    // vertices of a class run concurrently in degree order. The result is deterministic
+    // for any thread count, but generally differs from the sequential marking since
+    // vertices are no longer visited in pure degree order.
+    void markEdgeOrientationsParallel(
+        const IndexedAdjacency& adj,
+        const std::vector<BaseEdgeProperty>& edgeList,
+        std::vector<std::int8_t>& edgeOriented2V,
+        std::vector<std::int8_t>& edgeOriented2H,
+        ThreadPool& pool);
+
     // Main function for edge orientation optimization
+    // fixedVertices (indexed like vertexList): vertices with a non-zero entry keep their
+    // coordinates, for windows of a larger map whose border belongs to the rest of it;
+    // edges between two fixed vertices are not oriented
     // Returns 0 on success, -1 on failure
     int optimizeEdgeOrientation(
         std::vector<BaseVertexProperty>& vertexList, 
         std::vector<BaseEdgeProperty>& edgeList, 
         BaseUGraphProperty& graph,
-        const std::string& testCaseName = "");
+        const std::string& testCaseName = "",
+        const std::vector<char>* fixedVertices = nullptr);
 
 } // namespace Map
 
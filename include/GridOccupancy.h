@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+// GridOccupancy.h - Which auxiliary line intersection every vertex sits on
+//------------------------------------------------------------------------------
+
+#ifndef _Map_GridOccupancy_H
+#define _Map_GridOccupancy_H
+
+#include <unordered_map>
+#include <map>
+#include <set>
+#include <vector>
+#include <cstdint>
+#include "Coord2.h"
+
+namespace Map {
+
+    // Per vertex, the handle of the horizontal and of the vertical line it lies on (-1: none),
+    // and per intersection (hLine, vLine) the number of vertices on it. Keyed by line handles,
+    // so inserting lines or moving them keeps the entries valid. All queries are O(1).
+    // A vertex off every intersection is dangling; the dangling set follows every update in
+    // O(1) and is listed in a fixed priority order (setPriority) without sorting. Dangling
+    // vertices are also bucketed by exact x (columns) and y (rows), each bucket ordered by
+    // the other coordinate, for O(log n) "is a dangling vertex in between" queries.
+    class GridOccupancy {
+    private:
+        struct Cell {
+            Coord2  pos;
+            int     hLine;
+            int     vLine;
+        };
+
+        std::unordered_map<int, Cell>               cells;      // vertex ID -> cell
+        std::unordered_map<std::uint64_t, int>      counts;     // packed (hLine, vLine) -> vertices
+        std::vector<int>                            priority;   // vertex IDs in dangling processing order
+        int                                         danglingNum;
+
+        typedef std::map<double, std::set<std::pair<double, int>>> AxisBuckets;
+        AxisBuckets                                 danglingColumns;    // x -> (y, vertex ID)
+        AxisBuckets                                 danglingRows;       // y -> (x, vertex ID)
+
+        static std::uint64_t key(int hLine, int vLine) {
+            return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(hLine)) << 32) | static_cast<std::uint32_t>(vLine);
+        }
+        void count(int vertexID, const Cell& cell, int delta);
+        static void bucket(AxisBuckets& buckets, double key, double order, int vertexID, int delta);
+        static bool anyBetween(const AxisBuckets& buckets, double key, double tolerance, double lo, double hi);
+
+    public:
+        GridOccupancy( void ): danglingNum(0) {}
+
+        void    clear( void );
+        bool    empty( void ) const { return cells.empty(); }
+
+        // Record the vertex at pos on the given lines, replacing its previous cell
+        void    place(int vertexID, const Coord2& pos, int hLine, int vLine);
+        // Change only the line of one axis
+        void    setLine(int vertexID, bool isHorizontal, int line);
+
+        int     hLine(int vertexID) const;
+        int     vLine(int vertexID) const;
+        bool    isOnIntersection(int vertexID) const;
+
+        bool    isDangling(int vertexID) const { return !isOnIntersection(vertexID); }
+        int     danglingCount( void ) const { return danglingNum; }
+
+        // Order in which danglingVertices() lists vertices (e.g. by descending degree)
+        void    setPriority(const std::vector<int>& vertexIDs) { priority = vertexIDs; }
+        // Dangling vertices in priority order, O(V)
+        std::vector<int> danglingVertices( void ) const;
+
+        // Is there a dangling vertex with |x - column| < tolerance and lo < y < hi
+        // (open interval, empty unless lo < hi), or the same within a row?
+        bool    danglingInColumn(double column, double lo, double hi, double tolerance) const;
+        bool    danglingInRow(double row, double lo, double hi, double tolerance) const;
+
+        int     occupants(int hLine, int vLine) const;
+        // True if no vertex other than ignoreVertexID sits on the intersection
+        bool    isFree(int hLine, int vLine, int ignoreVertexID = -1) const;
+
+        // f(vertexID, pos, hLine, vLine) for every vertex
+        template <typename F>
+        void forEach(F f) const {
+            for (const auto& pair : cells) {
+                f(pair.first, pair.second.pos, pair.second.hLine, pair.second.vLine);
+            }
+        }
+    };
+
+} // namespace Map
+
+#endif // _Map_GridOccupancy_H
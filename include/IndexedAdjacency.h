@@ -0,0 +1,46 @@
+//------------------------------------------------------------------------------
+// IndexedAdjacency.h - Compact index-based adjacency of a BaseUGraphProperty
+//------------------------------------------------------------------------------
+
+#ifndef _Map_IndexedAdjacency_H
+#define _Map_IndexedAdjacency_H
+
+#include <vector>
+#include "BaseUGraphProperty.h"
+
+namespace Map {
+
+    // CSR (compressed sparse row) snapshot of the graph topology.
+    // Vertices are numbered 0..V-1 in vertices(graph) order, which is the same
+    // order used to fill vertexList. The incident edges of vertex v are
+    // edgeIDs[offsets[v] .. offsets[v+1]) in out_edges(v, graph) order, and
+    // neighbors[k] is the vertex on the other end of edgeIDs[k].
+    // !!! listS descriptors can't be advanced in O(1), use vertexDescs instead
+    struct IndexedAdjacency {
+        std::vector<BaseUGraphProperty::vertex_descriptor>  vertexDescs;
+        std::vector<int>                                    offsets;
+        std::vector<int>                                    edgeIDs;
+        std::vector<int>                                    neighbors;
+
+        int vertexCount()   const { return static_cast<int>(vertexDescs.size()); }
+        int degree(int v)   const { return offsets[v + 1] - offsets[v]; }
+        int begin(int v)    const { return offsets[v]; }
+        int end(int v)      const { return offsets[v + 1]; }
+    };
+
+    // Build the CSR snapshot in O(V + E)
+    IndexedAdjacency buildIndexedAdjacency(const BaseUGraphProperty& graph);
+
+    // Vertex indices ordered by degree (descending), ties kept in vertex order.
+    // Counting sort, O(V + maxDegree).
+    std::vector<int> sortVerticesByDegree(const IndexedAdjacency& adj);
+
+    // Greedy distance-2 coloring: vertices visited in the given order get the smallest
+    // color not used within two hops, so two vertices of the same color share neither
+    // an edge nor a neighbor. Returns the color of every vertex; colorNum is set to the
+    // number of colors used. O(sum of deg^2).
+    std::vector<int> colorDistance2(const IndexedAdjacency& adj, const std::vector<int>& order, int& colorNum);
+
+} // namespace Map
+
+#endif // _Map_IndexedAdjacency_H
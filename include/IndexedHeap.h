@@ -0,0 +1,43 @@
+//------------------------------------------------------------------------------
+// IndexedHeap.h - Binary min-heap over integer IDs with key updates
+//------------------------------------------------------------------------------
+
+#ifndef _Map_IndexedHeap_H
+#define _Map_IndexedHeap_H
+
+#include <vector>
+
+namespace Map {
+
+    // Min-heap of IDs 0..n-1 keyed by double. Every ID is in the heap at most once and
+    // its slot is tracked, so update() and erase() are O(log n) instead of a rebuild.
+    // Equal keys pop the lower ID first.
+    class IndexedMinHeap {
+    private:
+        std::vector<int>        heap;       // IDs in heap order
+        std::vector<int>        slot;       // ID -> position in heap, -1 if absent
+        std::vector<double>     keys;       // ID -> key
+
+        bool less(int a, int b) const;
+        void siftUp(int i);
+        void siftDown(int i);
+        void place(int i, int id);
+
+    public:
+        bool    empty( void )       const { return heap.empty(); }
+        int     size( void )        const { return static_cast<int>(heap.size()); }
+        bool    contains(int id)    const { return id >= 0 && id < static_cast<int>(slot.size()) && slot[id] >= 0; }
+        int     top( void )         const { return heap.front(); }
+        double  topKey( void )      const { return keys[heap.front()]; }
+        double  key(int id)         const { return keys[id]; }
+
+        // Insert id or change its key
+        void    update(int id, double key);
+        void    erase(int id);
+        int     pop( void );
+        void    clear( void );
+    };
+
+} // namespace Map
+
+#endif // _Map_IndexedHeap_H
@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+// LineMemberPool.h - Shared CSR-style storage of auxiliary line members
+//------------------------------------------------------------------------------
+
+#ifndef _Map_LineMemberPool_H
+#define _Map_LineMemberPool_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Map {
+
+    // Read-only view of a contiguous range; valid until the storage it points into changes
+    template <typename T>
+    class Span {
+    private:
+        const T*    first;
+        const T*    last;
+
+    public:
+        Span( void ): first(nullptr), last(nullptr) {}
+        Span(const T* first, const T* last): first(first), last(last) {}
+        Span(const std::vector<T>& values): first(values.data()), last(values.data() + values.size()) {}
+
+        const T*        begin()                         const { return first; }
+        const T*        end()                           const { return last; }
+        std::size_t     size()                          const { return static_cast<std::size_t>(last - first); }
+        bool            empty()                         const { return first == last; }
+        const T&        operator [] (std::size_t i)     const { return first[i]; }
+
+        std::vector<T> toVector() const { return std::vector<T>(first, last); }
+    };
+
+    // Member lists of many lines in one array. Every list owns a slab [offset, offset + capacity)
+    // of which the first size entries are used. Appending to a full slab moves the list to the
+    // end of the array with doubled capacity (amortized O(1)); the abandoned slabs are reclaimed
+    // by compacting once they make up half of the array. Clearing a list keeps its slab, so
+    // refilling lists of similar size does not allocate. The slot of every (list, id) is kept
+    // in a hash map, so an id is found in its list in O(1); ids are unique within a list.
+    // !!! members() spans are invalidated by any append that relocates or compacts
+    class LineMemberPool {
+    private:
+        struct Slab {
+            int     offset;
+            int     size;
+            int     capacity;
+        };
+
+        std::vector<int>    data;
+        std::vector<Slab>   slabs;
+        int                 deadNum;        // entries of abandoned slabs
+        std::unordered_map<std::uint64_t, int>  slots;      // (list, id) -> slot in the list
+
+        static std::uint64_t slotKey(int list, int id) {
+            return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(list)) << 32) | static_cast<std::uint32_t>(id);
+        }
+
+        void relocate(int list, int minCapacity);
+        void compact( void );
+
+    public:
+        LineMemberPool( void ): deadNum(0) {}
+
+        // New list with room for capacity members, returns its handle
+        int createList(int capacity = 0);
+        int createList(Span<int> ids);
+
+        void append(int list, int id);
+        void append(int list, Span<int> ids);
+
+        // Swap-with-last removal: O(1) amortized, does not keep the member order.
+        // remove() looks the slot of id up; false if absent.
+        void removeAt(int list, int slot);
+        bool remove(int list, int id);
+
+        // O(size) to forget the slots of the members
+        void clearList(int list);
+        void clear( void );
+
+        // Slot of id in list, -1 if absent
+        int         slotOf(int list, int id) const;
+
+        Span<int>   members(int list)       const;
+        int         size(int list)          const { return slabs[list].size; }
+        int         listCount( void )       const { return static_cast<int>(slabs.size()); }
+    };
+
+} // namespace Map
+
+#endif // _Map_LineMemberPool_H
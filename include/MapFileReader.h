@@ -52,6 +52,9 @@ namespace Map {
     // Build global vertex ID to descriptor mapping
     void buildVertexMapping(const BaseUGraphProperty& graph);
 
+    // Build global edge ID to descriptor mapping
+    void buildEdgeMapping(const BaseUGraphProperty& graph);
+
     // Graph building functions
     bool readMapFileToGraph(const std::string& filename, std::vector<BaseVertexProperty>& vertices, std::vector<BaseEdgeProperty>& edges, BaseUGraphProperty& graph);
 } // namespace Map
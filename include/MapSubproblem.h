@@ -0,0 +1,60 @@
+//------------------------------------------------------------------------------
+// MapSubproblem.h - Self-contained reduced copy of a map for the solve stages
+//------------------------------------------------------------------------------
+
+#ifndef _Map_MapSubproblem_H
+#define _Map_MapSubproblem_H
+
+#include <vector>
+#include <map>
+#include <utility>
+#include "BaseVertexProperty.h"
+#include "BaseEdgeProperty.h"
+#include "BaseUGraphProperty.h"
+
+namespace Map {
+
+    // Owns vertexList / edgeList / graph of a reduced problem so that
+    // optimizeEdgeOrientation() and optimizeVertexAlignment() can run on it unchanged.
+    // Vertex IDs are kept from the original map, edge IDs are renumbered 0..E-1
+    // because the stages index edgeList by edge ID.
+    // !!! edgeList and graph reference the vertices in place, so the object is not copyable
+    class MapSubproblem {
+    private:
+        std::vector<BaseVertexProperty>     vertexList;
+        std::vector<BaseEdgeProperty>       edgeList;
+        BaseUGraphProperty                  graph;
+
+    public:
+        MapSubproblem( void ) {}
+        MapSubproblem(const MapSubproblem&) = delete;
+        MapSubproblem& operator = (const MapSubproblem&) = delete;
+
+        // vertices are copied, edges are given as (source ID, target ID) pairs and get
+        // ID = position in edgeEnds. Returns false if an endpoint ID is unknown.
+        bool build(
+            const std::vector<BaseVertexProperty>& vertices,
+            const std::vector<std::pair<unsigned int, unsigned int>>& edgeEnds);
+
+        // Point the global ID -> descriptor maps (vertexID2Desc, edgeID2Desc) at this graph.
+        // Call buildVertexMapping / buildEdgeMapping on the original graph when done.
+        void activate( void ) const;
+
+        // Coordinates of all vertices by ID
+        std::map<unsigned int, Coord2> coordinates( void ) const;
+
+        std::vector<BaseVertexProperty>&        VertexList()        { return vertexList; }
+        std::vector<BaseEdgeProperty>&          EdgeList()          { return edgeList; }
+        BaseUGraphProperty&                     Graph()             { return graph; }
+        const std::vector<BaseVertexProperty>&  VertexList()  const { return vertexList; }
+        const std::vector<BaseEdgeProperty>&    EdgeList()    const { return edgeList; }
+        const BaseUGraphProperty&               Graph()       const { return graph; }
+    };
+
+    // Recompute the angle of every graph edge and its edgeList entry from the
+    // current vertex coordinates (edge ID = index in edgeList)
+    void updateEdgeAngles(std::vector<BaseEdgeProperty>& edgeList, BaseUGraphProperty& graph);
+
+} // namespace Map
+
+#endif // _Map_MapSubproblem_H
@@ -0,0 +1,45 @@
+//------------------------------------------------------------------------------
+// MinCostFlow.h - Min-cost flow by successive shortest paths
+//------------------------------------------------------------------------------
+
+#ifndef _Map_MinCostFlow_H
+#define _Map_MinCostFlow_H
+
+#include <vector>
+
+namespace Map {
+
+    // Directed network with integer capacities and non-negative arc costs. solve() augments
+    // along shortest paths (Dijkstra on potential-reduced costs), so the flow it returns has
+    // the least cost among all flows of that value; with unit capacities this is a min-cost
+    // maximum matching.
+    class MinCostFlow {
+    private:
+        struct Arc {
+            int     to;
+            int     capacity;       // residual
+            double  cost;
+        };
+
+        std::vector<Arc>                arcs;       // arc 2k and its reverse 2k + 1
+        std::vector<std::vector<int>>   outArcs;    // node -> arc IDs
+
+    public:
+        explicit MinCostFlow(int nodeNum = 0): outArcs(nodeNum) {}
+
+        int     nodeNum( void ) const { return static_cast<int>(outArcs.size()); }
+        int     addNode( void ) { outArcs.emplace_back(); return nodeNum() - 1; }
+
+        // Returns the arc ID for flow()
+        int     addArc(int from, int to, int capacity, double cost);
+
+        // Push up to maxFlow units from source to sink; returns the flow sent and its cost
+        int     solve(int source, int sink, int maxFlow, double& totalCost);
+
+        // Flow on an arc added with addArc
+        int     flow(int arc) const { return arcs[arc ^ 1].capacity; }
+    };
+
+} // namespace Map
+
+#endif // _Map_MinCostFlow_H
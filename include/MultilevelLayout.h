@@ -0,0 +1,40 @@
+//------------------------------------------------------------------------------
+// MultilevelLayout.h - Coarsen / solve / refine driver for very large maps
+//------------------------------------------------------------------------------
+
+#ifndef _Map_MultilevelLayout_H
+#define _Map_MultilevelLayout_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include "BaseUGraphProperty.h"
+
+namespace Map {
+
+    // One level of the hierarchy. Level 0 is the input map (vertexList order),
+    // every coarser level merges matched vertex pairs of the level below.
+    struct CoarseLevel {
+        std::vector<BaseVertexProperty>     vertices;   // representative ID, centroid of the members
+        std::vector<std::pair<int, int>>    edges;      // vertex indices, no duplicates / self loops
+        std::vector<Coord2>                 positions;  // layout being built for this level
+        std::vector<int>                    parent;     // index in the next coarser level
+    };
+
+    // Heavy-edge matching on edge length: every vertex is merged with its closest
+    // unmatched neighbor. Returns the next coarser level and fills fine.parent.
+    CoarseLevel coarsenLevel(CoarseLevel& fine);
+
+    // Coarsen -> optimizeEdgeOrientation + optimizeVertexAlignment on the coarsest
+    // level -> uncoarsen level by level, re-running both stages on small windows
+    // (core vertices + pinned one-ring halo) against lines detected once per level.
+    // Returns 0 on success, the failing stage's code otherwise.
+    int optimizeMultilevel(
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph,
+        const std::string& testCaseName = "");
+
+} // namespace Map
+
+#endif // _Map_MultilevelLayout_H
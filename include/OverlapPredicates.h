@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+// OverlapPredicates.h - Overlap predicates on raw coordinates, with axis-aligned fast paths
+//------------------------------------------------------------------------------
+
+#ifndef _Map_OverlapPredicates_H
+#define _Map_OverlapPredicates_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace Map {
+
+    const double OVERLAP_EPSILON = 1e-3;
+
+    // Exactly axis-parallel segments, for which the predicates reduce to 1D tests.
+    // Oriented2H / Oriented2V are not enough: they hold within the solver's tolerance and
+    // go stale when vertices move, and the reductions are exact only on equal coordinates.
+    enum SegmentAxis {
+        AXIS_GENERIC = 0,
+        AXIS_HORIZONTAL,        // y_A == y_B
+        AXIS_VERTICAL           // x_A == x_B, and not horizontal
+    };
+
+    inline SegmentAxis segmentAxis(double x_A, double y_A, double x_B, double y_B) {
+        return y_A == y_B ? AXIS_HORIZONTAL : (x_A == x_B ? AXIS_VERTICAL : AXIS_GENERIC);
+    }
+
+    inline bool isCollinear(double x, double y, double x_A, double y_A, double x_B, double y_B) {
+        double cross_product = (y - y_A) * (x_B - x_A) - (x - x_A) * (y_B - y_A);
+        return std::abs(cross_product) < OVERLAP_EPSILON;
+    }
+
+    inline bool pointsOverlap(double x_P, double y_P, double x_Q, double y_Q) {
+        return (std::abs(x_P - x_Q) < OVERLAP_EPSILON) && (std::abs(y_P - y_Q) < OVERLAP_EPSILON);
+    }
+
+    //------------------------------------------------------------------------------
+    //  P strictly inside segment AB (VEOverlap)
+    //------------------------------------------------------------------------------
+
+    // Generic: collinear within OVERLAP_EPSILON, then strictly inside the range on x, or on y
+    // for a (nearly) vertical segment
+    template <SegmentAxis Axis>
+    inline bool pointInsideSegment(double x_P, double y_P, double x_A, double y_A, double x_B, double y_B) {
+        if (isCollinear(x_P, y_P, x_A, y_A, x_B, y_B)) {
+            if (std::abs(x_A - x_B) < OVERLAP_EPSILON) { // vertical line
+                return (y_P > std::min(y_A, y_B)) && (y_P < std::max(y_A, y_B));
+            }
+            else {
+                return (x_P > std::min(x_A, x_B)) && (x_P < std::max(x_A, x_B));
+            }
+        }
+        else {
+            return false;
+        }
+    }
+
+    // The fast paths are branch-free (&, not &&) so that loops over many points vectorize.
+
+    // y_A == y_B: the cross product is (y_P - y_A) * (x_B - x_A), and a segment too short
+    // for the x range is tested on its empty y range
+    template <>
+    inline bool pointInsideSegment<AXIS_HORIZONTAL>(double x_P, double y_P, double x_A, double y_A, double x_B, double /* y_B */) {
+        return (x_P > std::min(x_A, x_B)) & (x_P < std::max(x_A, x_B)) &
+               (std::abs(x_A - x_B) >= OVERLAP_EPSILON) & (std::abs((y_P - y_A) * (x_B - x_A)) < OVERLAP_EPSILON);
+    }
+
+    // x_A == x_B: the cross product is -(x_P - x_A) * (y_B - y_A), tested on the y range
+    template <>
+    inline bool pointInsideSegment<AXIS_VERTICAL>(double x_P, double y_P, double x_A, double y_A, double /* x_B */, double y_B) {
+        return (y_P > std::min(y_A, y_B)) & (y_P < std::max(y_A, y_B)) &
+               (std::abs((x_P - x_A) * (y_B - y_A)) < OVERLAP_EPSILON);
+    }
+
+    inline bool pointInsideSegment(SegmentAxis axis, double x_P, double y_P, double x_A, double y_A, double x_B, double y_B) {
+        switch (axis) {
+            case AXIS_HORIZONTAL:   return pointInsideSegment<AXIS_HORIZONTAL>(x_P, y_P, x_A, y_A, x_B, y_B);
+            case AXIS_VERTICAL:     return pointInsideSegment<AXIS_VERTICAL>(x_P, y_P, x_A, y_A, x_B, y_B);
+            default:                return pointInsideSegment<AXIS_GENERIC>(x_P, y_P, x_A, y_A, x_B, y_B);
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    //  CD along AB (EEOverlap); Axis is that of AB
+    //------------------------------------------------------------------------------
+
+    // Generic: C and D collinear with AB, then the open ranges overlap on x, or on y for a
+    // (nearly) vertical AB
+    template <SegmentAxis Axis>
+    inline bool segmentsOverlap(double x_A, double y_A, double x_B, double y_B,
+                                double x_C, double y_C, double x_D, double y_D) {
+        if (isCollinear(x_C, y_C, x_A, y_A, x_B, y_B) && isCollinear(x_D, y_D, x_A, y_A, x_B, y_B)) {
+            if (std::abs(x_A - x_B) < OVERLAP_EPSILON) {
+                // A, B, C, D are on the same vertical line.
+                double a = std::min(y_A, y_B);
+                double b = std::max(y_A, y_B);
+                double c = std::min(y_C, y_D);
+                double d = std::max(y_C, y_D);
+                return !(c >= b || d <= a);
+            }
+            else {
+                double a = std::min(x_A, x_B);
+                double b = std::max(x_A, x_B);
+                double c = std::min(x_C, x_D);
+                double d = std::max(x_C, x_D);
+                return !(c >= b || d <= a);
+            }
+        }
+        else {
+            return false;
+        }
+    }
+
+    // Only the axis of AB matters: its delta is what the collinearity tests of C and D
+    // multiply by, so CD of any direction (H-H, H-V, ...) reduces the same way.
+
+    // AB horizontal: C and D against y_A alone, on the x range; an AB shorter than
+    // OVERLAP_EPSILON is taken as vertical, so CD has to cross y_A instead
+    template <>
+    inline bool segmentsOverlap<AXIS_HORIZONTAL>(double x_A, double y_A, double x_B, double /* y_B */,
+                                                 double x_C, double y_C, double x_D, double y_D) {
+        const bool point = std::abs(x_A - x_B) < OVERLAP_EPSILON;
+        const double a = point ? y_A : std::min(x_A, x_B);
+        const double b = point ? y_A : std::max(x_A, x_B);
+        const double c = point ? std::min(y_C, y_D) : std::min(x_C, x_D);
+        const double d = point ? std::max(y_C, y_D) : std::max(x_C, x_D);
+        return (c < b) & (d > a) &
+               (std::abs((y_C - y_A) * (x_B - x_A)) < OVERLAP_EPSILON) & (std::abs((y_D - y_A) * (x_B - x_A)) < OVERLAP_EPSILON);
+    }
+
+    // AB vertical: C and D against x_A alone, on the y range
+    template <>
+    inline bool segmentsOverlap<AXIS_VERTICAL>(double x_A, double y_A, double /* x_B */, double y_B,
+                                               double x_C, double y_C, double x_D, double y_D) {
+        return (std::min(y_C, y_D) < std::max(y_A, y_B)) & (std::max(y_C, y_D) > std::min(y_A, y_B)) &
+               (std::abs((x_C - x_A) * (y_B - y_A)) < OVERLAP_EPSILON) & (std::abs((x_D - x_A) * (y_B - y_A)) < OVERLAP_EPSILON);
+    }
+
+    inline bool segmentsOverlap(SegmentAxis axisAB, double x_A, double y_A, double x_B, double y_B,
+                                double x_C, double y_C, double x_D, double y_D) {
+        switch (axisAB) {
+            case AXIS_HORIZONTAL:   return segmentsOverlap<AXIS_HORIZONTAL>(x_A, y_A, x_B, y_B, x_C, y_C, x_D, y_D);
+            case AXIS_VERTICAL:     return segmentsOverlap<AXIS_VERTICAL>(x_A, y_A, x_B, y_B, x_C, y_C, x_D, y_D);
+            default:                return segmentsOverlap<AXIS_GENERIC>(x_A, y_A, x_B, y_B, x_C, y_C, x_D, y_D);
+        }
+    }
+
+} // namespace Map
+
+#endif // _Map_OverlapPredicates_H
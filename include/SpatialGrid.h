@@ -9,6 +9,8 @@
 #include <unordered_set>
 #include <vector>
 #include <functional>
+#include <cmath>
+#include <limits>
 
 namespace Map {
 
@@ -69,6 +71,49 @@ public:
      */
     std::vector<int> getEdgesAlongLine(const Coord2& start, const Coord2& end) const;
 
+    /**
+     * @brief 不分配内存的遍历：对 pos 周围 radius 格内的每个非空单元调用 f(vertexIDs, edgeIDs)，
+     *        f 返回 true 时停止并返回 true（同一条边可能在多个单元中被访问）
+     */
+    template <class F>
+    bool forEachCellNear(const Coord2& pos, int radius, F f) const;
+
+    /**
+     * @brief 同上，遍历线段经过的单元及其 radius 格邻域（radius = 1 即 getVerticesAlongLine / getEdgesAlongLine
+     *        的范围；边插入时已扩展到8邻域，只找边时 radius = 0 即可），单元本身也可能被访问多次
+     */
+    template <class F>
+    bool forEachCellAlongLine(const Coord2& start, const Coord2& end, int radius, F f) const;
+
+    /**
+     * @brief 向网格中插入顶点（不需要图时也可直接用索引作为ID构建）
+     */
+    void insertVertex(int vertexID, const Coord2& pos);
+
+    /**
+     * @brief 向网格中插入边（会插入到线段覆盖的所有网格单元）
+     */
+    void insertEdge(int edgeID, const Coord2& start, const Coord2& end);
+
+    /**
+     * @brief 增量更新：将顶点从旧位置移到新位置
+     * @param vertexID 顶点ID
+     * @param oldPos 插入时的位置
+     * @param newPos 新位置
+     */
+    void moveVertex(int vertexID, const Coord2& oldPos, const Coord2& newPos);
+
+    /**
+     * @brief 增量更新：将边从旧线段移到新线段
+     * @param edgeID 边ID
+     * @param oldStart 插入时的起点
+     * @param oldEnd 插入时的终点
+     * @param newStart 新起点
+     * @param newEnd 新终点
+     */
+    void moveEdge(int edgeID, const Coord2& oldStart, const Coord2& oldEnd,
+                  const Coord2& newStart, const Coord2& newEnd);
+
     /**
      * @brief 设置网格单元大小
      * @param cellSize 新的网格单元大小
@@ -108,17 +153,19 @@ private:
     GridKey worldToGrid(double x, double y) const;
 
     /**
-     * @brief 向网格中插入顶点
+     * @brief 从网格中删除顶点 / 边（位置须与插入时一致）
      */
-    void insertVertex(int vertexID, const Coord2& pos);
+    void removeVertex(int vertexID, const Coord2& pos);
+    void removeEdge(int edgeID, const Coord2& start, const Coord2& end);
 
     /**
-     * @brief 向网格中插入边（会插入到线段覆盖的所有网格单元）
+     * @brief 逐格遍历线段真正经过的所有单元（Amanatides-Woo），对每个单元调用 f(GridKey)，返回 true 时停止
      */
-    void insertEdge(int edgeID, const Coord2& start, const Coord2& end);
+    template <class F>
+    bool forEachPathCell(const Coord2& start, const Coord2& end, F f) const;
 
     /**
-     * @brief 获取线段经过的所有网格单元（Bresenham-like算法）
+     * @brief 获取线段经过的所有网格单元及其8邻域（精确遍历，结果保守）
      */
     std::vector<GridKey> getGridCellsAlongLine(const Coord2& start, const Coord2& end) const;
 
@@ -132,6 +179,67 @@ private:
     std::unordered_map<GridKey, GridCell, GridKeyHash> m_grid;  // 空间网格
 };
 
+template <class F>
+bool SpatialGrid::forEachCellNear(const Coord2& pos, int radius, F f) const {
+    GridKey center = worldToGrid(pos);
+    for (int dx = -radius; dx <= radius; ++dx) {
+        for (int dy = -radius; dy <= radius; ++dy) {
+            auto it = m_grid.find({center.first + dx, center.second + dy});
+            if (it != m_grid.end() && f(it->second.vertexIDs, it->second.edgeIDs)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+template <class F>
+bool SpatialGrid::forEachCellAlongLine(const Coord2& start, const Coord2& end, int radius, F f) const {
+    return forEachPathCell(start, end, [this, radius, &f](const GridKey& cell) {
+        for (int ox = -radius; ox <= radius; ++ox) {
+            for (int oy = -radius; oy <= radius; ++oy) {
+                auto it = m_grid.find({cell.first + ox, cell.second + oy});
+                if (it != m_grid.end() && f(it->second.vertexIDs, it->second.edgeIDs)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    });
+}
+
+template <class F>
+bool SpatialGrid::forEachPathCell(const Coord2& start, const Coord2& end, F f) const {
+    GridKey cell = worldToGrid(start);
+    GridKey endCell = worldToGrid(end);
+
+    double dx = end.x() - start.x();
+    double dy = end.y() - start.y();
+    int stepX = (dx > 0) ? 1 : ((dx < 0) ? -1 : 0);
+    int stepY = (dy > 0) ? 1 : ((dy < 0) ? -1 : 0);
+    const double inf = std::numeric_limits<double>::infinity();
+    double tMaxX = (stepX != 0) ? ((cell.first + (stepX > 0 ? 1 : 0)) * m_cellSize - start.x()) / dx : inf;
+    double tMaxY = (stepY != 0) ? ((cell.second + (stepY > 0 ? 1 : 0)) * m_cellSize - start.y()) / dy : inf;
+    double tDeltaX = (stepX != 0) ? m_cellSize / std::abs(dx) : inf;
+    double tDeltaY = (stepY != 0) ? m_cellSize / std::abs(dy) : inf;
+
+    if (f(cell)) return true;
+    int steps = std::abs(endCell.first - cell.first) + std::abs(endCell.second - cell.second);
+    for (int i = 0; i < steps; ++i) {
+        if (tMaxX < tMaxY) {
+            cell.first += stepX;
+            tMaxX += tDeltaX;
+        }
+        else {
+            cell.second += stepY;
+            tMaxY += tDeltaY;
+        }
+        if (f(cell)) return true;
+    }
+    // 浮点误差可能使遍历偏离一格，终点单元总是加入
+    return cell != endCell && f(endCell);
+}
+
 } // namespace Map
 
 #endif // _Map_SpatialGrid_H
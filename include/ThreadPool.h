@@ -0,0 +1,58 @@
+//------------------------------------------------------------------------------
+// ThreadPool.h - Shared worker pool for data-parallel loops
+//------------------------------------------------------------------------------
+
+#ifndef _Map_ThreadPool_H
+#define _Map_ThreadPool_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Map {
+
+    class ThreadPool {
+    private:
+        std::vector<std::thread>            workers;
+        std::deque<std::function<void()>>   tasks;
+        std::mutex                          queueMutex;
+        std::condition_variable             queueCV;
+        bool                                stopping;
+
+        void workerLoop();
+
+    public:
+        // numWorkers < 0: one worker less than the hardware concurrency, since the
+        // calling thread always takes part in run(). numWorkers = 0 runs everything inline.
+        explicit ThreadPool(int numWorkers = -1);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator = (const ThreadPool&) = delete;
+
+        // Pool shared by all optimization stages
+        static ThreadPool& shared();
+
+        // Number of threads taking part in run(), including the caller
+        unsigned int concurrency() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+        // Pop and execute one queued task on the calling thread.
+        // Returns false if the queue was empty.
+        bool runPendingTask();
+
+        // Execute all jobs and block until they are done. The calling thread
+        // executes queued tasks while waiting, so nested calls don't deadlock.
+        // The first exception thrown by a job is rethrown here.
+        void run(std::vector<std::function<void()>>& jobs);
+
+        // body(i) for every i in [begin, end), split into at most concurrency() chunks
+        // of at least minChunk iterations
+        void parallelFor(int begin, int end, const std::function<void(int)>& body, int minChunk = 1);
+    };
+
+} // namespace Map
+
+#endif // _Map_ThreadPool_H
@@ -0,0 +1,54 @@
+//------------------------------------------------------------------------------
+// TiledLayout.h - Overlapping spatial tiles solved in parallel, then stitched
+//------------------------------------------------------------------------------
+
+#ifndef _Map_TiledLayout_H
+#define _Map_TiledLayout_H
+
+#include <vector>
+#include <string>
+#include "BaseUGraphProperty.h"
+#include "DynamicGrid.h"
+
+namespace Map {
+
+    struct TileConfig {
+        double  tileSize = 2000.0;          // edge length of a tile core (map units)
+        double  overlap = 200.0;            // margin added to every side of a core; also the seam band width
+        double  gridTolerance = 2.315;      // DynamicGrid parameters of the per-tile grids
+        double  gridMinVotes = 2.0;
+        double  minSpacing = 10.0;          // uniformAuxLineSpacing minimum spacing
+    };
+
+    // Per-tile line of the scaling report
+    struct TileReport {
+        int     tileIndex;
+        int     coreVertexNum;              // vertices whose result is taken from this tile
+        int     vertexNum;                  // core + overlap vertices solved
+        int     edgeNum;
+        double  solveMs;
+        int     result;
+    };
+
+    // Cut the plane into tileSize x tileSize cores, extend each by overlap and run the
+    // pipeline (EdgeOrientation, VertexAlignment, DynamicGrid, DVPositioning) on every
+    // tile in parallel on ThreadPool::shared(). Each vertex
+    // takes the position from the tile whose core contains it. The tile grids are merged
+    // into grid and every vertex is snapped onto the merged lines unless that overlaps.
+    // Vertices within overlap of an inner tile border are then re-solved together
+    // (EdgeOrientation + VertexAlignment on the merged lines), with their neighbors
+    // pinned in place as context. Edges whose ends share no tile join that pass with
+    // both ends pinned, so their orientation is solved too. AuxLineSpacing then runs once on the merged grid.
+    // Prints a scaling report.
+    // Returns 0 on success, the first failing stage's code otherwise.
+    int optimizeTiled(
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph,
+        DynamicGrid& grid,
+        const TileConfig& config,
+        const std::string& testCaseName = "");
+
+} // namespace Map
+
+#endif // _Map_TiledLayout_H
@@ -5,22 +5,58 @@
 #ifndef _Map_VertexAlignment_H
 #define _Map_VertexAlignment_H
 
+#include <vector>
+#include <string>
 #include "BaseUGraphProperty.h"
 
 namespace Map {
 
     enum AlignmentMethod {
         CLUSTERING_BASED = 0,   // Two-phase: clustering + optimization
-        MIXED_INTEGER = 1       // MILP approach (reserved for future)
+        MIXED_INTEGER = 1       // Joint MILP vertex-to-line assignment, overlaps excluded by lazy constraints
     };
     
+    // Forced coordinate of one vertex (Phase 3 equality constraint)
+    struct AxisConstraint {
+        int     vertexIdx;      // index in vertexList
+        bool    isHorizontal;   // true: Y == value, false: X == value
+        double  value;
+    };
+
+    // Closed-form Phase 3 solve. Without coupling constraints the QP
+    //     min sum_i w_i * ((X_i - x_i)^2 + (Y_i - y_i)^2)
+    //     s.t. forced equalities, x_min <= X_i <= x_max, y_min <= Y_i <= y_max
+    // separates into one problem per coordinate, so its optimum is the projection of the
+    // current coordinates onto the constraints: forced coordinates take their value, all
+    // others keep theirs (clamped to the box), whatever the weights. O(V + C).
+    // Returns false and leaves X / Y untouched if the constraints are inconsistent (two
+    // values for one coordinate or a value outside the box).
+    bool solveAlignmentProjection(
+        const std::vector<BaseVertexProperty>& vertexList,
+        const std::vector<AxisConstraint>& constraints,
+        double x_min, double x_max, double y_min, double y_max,
+        std::vector<double>& X,
+        std::vector<double>& Y);
+
+    // Phase 1 line detection: centers of the optimal 1D clustering of coords (y values for
+    // horizontal lines, x values for vertical ones); optimalK receives their number
+    std::vector<double> clusterCoordinates1D(const std::vector<double>& coords, int& optimalK);
+
     // Main function for vertex alignment optimization
+    // For windows of a larger map:
+    //   fixedVertices (indexed like vertexList): vertices with a non-zero entry keep their
+    //   coordinates; they are not aligned but still count in the overlap checks
+    //   sharedHLines / sharedVLines: lines detected once for the whole map, used instead of
+    //   Phase 1 so that neighboring windows align to the same lines
     // Returns 0 on success, -1 on failure
     int optimizeVertexAlignment(
         std::vector<BaseVertexProperty>& vertexList, 
         std::vector<BaseEdgeProperty>& edgeList, 
         BaseUGraphProperty& graph,
-        const std::string& testCaseName = "");
+        const std::string& testCaseName = "",
+        const std::vector<char>* fixedVertices = nullptr,
+        const std::vector<double>* sharedHLines = nullptr,
+        const std::vector<double>* sharedVLines = nullptr);
 
 } // namespace Map
 
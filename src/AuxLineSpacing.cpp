@@ -21,7 +21,8 @@ namespace Map {
         std::vector<AuxiliaryLine>& auxLines,
         bool isHorizontal,
         double minSpacing,
-        std::vector<double>& newPositions) {
+        std::vector<double>& newPositions,
+        const std::string& testCaseName) {
         
         int lineCount = auxLines.size();
         
@@ -67,9 +68,12 @@ namespace Map {
         }
         
         try {
+            // Log and IIS files per run and direction, so concurrent layouts do not share them
+            const std::string fileName = "output/" + testCaseName + (isHorizontal ? "_h" : "_v") + "_auxline_spacing";
+            
             // Create Gurobi environment and model
             GRBEnv env(true);
-            env.set("LogFile", "auxline_spacing_opt.log");
+            env.set("LogFile", fileName + "_opt.log");
             env.set(GRB_IntParam_OutputFlag, 0);  // Suppress output
             env.start();
             GRBModel model(env);
@@ -131,7 +135,7 @@ namespace Map {
             } else if (status == GRB_INFEASIBLE) {
                 std::cerr << "Model is infeasible!" << std::endl;
                 model.computeIIS();
-                model.write("auxline_spacing_infeasible.ilp");
+                model.write(fileName + "_infeasible.ilp");
                 return -1;
             } else {
                 std::cerr << "Optimization ended with status " << status << std::endl;
@@ -175,7 +179,7 @@ namespace Map {
         // ==================== Step 1: Optimize Horizontal Auxiliary Lines ====================
         std::vector<double> newHorizontalPositions;
         if (horizontalLines.size() >= 2) {
-            int result = optimizeLineSpacing(horizontalLines, true, minSpacing, newHorizontalPositions);
+            int result = optimizeLineSpacing(horizontalLines, true, minSpacing, newHorizontalPositions, testCaseName);
             if (result != 0) {
                 std::cerr << "Failed to optimize horizontal line spacing!" << std::endl;
                 return -1;
@@ -234,7 +238,7 @@ namespace Map {
         // ==================== Step 2: Optimize Vertical Auxiliary Lines ====================
         std::vector<double> newVerticalPositions;
         if (verticalLines.size() >= 2) {
-            int result = optimizeLineSpacing(verticalLines, false, minSpacing, newVerticalPositions);
+            int result = optimizeLineSpacing(verticalLines, false, minSpacing, newVerticalPositions, testCaseName);
             if (result != 0) {
                 std::cerr << "Failed to optimize vertical line spacing!" << std::endl;
                 return -1;
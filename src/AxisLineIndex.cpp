@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------------
+// AxisLineIndex.cpp - Sorted index of the line positions on one axis
+//------------------------------------------------------------------------------
+
+#include "AxisLineIndex.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace Map {
+
+    AxisLineIndex::AxisLineIndex(const std::vector<double>& positions) {
+        lineIndices.resize(positions.size());
+        std::iota(lineIndices.begin(), lineIndices.end(), 0);
+        // stable: equal positions stay in index order, so a run starts with its lowest index
+        std::stable_sort(lineIndices.begin(), lineIndices.end(),
+            [&positions](int a, int b) { return positions[a] < positions[b]; });
+
+        sortedPositions.reserve(positions.size());
+        for (int idx : lineIndices) {
+            sortedPositions.push_back(positions[idx]);
+        }
+    }
+
+    int AxisLineIndex::nearestFrom(int upper, double p, double& distance) const {
+        int best = -1;
+        if (upper < size()) {
+            best = upper;
+            distance = sortedPositions[upper] - p;
+        }
+        if (upper > 0) {
+            // first slot of the run of equal positions just below p
+            int below = static_cast<int>(std::lower_bound(sortedPositions.begin(), sortedPositions.begin() + upper,
+                                                          sortedPositions[upper - 1]) - sortedPositions.begin());
+            double d = p - sortedPositions[below];
+            if (best == -1 || d < distance || (d == distance && lineIndices[below] < lineIndices[best])) {
+                best = below;
+                distance = d;
+            }
+        }
+        return best;
+    }
+
+    int AxisLineIndex::nearest(double p) const {
+        int upper = static_cast<int>(std::lower_bound(sortedPositions.begin(), sortedPositions.end(), p) - sortedPositions.begin());
+        double distance = 0.0;
+        int slot = nearestFrom(upper, p, distance);
+        return (slot < 0) ? -1 : lineIndices[slot];
+    }
+
+    int AxisLineIndex::nearestWithin(double p, double tolerance) const {
+        int upper = static_cast<int>(std::lower_bound(sortedPositions.begin(), sortedPositions.end(), p) - sortedPositions.begin());
+        double distance = 0.0;
+        int slot = nearestFrom(upper, p, distance);
+        return (slot < 0 || distance > tolerance) ? -1 : lineIndices[slot];
+    }
+
+    int AxisLineIndex::firstWithin(double p, double tolerance) const {
+        int slot = static_cast<int>(std::lower_bound(sortedPositions.begin(), sortedPositions.end(), p - tolerance) - sortedPositions.begin());
+        // one slot of slack for rounding in p - tolerance
+        slot = std::max(0, slot - 1);
+
+        int first = -1;
+        for (; slot < size() && sortedPositions[slot] <= p + tolerance; ++slot) {
+            if (std::abs(p - sortedPositions[slot]) < tolerance && (first == -1 || lineIndices[slot] < first)) {
+                first = lineIndices[slot];
+            }
+        }
+        return first;
+    }
+
+    std::pair<int, int> AxisLineIndex::range(double lo, double hi) const {
+        int first = static_cast<int>(std::lower_bound(sortedPositions.begin(), sortedPositions.end(), lo) - sortedPositions.begin());
+        int last = static_cast<int>(std::upper_bound(sortedPositions.begin(), sortedPositions.end(), hi) - sortedPositions.begin());
+        return {first, std::max(first, last)};
+    }
+
+    int AxisLineIndex::countBelow(double p) const {
+        return static_cast<int>(std::lower_bound(sortedPositions.begin(), sortedPositions.end(), p) - sortedPositions.begin());
+    }
+
+    int AxisLineIndex::countAbove(double p) const {
+        return size() - static_cast<int>(std::upper_bound(sortedPositions.begin(), sortedPositions.end(), p) - sortedPositions.begin());
+    }
+
+    std::vector<int> AxisLineIndex::nearestWithin(const std::vector<double>& coords, double tolerance) const {
+        std::vector<int> result(coords.size());
+        for (size_t i = 0; i < coords.size(); ++i) {
+            result[i] = nearestWithin(coords[i], tolerance);
+        }
+        return result;
+    }
+
+    std::vector<int> AxisLineIndex::firstWithin(const std::vector<double>& coords, double tolerance) const {
+        std::vector<int> result(coords.size());
+        for (size_t i = 0; i < coords.size(); ++i) {
+            result[i] = firstWithin(coords[i], tolerance);
+        }
+        return result;
+    }
+
+} // namespace Map
@@ -0,0 +1,287 @@
+//------------------------------------------------------------------------------
+// ChainContraction.cpp - Degree-2 chain contraction around the solve stages
+//------------------------------------------------------------------------------
+
+#include "ChainContraction.h"
+#include "EdgeOrientation.h"
+#include "VertexAlignment.h"
+#include "VisualizeSVG.h"
+#include "MapFileReader.h"
+#include "IndexedAdjacency.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <map>
+#include <set>
+
+namespace Map {
+
+    // Parameter settings for chain contraction
+    const double CHAIN_MAX_DEVIATION = 10.0;        // Max distance of a contracted vertex from its super-edge
+
+    //------------------------------------------------------------------------------
+    // Distance from p to the segment a-b
+    //------------------------------------------------------------------------------
+    static double distanceToSegment(const Coord2& p, const Coord2& a, const Coord2& b) {
+        double dx = b.x() - a.x();
+        double dy = b.y() - a.y();
+        double lengthSq = dx * dx + dy * dy;
+        double t = 0.0;
+        if (lengthSq > 0.0) {
+            t = ((p.x() - a.x()) * dx + (p.y() - a.y()) * dy) / lengthSq;
+            t = std::max(0.0, std::min(1.0, t));
+        }
+        double ex = a.x() + t * dx - p.x();
+        double ey = a.y() + t * dy - p.y();
+        return std::sqrt(ex * ex + ey * ey);
+    }
+
+    int contractDegree2Chains(
+        const std::vector<BaseEdgeProperty>& edgeList,
+        const BaseUGraphProperty& graph,
+        MapSubproblem& reduced,
+        ContractionResult& contraction,
+        double maxDeviation) {
+
+        contraction = ContractionResult();
+
+        IndexedAdjacency adj = buildIndexedAdjacency(graph);
+        const int vertexNum = adj.vertexCount();
+        const int edgeNum = static_cast<int>(edgeList.size());
+
+        auto coordOf = [&](int v) -> const Coord2& { return graph[adj.vertexDescs[v]].getCoord(); };
+        auto idOf = [&](int v) { return graph[adj.vertexDescs[v]].getID(); };
+        auto adjacent = [&](int a, int b) {
+            for (int k = adj.begin(a); k < adj.end(a); ++k) {
+                if (adj.neighbors[k] == b) return true;
+            }
+            return false;
+        };
+
+        // Every vertex that is not an interior chain vertex is kept
+        std::vector<char> kept(vertexNum, 0);
+        for (int v = 0; v < vertexNum; ++v) {
+            kept[v] = (adj.degree(v) != 2);
+        }
+
+        std::vector<char> edgeUsed(edgeNum, 0);
+        std::set<std::pair<unsigned int, unsigned int>> superEdgeEnds;
+        std::vector<std::pair<unsigned int, unsigned int>> reducedEdgeEnds;
+
+        // Cut the path into straight runs and emit super-edges or plain edges
+        auto emitPath = [&](const std::vector<int>& path, const std::vector<int>& pathEdges) {
+            const int last = static_cast<int>(path.size()) - 1;
+            auto isStraight = [&](int s, int e) {
+                for (int i = s + 1; i < e; ++i) {
+                    if (distanceToSegment(coordOf(path[i]), coordOf(path[s]), coordOf(path[e])) > maxDeviation) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            auto endsKey = [&](int s, int e) {
+                return std::make_pair(std::min(idOf(path[s]), idOf(path[e])), std::max(idOf(path[s]), idOf(path[e])));
+            };
+
+            int s = 0;
+            while (s < last) {
+                int e = s + 1;
+                while (e < last && path[e + 1] != path[s] && isStraight(s, e + 1)) {
+                    ++e;
+                }
+                // a super-edge must not duplicate an existing edge
+                while (e - s >= 2 && (adjacent(path[s], path[e]) || superEdgeEnds.count(endsKey(s, e)))) {
+                    --e;
+                }
+
+                if (e - s >= 2) {
+                    ContractedChain chain;
+                    chain.sourceID = idOf(path[s]);
+                    chain.targetID = idOf(path[e]);
+                    chain.superEdgeID = static_cast<unsigned int>(reducedEdgeEnds.size());
+
+                    std::vector<double> arcLength(1, 0.0);
+                    for (int i = s + 1; i <= e; ++i) {
+                        Coord2 step = coordOf(path[i]) - coordOf(path[i - 1]);
+                        arcLength.push_back(arcLength.back() + std::sqrt(step.x() * step.x() + step.y() * step.y()));
+                    }
+                    double total = arcLength.back();
+                    for (int i = s + 1; i < e; ++i) {
+                        chain.innerIDs.push_back(idOf(path[i]));
+                        chain.fractions.push_back(total > 0.0 ? arcLength[i - s] / total : double(i - s) / (e - s));
+                    }
+                    for (int i = s; i < e; ++i) {
+                        chain.edgeIDs.push_back(pathEdges[i]);
+                    }
+
+                    superEdgeEnds.insert(endsKey(s, e));
+                    reducedEdgeEnds.emplace_back(chain.sourceID, chain.targetID);
+                    contraction.reducedEdge2Original.push_back(-1);
+                    contraction.contractedVertexNum += e - s - 1;
+                    contraction.chains.push_back(std::move(chain));
+                }
+                else {
+                    reducedEdgeEnds.emplace_back(idOf(path[s]), idOf(path[e]));
+                    contraction.reducedEdge2Original.push_back(pathEdges[s]);
+                }
+                kept[path[e]] = 1;
+                s = e;
+            }
+        };
+
+        // Walk from a kept vertex along incident slot k until the next kept vertex
+        auto walk = [&](int start, int k) {
+            std::vector<int> path(1, start);
+            std::vector<int> pathEdges;
+            int slot = k;
+            while (true) {
+                int edgeID = adj.edgeIDs[slot];
+                int next = adj.neighbors[slot];
+                edgeUsed[edgeID] = 1;
+                path.push_back(next);
+                pathEdges.push_back(edgeID);
+                if (kept[next] || next == start) {
+                    break;
+                }
+                // the other incident slot of a degree-2 vertex
+                int first = adj.begin(next);
+                slot = (adj.edgeIDs[first] == edgeID) ? first + 1 : first;
+                if (edgeUsed[adj.edgeIDs[slot]]) {
+                    break;
+                }
+            }
+            emitPath(path, pathEdges);
+        };
+
+        for (int v = 0; v < vertexNum; ++v) {
+            if (!kept[v]) continue;
+            for (int k = adj.begin(v); k < adj.end(v); ++k) {
+                if (!edgeUsed[adj.edgeIDs[k]]) {
+                    walk(v, k);
+                }
+            }
+        }
+        // Isolated cycles of degree-2 vertices: keep one vertex per cycle
+        for (int v = 0; v < vertexNum; ++v) {
+            if (adj.degree(v) == 2 && !edgeUsed[adj.edgeIDs[adj.begin(v)]]) {
+                kept[v] = 1;
+                walk(v, adj.begin(v));
+            }
+        }
+
+        std::vector<BaseVertexProperty> reducedVertices;
+        for (int v = 0; v < vertexNum; ++v) {
+            if (kept[v]) {
+                reducedVertices.push_back(graph[adj.vertexDescs[v]]);
+            }
+        }
+
+        if (!reduced.build(reducedVertices, reducedEdgeEnds)) {
+            std::cerr << "error: failed to build the contracted problem" << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    void expandDegree2Chains(
+        const MapSubproblem& reduced,
+        const ContractionResult& contraction,
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph) {
+
+        std::map<unsigned int, Coord2> coords = reduced.coordinates();
+        const std::vector<BaseEdgeProperty>& reducedEdges = reduced.EdgeList();
+
+        // Contracted vertices lie on the straightened super-edge and inherit its orientation
+        for (const ContractedChain& chain : contraction.chains) {
+            Coord2 a = coords[chain.sourceID];
+            Coord2 b = coords[chain.targetID];
+            for (size_t i = 0; i < chain.innerIDs.size(); ++i) {
+                double f = chain.fractions[i];
+                coords[chain.innerIDs[i]] = Coord2(a.x() + f * (b.x() - a.x()), a.y() + f * (b.y() - a.y()));
+            }
+
+            const BaseEdgeProperty& superEdge = reducedEdges[chain.superEdgeID];
+            for (unsigned int edgeID : chain.edgeIDs) {
+                edgeList[edgeID].setOriented2H(superEdge.Oriented2H());
+                edgeList[edgeID].setOriented2V(superEdge.Oriented2V());
+            }
+        }
+        for (size_t e = 0; e < contraction.reducedEdge2Original.size(); ++e) {
+            int original = contraction.reducedEdge2Original[e];
+            if (original >= 0) {
+                edgeList[original].setOriented2H(reducedEdges[e].Oriented2H());
+                edgeList[original].setOriented2V(reducedEdges[e].Oriented2V());
+            }
+        }
+
+        for (BaseVertexProperty& vertex : vertexList) {
+            auto it = coords.find(vertex.getID());
+            if (it != coords.end()) {
+                vertex.setCoord(it->second);
+            }
+        }
+        std::pair<BaseUGraphProperty::vertex_iterator, BaseUGraphProperty::vertex_iterator> vp = boost::vertices(graph);
+        for (BaseUGraphProperty::vertex_iterator vi = vp.first; vi != vp.second; ++vi) {
+            auto it = coords.find(graph[*vi].getID());
+            if (it != coords.end()) {
+                graph[*vi].setCoord(it->second);
+            }
+        }
+        std::pair<BaseUGraphProperty::edge_iterator, BaseUGraphProperty::edge_iterator> ep = boost::edges(graph);
+        for (BaseUGraphProperty::edge_iterator ei = ep.first; ei != ep.second; ++ei) {
+            BaseEdgeProperty& edge = graph[*ei];
+            edge.setOriented2H(edgeList[edge.ID()].Oriented2H());
+            edge.setOriented2V(edgeList[edge.ID()].Oriented2V());
+        }
+        updateEdgeAngles(edgeList, graph);
+    }
+
+    int optimizeWithChainContraction(
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph,
+        const std::string& testCaseName) {
+
+        std::cout << "\n=== Degree-2 Chain Contraction ===" << std::endl;
+        MapSubproblem reduced;
+        ContractionResult contraction;
+        if (contractDegree2Chains(edgeList, graph, reduced, contraction, CHAIN_MAX_DEVIATION) != 0) {
+            return -1;
+        }
+        std::cout << "Contracted " << contraction.contractedVertexNum << " vertices into "
+                  << contraction.chains.size() << " super-edges: "
+                  << boost::num_vertices(graph) << " -> " << reduced.VertexList().size() << " vertices, "
+                  << boost::num_edges(graph) << " -> " << reduced.EdgeList().size() << " edges" << std::endl;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        reduced.activate();
+        int result = optimizeEdgeOrientation(reduced.VertexList(), reduced.EdgeList(), reduced.Graph(),
+                                             testCaseName + "_contracted");
+        auto t1 = std::chrono::high_resolution_clock::now();
+        if (result == 0) {
+            result = optimizeVertexAlignment(reduced.VertexList(), reduced.EdgeList(), reduced.Graph(),
+                                             testCaseName + "_contracted");
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        // Point the global maps back at the full graph
+        buildVertexMapping(graph);
+        buildEdgeMapping(graph);
+        if (result != 0) {
+            return result;
+        }
+
+        expandDegree2Chains(reduced, contraction, vertexList, edgeList, graph);
+        std::cout << "Contracted solve: EdgeOrientation "
+                  << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms, VertexAlignment "
+                  << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms" << std::endl;
+
+        std::string outputFile = "output/" + testCaseName + "_3.svg";
+        createVisualization(vertexList, edgeList, outputFile);
+        return 0;
+    }
+
+} // namespace Map
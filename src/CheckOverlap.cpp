@@ -1,461 +1,703 @@
 #include "CheckOverlap.h"
+#include "OverlapPredicates.h"
 #include "BaseEdgeProperty.h"
 #include "BaseVertexProperty.h"
 #include "BaseUGraphProperty.h"
 #include "Commons.h"
 #include "SpatialGrid.h"
 
+#include <algorithm>
 #include <cmath>
-#include <deque>
-#include <memory>
+#include <cstdint>
+#include <limits>
 #include <boost/config.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/iteration_macros.hpp>
 
 namespace Map {
-    const double EPSILON = 1e-3;
+    const double EPSILON = OVERLAP_EPSILON;
     
-    bool isCollinear(double x, double y, double x_A, double y_A, double x_B, double y_B){
-        double cross_product = (y - y_A) * (x_B - x_A) - (x - x_A) * (y_B - y_A);
-        return std::abs(cross_product) < EPSILON;
-    }   
-
     bool VVOverlap(const BaseVertexProperty& vertex_1, const BaseVertexProperty& vertex_2) {
-        return (std::abs(vertex_1.getCoord().x() - vertex_2.getCoord().x()) < EPSILON) &&
-               (std::abs(vertex_1.getCoord().y() - vertex_2.getCoord().y()) < EPSILON);
+        return pointsOverlap(vertex_1.getCoord().x(), vertex_1.getCoord().y(), vertex_2.getCoord().x(), vertex_2.getCoord().y());
     }
 
     bool VEOverlap(const BaseVertexProperty& vertex, const BaseEdgeProperty& edge) {
-        double x_A = edge.Source().getCoord().x();
-        double y_A = edge.Source().getCoord().y();
-        double x_B = edge.Target().getCoord().x();
-        double y_B = edge.Target().getCoord().y();
-
-        double x_P = vertex.getCoord().x();
-        double y_P = vertex.getCoord().y();
-
-        if (isCollinear(x_P, y_P, x_A, y_A, x_B, y_B)) {
-            if (std::abs(x_A - x_B) < EPSILON) { // vertical line
-                return (y_P > std::min(y_A, y_B)) && (y_P < std::max(y_A, y_B));
-            }     
-            else {
-                return (x_P > std::min(x_A, x_B)) && (x_P < std::max(x_A, x_B));
-            }
-        }
-        else {
-            return false;
-        }
+        const Coord2& A = edge.Source().getCoord();
+        const Coord2& B = edge.Target().getCoord();
+        return pointInsideSegment(segmentAxis(A.x(), A.y(), B.x(), B.y()), vertex.getCoord().x(), vertex.getCoord().y(),
+                                  A.x(), A.y(), B.x(), B.y());
     }
 
     // check if two edges overlap
     bool EEOverlap(const BaseEdgeProperty& edge_1, const BaseEdgeProperty& edge_2) {
-        double x_A = edge_1.Source().getCoord().x();
-        double y_A = edge_1.Source().getCoord().y();
-        double x_B = edge_1.Target().getCoord().x();
-        double y_B = edge_1.Target().getCoord().y();
-
-        double x_C = edge_2.Source().getCoord().x();
-        double y_C = edge_2.Source().getCoord().y();
-        double x_D = edge_2.Target().getCoord().x();
-        double y_D = edge_2.Target().getCoord().y();
-
-        if (isCollinear(x_C, y_C, x_A, y_A, x_B, y_B) && isCollinear(x_D, y_D, x_A, y_A, x_B, y_B)) {
-            if (std::abs(x_A - x_B) < EPSILON) { 
-                // A, B, C, D are on the same vertical line.
-                double a = std::min(y_A, y_B);
-                double b = std::max(y_A, y_B);
-                double c = std::min(y_C, y_D);
-                double d = std::max(y_C, y_D); 
-                return !(c >= b || d <= a);
-            }     
-            else {
-                double a = std::min(x_A, x_B);
-                double b = std::max(x_A, x_B);
-                double c = std::min(x_C, x_D);
-                double d = std::max(x_C, x_D);    
-                return !(c >= b || d <= a);
-            }
+        const Coord2& A = edge_1.Source().getCoord();
+        const Coord2& B = edge_1.Target().getCoord();
+        return segmentsOverlap(segmentAxis(A.x(), A.y(), B.x(), B.y()), A.x(), A.y(), B.x(), B.y(),
+                               edge_2.Source().getCoord().x(), edge_2.Source().getCoord().y(),
+                               edge_2.Target().getCoord().x(), edge_2.Target().getCoord().y());
+    }
+
+    bool overlapHappens(int vertexID, const Coord2& newPos, const BaseUGraphProperty& graph, bool printReport) {
+        // the graph changes between calls, so the geometry is gathered every time; the buffers stay
+        static thread_local OverlapGeometry geometry;
+        geometry.build(graph);
+
+        OverlapReport report;
+        bool overlap = overlapKernel(geometry, geometry.indexOf(vertexID), newPos.x(), newPos.y(), printReport ? &report : nullptr);
+        if (overlap && printReport) {
+            printOverlapReport(report);
+        }
+        return overlap;
+    }
+
+    std::vector<bool> overlapHappensBatch(int vertexID, const std::vector<Coord2>& newPositions,
+                                          const BaseUGraphProperty& graph) {
+        boost::dynamic_bitset<> overlaps = overlapBatch(vertexID, Span<Coord2>(newPositions), graph);
+        std::vector<bool> result(newPositions.size());
+        for (std::size_t c = 0; c < newPositions.size(); ++c) {
+            result[c] = overlaps[c];
         }
-        else {
+        return result;
+    }
+
+    bool overlapHappensOptimized(int vertexID, const Coord2& newPos, 
+                                  const BaseUGraphProperty& graph,
+                                  SpatialGrid* spatialGrid, bool printReport) {
+        if (spatialGrid == nullptr) {
+            return overlapHappens(vertexID, newPos, graph, printReport);
+        }
+
+        // the vertex, its edges and whatever the grid holds around newPos and along the moved edges;
+        // edges are inserted into the 8-neighbourhood of their cells, so they are looked up in the
+        // cells proper and vertices one cell around
+        static thread_local std::vector<int> vertexIDs, edgeIDs;
+        vertexIDs.assign(1, vertexID);
+        edgeIDs.clear();
+        auto gatherVertices = [](const std::unordered_set<int>& vertices, const std::unordered_set<int>&) {
+            vertexIDs.insert(vertexIDs.end(), vertices.begin(), vertices.end());
+            return false;
+        };
+        auto gatherEdges = [](const std::unordered_set<int>&, const std::unordered_set<int>& edges) {
+            edgeIDs.insert(edgeIDs.end(), edges.begin(), edges.end());
             return false;
+        };
+        spatialGrid->forEachCellNear(newPos, 1, gatherVertices);
+        spatialGrid->forEachCellNear(newPos, 0, gatherEdges);
+        auto oep = boost::out_edges(getVertexDescriptor(vertexID), graph);
+        for (auto oeit = oep.first; oeit != oep.second; ++oeit) {
+            const BaseEdgeProperty& edge = graph[*oeit];
+            edgeIDs.push_back(edge.ID());
+            const BaseVertexProperty& other = (edge.Source().getID() == vertexID) ? edge.Target() : edge.Source();
+            spatialGrid->forEachCellAlongLine(newPos, other.getCoord(), 1, gatherVertices);
+            spatialGrid->forEachCellAlongLine(newPos, other.getCoord(), 0, gatherEdges);
         }
+        std::sort(vertexIDs.begin(), vertexIDs.end());
+        vertexIDs.erase(std::unique(vertexIDs.begin(), vertexIDs.end()), vertexIDs.end());
+        std::sort(edgeIDs.begin(), edgeIDs.end());
+        edgeIDs.erase(std::unique(edgeIDs.begin(), edgeIDs.end()), edgeIDs.end());
+
+        static thread_local OverlapGeometry geometry;
+        geometry.build(graph, Span<int>(vertexIDs), Span<int>(edgeIDs));
+
+        OverlapReport report;
+        bool overlap = overlapKernel(geometry, geometry.indexOf(vertexID), newPos.x(), newPos.y(), printReport ? &report : nullptr);
+        if (overlap && printReport) {
+            printOverlapReport(report);
+        }
+        return overlap;
     }
 
-    bool overlapHappens(int vertexID, const Coord2& newPos, const BaseUGraphProperty& graph) {
-        // current vertex descriptor
-        BaseUGraphProperty::vertex_descriptor VD = getVertexDescriptor(vertexID);
+    //------------------------------------------------------------------------------
+    //  Allocation-free kernel
+    //------------------------------------------------------------------------------
+
+    const char* overlapKindName(OverlapKind kind) {
+        switch (kind) {
+            case VERTEX_ON_VERTEX:      return "VVOverlap(1)";
+            case VERTEX_ON_EDGE:        return "VEOverlap(2.1)";
+            case EDGE_THROUGH_VERTEX:   return "VEOverlap(2.2)";
+            case EDGE_ALONG_EDGE:       return "EEOverlap(3.1)";
+            case EDGES_FOLDED:          return "EEOverlap(3.2)";
+            default:                    return "none";
+        }
+    }
+
+    void printOverlapReport(const OverlapReport& report) {
+        if (report.kind == NO_OVERLAP) return;
+        std::cout << std::endl;
+        std::cout << "Current vertex " << report.vertexID << ": (" << report.pos.x() << ", " << report.pos.y() << ")" << std::endl;
+        if (report.edgeID >= 0) {
+            std::cout << "Current edge " << report.edgeID << std::endl;
+        }
+        if (report.otherVertexID >= 0) {
+            std::cout << "Checked vertex " << report.otherVertexID << ": (" << report.otherPos.x() << ", " << report.otherPos.y() << ")" << std::endl;
+        }
+        if (report.otherEdgeID >= 0) {
+            std::cout << "Checked edge " << report.otherEdgeID << std::endl;
+        }
+        if (report.edgeID >= 0 || report.otherEdgeID >= 0) {
+            std::cout << "Segment (" << report.segmentStart.x() << ", " << report.segmentStart.y() << ") - ("
+                      << report.segmentEnd.x() << ", " << report.segmentEnd.y() << ")" << std::endl;
+        }
+        std::cout << overlapKindName(report.kind) << " happens" << std::endl;
+    }
+
+    void OverlapGeometry::clear( void ) {
+        xs.clear(); ys.clear(); vertexIDs.clear();
+        sources.clear(); targets.clear(); edgeIDs.clear(); axes.clear();
+        vertexIndex.clear();
+        spatialIndex.clear();
+        indexed = false;
+    }
+
+    void OverlapGeometry::addVertex(const BaseVertexProperty& vertex) {
+        vertexIndex[vertex.getID()] = static_cast<int>(xs.size());
+        vertexIDs.push_back(vertex.getID());
+        xs.push_back(vertex.getCoord().x());
+        ys.push_back(vertex.getCoord().y());
+    }
+
+    void OverlapGeometry::addEdge(const BaseEdgeProperty& edge) {
+        sources.push_back(indexOf(edge.Source().getID()));
+        targets.push_back(indexOf(edge.Target().getID()));
+        edgeIDs.push_back(edge.ID());
+        axes.push_back(segmentAxis(xs[sources.back()], ys[sources.back()], xs[targets.back()], ys[targets.back()]));
+    }
+
+    void OverlapGeometry::linkIncidentEdges( void ) {
+        incidentOffsets.assign(xs.size() + 1, 0);
+        for (int e = 0; e < edgeNum(); ++e) {
+            ++incidentOffsets[sources[e] + 1];
+            if (targets[e] != sources[e]) ++incidentOffsets[targets[e] + 1];
+        }
+        for (int i = 0; i < vertexNum(); ++i) {
+            incidentOffsets[i + 1] += incidentOffsets[i];
+        }
+        incidentEdges.assign(incidentOffsets.back(), -1);
+        std::vector<int> fill(incidentOffsets.begin(), incidentOffsets.end() - 1);
+        for (int e = 0; e < edgeNum(); ++e) {
+            incidentEdges[fill[sources[e]]++] = e;
+            if (targets[e] != sources[e]) incidentEdges[fill[targets[e]]++] = e;
+        }
+    }
 
+    void OverlapGeometry::build(const BaseUGraphProperty& graph) {
+        clear();
         auto vp = boost::vertices(graph);
+        for (auto vit = vp.first; vit != vp.second; ++vit) {
+            addVertex(graph[*vit]);
+        }
         auto ep = boost::edges(graph);
+        for (auto eit = ep.first; eit != ep.second; ++eit) {
+            addEdge(graph[*eit]);
+        }
+        linkIncidentEdges();
+    }
 
-        auto oep = boost::out_edges(VD, graph);
+    void OverlapGeometry::build(const BaseUGraphProperty& graph, Span<int> vertexIDs, Span<int> edgeIDs) {
+        clear();
+        for (int vertexID : vertexIDs) {
+            if (indexOf(vertexID) < 0) addVertex(graph[getVertexDescriptor(vertexID)]);
+        }
+        for (int edgeID : edgeIDs) {
+            const BaseEdgeProperty& edge = graph[getEdgeDescriptor(edgeID)];
+            if (indexOf(edge.Source().getID()) < 0) addVertex(edge.Source());
+            if (indexOf(edge.Target().getID()) < 0) addVertex(edge.Target());
+            addEdge(edge);
+        }
+        linkIncidentEdges();
+    }
 
-        // !!! Remember: check overlap with the new vertex position and the corresponding edges!
-
-        BaseVertexProperty tempNewV = BaseVertexProperty(graph[VD]);
-        tempNewV.setCoord(newPos);
-
-        // std::cout << tempNewV.getID() << ": (" << tempNewV.getCoord().x() << ", " << tempNewV.getCoord().y() << ")" << std::endl;
-
-        std::set<int> outVertexIDs;
-        std::set<int> outEdgeIDs;
-
-        // // !!! confusing checking result here !!!
-        // if (vertexID == 17) {
-        //     std::cout << std::endl;
-        //     BaseUGraphProperty::vertex_descriptor tempVD = getVertexDescriptor(10);
-        //     std::cout << graph[tempVD].getID() << " " << graph[tempVD].getCoord().x() << " " << graph[tempVD].getCoord().y() << std::endl;
-        //     std::cout << "All hail Lelouch!" << std::endl;
-        //     for (BaseUGraphProperty::out_edge_iterator oeit = oep.first; oeit != oep.second; ++oeit) {
-        //         std::cout << graph[*oeit].Source().getID() << " " << graph[*oeit].Source().getCoord().x() << " " << graph[*oeit].Source().getCoord().y() << std::endl;
-        //         std::cout << graph[*oeit].Target().getID() << " " << graph[*oeit].Target().getCoord().x() << " " << graph[*oeit].Target().getCoord().y() << std::endl;
-        //         std::cout << std::endl;
-        //     }
-        // }
-
-        for (BaseUGraphProperty::out_edge_iterator oeit = oep.first; oeit != oep.second; ++oeit) {
-            outEdgeIDs.insert(graph[*oeit].ID());
-            if (graph[*oeit].Source().getID() == vertexID) {
-                outVertexIDs.insert(graph[*oeit].Target().getID());
-            }
-            else {
-                outVertexIDs.insert(graph[*oeit].Source().getID());
+    void OverlapGeometry::buildSpatialIndex(double cellSize) {
+        spatialIndex.clear();
+        spatialIndex.setCellSize(cellSize);
+        for (int i = 0; i < vertexNum(); ++i) {
+            spatialIndex.insertVertex(i, coord(i));
+        }
+        for (int e = 0; e < edgeNum(); ++e) {
+            spatialIndex.insertEdge(e, coord(sources[e]), coord(targets[e]));
+        }
+        indexed = true;
+    }
+
+    void OverlapGeometry::setCoord(int index, double x, double y) {
+        const Coord2 oldPos = coord(index);
+        xs[index] = x;
+        ys[index] = y;
+        if (indexed) spatialIndex.moveVertex(index, oldPos, Coord2(x, y));
+        for (int k = incidentOffsets[index]; k < incidentOffsets[index + 1]; ++k) {
+            int e = incidentEdges[k];
+            axes[e] = segmentAxis(xs[sources[e]], ys[sources[e]], xs[targets[e]], ys[targets[e]]);
+            if (indexed) {
+                spatialIndex.moveEdge(e, sources[e] == index ? oldPos : coord(sources[e]), targets[e] == index ? oldPos : coord(targets[e]),
+                                      coord(sources[e]), coord(targets[e]));
             }
         }
+    }
 
-        // Store vertices persistently so references remain valid
-        // Use deque instead of vector to avoid reference invalidation on reallocation
-        std::deque<BaseVertexProperty> vertexStorage;
-        std::vector<BaseEdgeProperty> newOutEdges;  
-        
-        for(BaseUGraphProperty::out_edge_iterator oeit = oep.first; oeit != oep.second; ++oeit) {
-            // Create deep copies of vertices and store them persistently
-            BaseVertexProperty tempSource = graph[*oeit].Source();
-            BaseVertexProperty tempTarget = graph[*oeit].Target();
+    int OverlapGeometry::indexOf(int vertexID) const {
+        auto it = vertexIndex.find(vertexID);
+        return it == vertexIndex.end() ? -1 : it->second;
+    }
 
-            if (tempSource.getID() == vertexID) {
-                tempSource.setCoord(newPos);
+    namespace {
+        // What overlapKernelOn tests against: every vertex and edge of the geometry. f(index)
+        // returns true to stop, and so does the visit.
+        struct AllElements {
+            int     vertexNum;
+            int     edgeNum;
+
+            template <class F> bool nearVertices(double, double, F f) const {
+                for (int u = 0; u < vertexNum; ++u) if (f(u)) return true;
+                return false;
             }
-            else {
-                tempTarget.setCoord(newPos);
+            template <class F> bool nearEdges(double, double, F f) const {
+                for (int e = 0; e < edgeNum; ++e) if (f(e)) return true;
+                return false;
             }
-            
-            // Store vertices in vector so they persist (important: references in BaseEdgeProperty must remain valid!)
-            vertexStorage.push_back(tempSource);
-            vertexStorage.push_back(tempTarget);
-            
-            // Create a new edge with references to the persistent vertex copies
-            BaseEdgeProperty tempEdge(vertexStorage[vertexStorage.size()-2], 
-                                     vertexStorage[vertexStorage.size()-1], 
-                                     graph[*oeit].ID(), 
-                                     graph[*oeit].Angle());
-            newOutEdges.push_back(tempEdge);
-        } 
-
-        // // !!! output something confusing here !!!
-        // std::cout << "Glory is mine!" << std::endl;
-        // for (auto newOutEdge: newOutEdges) {
-        //     std::cout << newOutEdge.Source().getID() << ": (" << newOutEdge.Source().getCoord().x() << ", " << newOutEdge.Source().getCoord().y() << ")" << std::endl;
-        //     std::cout << newOutEdge.Target().getID() << ": (" << newOutEdge.Target().getCoord().x() << ", " << newOutEdge.Target().getCoord().y() << ")" << std::endl;
-        //     std::cout << std::endl;
-        // }
-
-        // 1. V-V checking
-        std::cout << "Checking overlap 1..." << std::endl;
-        for (BaseUGraphProperty::vertex_iterator vit = vp.first; vit != vp.second; ++vit) {
-            BaseVertexProperty tempV = graph[*vit];
-            if (vertexID != tempV.getID() && VVOverlap(tempNewV, tempV)) {
-                std::cout << std::endl;
-                std::cout << "Checked vertex " << tempV.getID() << ": (" << tempV.getCoord().x() << ", " << tempV.getCoord().y() << ")" << std::endl;
-                std::cout << "Current vertex " << tempNewV.getID() << ": (" << tempNewV.getCoord().x() << ", " << tempNewV.getCoord().y() << ")" << std::endl;
-                std::cout << "VVOverlap(1) happens" << std::endl;
-                return true;
+            template <class F> bool verticesAlong(double, double, double, double, F f) const { return nearVertices(0.0, 0.0, f); }
+            template <class F> bool edgesAlong(double, double, double, double, F f) const { return nearEdges(0.0, 0.0, f); }
+        };
+
+        // Only those in the cells of the spatial index around the point or along the segment.
+        // Edges sit in the 8-neighbourhood of their cells as well, so they are looked up in the
+        // cells proper and vertices one cell around. An element may be visited more than once.
+        struct IndexedElements {
+            const SpatialGrid&  index;
+
+            template <class F> bool nearVertices(double x, double y, F f) const {
+                return index.forEachCellNear(Coord2(x, y), 1, [&f](const std::unordered_set<int>& vertices, const std::unordered_set<int>&) {
+                    for (int u : vertices) if (f(u)) return true;
+                    return false;
+                });
             }
-        }
-
-        // 2. V-E checking
-
-        std::cout << "Checking overlap 2.1..." << std::endl;
-        for (BaseUGraphProperty::edge_iterator eit = ep.first; eit != ep.second; ++eit) {
-            int tempID = graph[*eit].ID();
-            if (outEdgeIDs.find(tempID) == outEdgeIDs.end()) { 
-                // graph[*eit] is not an out-edge of v
+            template <class F> bool nearEdges(double x, double y, F f) const {
+                return index.forEachCellNear(Coord2(x, y), 0, [&f](const std::unordered_set<int>&, const std::unordered_set<int>& edges) {
+                    for (int e : edges) if (f(e)) return true;
+                    return false;
+                });
+            }
+            template <class F> bool verticesAlong(double x_A, double y_A, double x_B, double y_B, F f) const {
+                return index.forEachCellAlongLine(Coord2(x_A, y_A), Coord2(x_B, y_B), 1,
+                    [&f](const std::unordered_set<int>& vertices, const std::unordered_set<int>&) {
+                        for (int u : vertices) if (f(u)) return true;
+                        return false;
+                    });
+            }
+            template <class F> bool edgesAlong(double x_A, double y_A, double x_B, double y_B, F f) const {
+                return index.forEachCellAlongLine(Coord2(x_A, y_A), Coord2(x_B, y_B), 0,
+                    [&f](const std::unordered_set<int>&, const std::unordered_set<int>& edges) {
+                        for (int e : edges) if (f(e)) return true;
+                        return false;
+                    });
+            }
+        };
+    }
 
-                if (VEOverlap(tempNewV, graph[*eit])) {
-                    std::cout << std::endl;
-                    std::cout << "Current vertex: " << tempNewV.getCoord().x() << " " << tempNewV.getCoord().y() << std::endl;
-                    std::cout << "Checked edge source " << graph[*eit].Source().getID() << ": (" << graph[*eit].Source().getCoord().x() << ", " << graph[*eit].Source().getCoord().y() << ")" << std::endl;
-                    std::cout << "Checked edge target " << graph[*eit].Target().getID() << ": (" << graph[*eit].Target().getCoord().x() << ", " << graph[*eit].Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "VEOverlap(2.1) happens" << std::endl;
-                    return true;
-                }
+    template <class Elements>
+    bool overlapKernelOn(const OverlapGeometry& geometry, const Elements& elements, int vertexIndex,
+                         double x, double y, OverlapReport* report) {
+        const std::vector<double>& xs = geometry.xs;
+        const std::vector<double>& ys = geometry.ys;
+        const std::vector<int>& sources = geometry.sources;
+        const std::vector<int>& targets = geometry.targets;
+        const int* ownFirst = geometry.incidentEdges.data() + geometry.incidentOffsets[vertexIndex];
+        const int* ownLast = geometry.incidentEdges.data() + geometry.incidentOffsets[vertexIndex + 1];
+
+        // Endpoints of an edge with the moved vertex at (x, y)
+        auto endpoints = [&](int e, double& x_A, double& y_A, double& x_B, double& y_B) {
+            x_A = sources[e] == vertexIndex ? x : xs[sources[e]];
+            y_A = sources[e] == vertexIndex ? y : ys[sources[e]];
+            x_B = targets[e] == vertexIndex ? x : xs[targets[e]];
+            y_B = targets[e] == vertexIndex ? y : ys[targets[e]];
+        };
+        auto isOwn = [&](int e) { return sources[e] == vertexIndex || targets[e] == vertexIndex; };
+        auto isNeighbor = [&](int u) {
+            for (const int* e = ownFirst; e != ownLast; ++e) {
+                if (sources[*e] == u || targets[*e] == u) return true;
+            }
+            return false;
+        };
+        auto found = [&](OverlapKind kind, int otherVertex, int edge, int otherEdge) {
+            if (report == nullptr) return true;
+            report->kind = kind;
+            report->vertexID = geometry.vertexIDs[vertexIndex];
+            report->pos = Coord2(x, y);
+            report->otherVertexID = otherVertex >= 0 ? geometry.vertexIDs[otherVertex] : -1;
+            report->edgeID = edge >= 0 ? geometry.edgeIDs[edge] : -1;
+            report->otherEdgeID = otherEdge >= 0 ? geometry.edgeIDs[otherEdge] : -1;
+            report->otherPos = otherVertex >= 0 ? Coord2(xs[otherVertex], ys[otherVertex]) : Coord2(x, y);
+            double x_A, y_A, x_B, y_B;
+            int segment = otherEdge >= 0 ? otherEdge : edge;
+            if (segment >= 0) {
+                endpoints(segment, x_A, y_A, x_B, y_B);
+                report->segmentStart = Coord2(x_A, y_A);
+                report->segmentEnd = Coord2(x_B, y_B);
             }
+            return true;
+        };
+        if (report) report->kind = NO_OVERLAP;
+        int hit = -1;
+
+        // 1. V-V
+        if (elements.nearVertices(x, y, [&](int u) {
+                hit = u;
+                return u != vertexIndex && pointsOverlap(x, y, xs[u], ys[u]);
+            })) {
+            return found(VERTEX_ON_VERTEX, hit, -1, -1);
         }
 
-        std::cout << "Checking overlap 2.2..." << std::endl;
-        for (auto newOutEdge: newOutEdges) {
-            for (BaseUGraphProperty::vertex_iterator vit = vp.first; vit != vp.second; ++vit) {
-                if (graph[*vit].getID() != vertexID && 
-                    outVertexIDs.find(graph[*vit].getID()) == outVertexIDs.end() && 
-                    VEOverlap(graph[*vit], newOutEdge)) {
-                    // an out-edge of v overlaps with an irrelevant vertex
-                    std::cout << std::endl;
-                    std::cout << "Checked vertex " << graph[*vit].getID() << ": (" << graph[*vit].getCoord().x() << ", " << graph[*vit].getCoord().y() << ")" << std::endl;
-                    std::cout << "Current edge source " << newOutEdge.Source().getID() << ": (" << newOutEdge.Source().getCoord().x() << ", " << newOutEdge.Source().getCoord().y() << ")" << std::endl;
-                    std::cout << "Current edge target " << newOutEdge.Target().getID() << ": (" << newOutEdge.Target().getCoord().x() << ", " << newOutEdge.Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "VEOverlap(2.2) happens" << std::endl;
-                    return true;
-                }
-            }
+        // 2.1. the vertex against the other edges
+        if (elements.nearEdges(x, y, [&](int e) {
+                hit = e;
+                return !isOwn(e) && pointInsideSegment(geometry.axes[e], x, y, xs[sources[e]], ys[sources[e]], xs[targets[e]], ys[targets[e]]);
+            })) {
+            return found(VERTEX_ON_EDGE, -1, -1, hit);
         }
 
-        // 3.1. check: OUT(v) and E-OUT(v)
-        std::cout << "Checking overlap 3.1..." << std::endl;
-        for (BaseUGraphProperty::edge_iterator eit = ep.first; eit != ep.second; ++eit) {
-            if(outEdgeIDs.find(graph[*eit].ID()) != outEdgeIDs.end()) {
-                // graph[*eit] is an out-edge of v
-                continue;
+        // 2.2. its edges against the unrelated vertices
+        for (const int* own = ownFirst; own != ownLast; ++own) {
+            double x_A, y_A, x_B, y_B;
+            endpoints(*own, x_A, y_A, x_B, y_B);
+            SegmentAxis axis = segmentAxis(x_A, y_A, x_B, y_B);
+            if (elements.verticesAlong(x_A, y_A, x_B, y_B, [&](int u) {
+                    hit = u;
+                    return u != vertexIndex && pointInsideSegment(axis, xs[u], ys[u], x_A, y_A, x_B, y_B) && !isNeighbor(u);
+                })) {
+                return found(EDGE_THROUGH_VERTEX, hit, *own, -1);
             }
-            
-            // graph[*eit] is not an out-edge of v
-            for (BaseEdgeProperty newOutEdge: newOutEdges) {
-                if (EEOverlap(graph[*eit], newOutEdge)) {
-                    std::cout << std::endl;
-                    std::cout << "Checked edge source " << graph[*eit].Source().getID() << ": (" << graph[*eit].Source().getCoord().x() << ", " << graph[*eit].Source().getCoord().y() << ")" << std::endl;
-                    std::cout << "Checked edge target " << graph[*eit].Target().getID() << ": (" << graph[*eit].Target().getCoord().x() << ", " << graph[*eit].Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "Current edge source " << newOutEdge.Source().getID() << ": (" << newOutEdge.Source().getCoord().x() << ", " << newOutEdge.Source().getCoord().y() << ")" << std::endl;
-                    std::cout << "Current edge target " << newOutEdge.Target().getID() << ": (" << newOutEdge.Target().getCoord().x() << ", " << newOutEdge.Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "EEOverlap(3.1) happens" << std::endl;
-                    return true;
-                }
+        }
+
+        // 3.1. its edges against the other edges
+        for (const int* own = ownFirst; own != ownLast; ++own) {
+            double x_C, y_C, x_D, y_D;
+            endpoints(*own, x_C, y_C, x_D, y_D);
+            if (elements.edgesAlong(x_C, y_C, x_D, y_D, [&](int e) {
+                    hit = e;
+                    return !isOwn(e) && segmentsOverlap(geometry.axes[e], xs[sources[e]], ys[sources[e]], xs[targets[e]], ys[targets[e]],
+                                                        x_C, y_C, x_D, y_D);
+                })) {
+                return found(EDGE_ALONG_EDGE, -1, *own, hit);
             }
         }
 
-        // 3.2. check: OUT(v) and OUT(v)
-        std::cout << "Checking overlap 3.2..." << std::endl;
-        for (BaseEdgeProperty newOutEdge1: newOutEdges) {
-            for (BaseEdgeProperty newOutEdge2: newOutEdges) {
-                if (newOutEdge1.ID() != newOutEdge2.ID() && 
-                    EEOverlap(newOutEdge1, newOutEdge2)) {
-                    std::cout << std::endl;
-                    std::cout << newOutEdge1.Source().getID() << ": (" << newOutEdge1.Source().getCoord().x() << ", " << newOutEdge1.Source().getCoord().y() << ")" << std::endl;
-                    std::cout << newOutEdge1.Target().getID() << ": (" << newOutEdge1.Target().getCoord().x() << ", " << newOutEdge1.Target().getCoord().y() << ")" << std::endl;
-                    std::cout << newOutEdge2.Source().getID() << ": (" << newOutEdge2.Source().getCoord().x() << ", " << newOutEdge2.Source().getCoord().y() << ")" << std::endl;
-                    std::cout << newOutEdge2.Target().getID() << ": (" << newOutEdge2.Target().getCoord().x() << ", " << newOutEdge2.Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "EEOverlap(3.2) happens" << std::endl;
-                    return true;
+        // 3.2. its edges against each other, both ways as the collinearity test is one-sided
+        for (const int* first = ownFirst; first != ownLast; ++first) {
+            for (const int* second = ownFirst; second != ownLast; ++second) {
+                if (first == second) continue;
+                double x_A, y_A, x_B, y_B, x_C, y_C, x_D, y_D;
+                endpoints(*first, x_A, y_A, x_B, y_B);
+                endpoints(*second, x_C, y_C, x_D, y_D);
+                if (segmentsOverlap(segmentAxis(x_A, y_A, x_B, y_B), x_A, y_A, x_B, y_B, x_C, y_C, x_D, y_D)) {
+                    return found(EDGES_FOLDED, -1, *first, *second);
                 }
             }
         }
-        
         return false;
     }
 
-    bool overlapHappensOptimized(int vertexID, const Coord2& newPos, 
-                                  const BaseUGraphProperty& graph,
-                                  SpatialGrid* spatialGrid) {
-        // 如果没有提供空间网格，创建一个临时的
-        std::unique_ptr<SpatialGrid> tempGrid;
-        if (spatialGrid == nullptr) {
-            // 自动估算合适的网格大小（可以根据图的边长分布调整）
-            tempGrid = std::make_unique<SpatialGrid>(2.0);
-            tempGrid->buildFromGraph(graph);
-            spatialGrid = tempGrid.get();
+    bool overlapKernel(const OverlapGeometry& geometry, int vertexIndex, double x, double y, OverlapReport* report) {
+        if (geometry.indexed) {
+            return overlapKernelOn(geometry, IndexedElements{geometry.spatialIndex}, vertexIndex, x, y, report);
         }
+        return overlapKernelOn(geometry, AllElements{geometry.vertexNum(), geometry.edgeNum()}, vertexIndex, x, y, report);
+    }
 
-        // 获取当前顶点描述符
-        BaseUGraphProperty::vertex_descriptor VD = getVertexDescriptor(vertexID);
+    //------------------------------------------------------------------------------
+    //  Batched candidates
+    //------------------------------------------------------------------------------
 
-        // 收集出边信息
-        auto oep = boost::out_edges(VD, graph);
-        std::set<int> outVertexIDs;
-        std::set<int> outEdgeIDs;
+    // Closed box, empty until something is added
+    struct OverlapBox {
+        double  xMin, xMax, yMin, yMax;
+
+        OverlapBox( void ): xMin(std::numeric_limits<double>::infinity()), xMax(-std::numeric_limits<double>::infinity()),
+                            yMin(std::numeric_limits<double>::infinity()), yMax(-std::numeric_limits<double>::infinity()) {}
 
-        for (BaseUGraphProperty::out_edge_iterator oeit = oep.first; oeit != oep.second; ++oeit) {
-            outEdgeIDs.insert(graph[*oeit].ID());
-            if (graph[*oeit].Source().getID() == vertexID) {
-                outVertexIDs.insert(graph[*oeit].Target().getID());
+        void add(double x, double y) {
+            xMin = std::min(xMin, x); xMax = std::max(xMax, x);
+            yMin = std::min(yMin, y); yMax = std::max(yMax, y);
+        }
+        void add(const OverlapBox& box) {
+            xMin = std::min(xMin, box.xMin); xMax = std::max(xMax, box.xMax);
+            yMin = std::min(yMin, box.yMin); yMax = std::max(yMax, box.yMax);
+        }
+        bool contains(double x, double y) const { return x >= xMin && x <= xMax && y >= yMin && y <= yMax; }
+        bool intersects(const OverlapBox& box) const {
+            return box.xMin <= xMax && box.xMax >= xMin && box.yMin <= yMax && box.yMax >= yMin;
+        }
+    };
+
+    // Box of segment AB outside of which no point passes pointInsideSegment and no segment
+    // passes segmentsOverlap against it: the open range on the tested axis, widened across
+    // it by the collinearity band EPSILON / |delta| (unbounded for a degenerate segment),
+    // plus EPSILON against rounding.
+    static OverlapBox reachBox(double x_A, double y_A, double x_B, double y_B) {
+        double dx = std::abs(x_A - x_B);
+        double dy = std::abs(y_A - y_B);
+        bool vertical = dx < EPSILON;
+        double delta = vertical ? dy : dx;
+        double band = (delta > 0.0 ? EPSILON / delta : std::numeric_limits<double>::infinity()) + EPSILON;
+        OverlapBox box;
+        box.add(x_A, y_A);
+        box.add(x_B, y_B);
+        box.xMin -= vertical ? band : EPSILON; box.xMax += vertical ? band : EPSILON;
+        box.yMin -= vertical ? EPSILON : band; box.yMax += vertical ? EPSILON : band;
+        return box;
+    }
+
+    // The neighborhood of one batch in flat arrays (structure of arrays), reused per thread.
+    // The moved vertex's own edges go first (setOwn), then the front-end offers every other
+    // vertex and every edge not incident to it, which are kept only if some candidate can
+    // reach them; test() then evaluates all candidates against what was kept.
+    struct OverlapBatchScratch {
+        // candidates
+        std::vector<double>     cx, cy;
+        std::vector<std::uint64_t> hit;             // as wide as the coordinates, and no char aliasing, so the loops vectorize
+        OverlapBox              candidateBox;       // VV reach
+        // own edges of the moved vertex: the other endpoint, and whether the vertex is Source()
+        std::vector<double>     nx, ny;
+        std::vector<int>        neighborIDs;
+        std::vector<unsigned char> ownIsSource;
+        std::vector<OverlapBox> ownReach;           // reachBox of the own edge, over all candidates
+        OverlapBox              ownReachBox;        // union of ownReach
+        OverlapBox              spanBox;            // candidates and neighbors
+        // kept vertices and edges
+        std::vector<double>     vx, vy;
+        std::vector<unsigned char> vUnrelated;
+        std::vector<double>     ax, ay, bx, by;
+        std::vector<SegmentAxis> eAxis;
+        std::vector<OverlapBox> eReach;
+
+        void reset(Span<Coord2> candidates) {
+            const int candidateNum = static_cast<int>(candidates.size());
+            cx.resize(candidateNum); cy.resize(candidateNum);
+            hit.assign(candidateNum, 0);
+            candidateBox = OverlapBox();
+            for (int c = 0; c < candidateNum; ++c) {
+                cx[c] = candidates[c].x();
+                cy[c] = candidates[c].y();
+                candidateBox.add(cx[c], cy[c]);
             }
-            else {
-                outVertexIDs.insert(graph[*oeit].Source().getID());
+            spanBox = candidateBox;
+            candidateBox.xMin -= EPSILON; candidateBox.xMax += EPSILON;
+            candidateBox.yMin -= EPSILON; candidateBox.yMax += EPSILON;
+            nx.clear(); ny.clear(); neighborIDs.clear(); ownIsSource.clear(); ownReach.clear();
+            ownReachBox = OverlapBox();
+            vx.clear(); vy.clear(); vUnrelated.clear();
+            ax.clear(); ay.clear(); bx.clear(); by.clear(); eAxis.clear(); eReach.clear();
+        }
+
+        void addOwn(int neighborID, double x, double y, bool isSource) {
+            nx.push_back(x); ny.push_back(y);
+            neighborIDs.push_back(neighborID);
+            ownIsSource.push_back(isSource);
+            OverlapBox reach;
+            for (int c = 0; c < static_cast<int>(cx.size()); ++c) {
+                reach.add(isSource ? reachBox(cx[c], cy[c], x, y) : reachBox(x, y, cx[c], cy[c]));
             }
+            ownReach.push_back(reach);
+            ownReachBox.add(reach);
+            spanBox.add(x, y);
         }
 
-        // 创建临时顶点（新位置）
-        BaseVertexProperty tempNewV = BaseVertexProperty(graph[VD]);
-        tempNewV.setCoord(newPos);
+        void offerVertex(int vertexID, double x, double y) {
+            bool nearCandidate = candidateBox.contains(x, y);
+            if (!nearCandidate && !ownReachBox.contains(x, y)) return;
+            bool unrelated = std::find(neighborIDs.begin(), neighborIDs.end(), vertexID) == neighborIDs.end();
+            if (!nearCandidate && !unrelated) return;
+            vx.push_back(x); vy.push_back(y);
+            vUnrelated.push_back(unrelated);
+        }
 
-        // 存储更新后的出边（用于检查）
-        std::deque<BaseVertexProperty> vertexStorage;
-        std::vector<BaseEdgeProperty> newOutEdges;
-        
-        for(BaseUGraphProperty::out_edge_iterator oeit = oep.first; oeit != oep.second; ++oeit) {
-            BaseVertexProperty tempSource = graph[*oeit].Source();
-            BaseVertexProperty tempTarget = graph[*oeit].Target();
+        void offerEdge(double x_A, double y_A, double x_B, double y_B, SegmentAxis axis) {
+            OverlapBox reach = reachBox(x_A, y_A, x_B, y_B);
+            if (!reach.intersects(spanBox)) return;
+            ax.push_back(x_A); ay.push_back(y_A); bx.push_back(x_B); by.push_back(y_B);
+            eAxis.push_back(axis);
+            eReach.push_back(reach);
+        }
 
-            if (tempSource.getID() == vertexID) {
-                tempSource.setCoord(newPos);
-            }
-            else {
-                tempTarget.setCoord(newPos);
-            }
-            
-            vertexStorage.push_back(tempSource);
-            vertexStorage.push_back(tempTarget);
-            
-            BaseEdgeProperty tempEdge(vertexStorage[vertexStorage.size()-2], 
-                                     vertexStorage[vertexStorage.size()-1], 
-                                     graph[*oeit].ID(), 
-                                     graph[*oeit].Angle());
-            newOutEdges.push_back(tempEdge);
-        }
-
-        // ============ 优化的重叠检查 ============
-        
-        // 1. V-V检查：只检查新位置附近的顶点
-        std::cout << "Checking overlap 1 (optimized)..." << std::endl;
-        std::vector<int> nearbyVertexIDs = spatialGrid->getNearbyVertices(newPos, 1);
-        
-        for (int nearbyVertexID : nearbyVertexIDs) {
-            if (nearbyVertexID == vertexID) continue;
-            
-            BaseUGraphProperty::vertex_descriptor nearbyVD = getVertexDescriptor(nearbyVertexID);
-            const BaseVertexProperty& nearbyVertex = graph[nearbyVD];
-            
-            if (VVOverlap(tempNewV, nearbyVertex)) {
-                std::cout << std::endl;
-                std::cout << "Checked vertex " << nearbyVertex.getID() << ": (" 
-                         << nearbyVertex.getCoord().x() << ", " << nearbyVertex.getCoord().y() << ")" << std::endl;
-                std::cout << "Current vertex " << tempNewV.getID() << ": (" 
-                         << tempNewV.getCoord().x() << ", " << tempNewV.getCoord().y() << ")" << std::endl;
-                std::cout << "VVOverlap(1) happens" << std::endl;
-                return true;
-            }
+        void test( void );
+    };
+
+    // h[c] |= candidate c strictly inside AB
+    template <SegmentAxis Axis>
+    static void markInside(std::uint64_t* h, const double* px, const double* py, int candidateNum,
+                           double x_A, double y_A, double x_B, double y_B) {
+        for (int c = 0; c < candidateNum; ++c) {
+            h[c] |= pointInsideSegment<Axis>(px[c], py[c], x_A, y_A, x_B, y_B);
         }
+    }
 
-        // 2.1. V-E检查：新顶点与附近的边
-        std::cout << "Checking overlap 2.1 (optimized)..." << std::endl;
-        std::vector<int> nearbyEdgeIDs = spatialGrid->getNearbyEdges(newPos, 1);
-        
-        for (int nearbyEdgeID : nearbyEdgeIDs) {
-            if (outEdgeIDs.find(nearbyEdgeID) != outEdgeIDs.end()) {
-                continue; // 跳过出边
-            }
-            
-            BaseUGraphProperty::edge_descriptor nearbyED = getEdgeDescriptor(nearbyEdgeID);
-            const BaseEdgeProperty& nearbyEdge = graph[nearbyED];
-            
-            if (VEOverlap(tempNewV, nearbyEdge)) {
-                std::cout << std::endl;
-                std::cout << "Current vertex: " << tempNewV.getCoord().x() << " " 
-                         << tempNewV.getCoord().y() << std::endl;
-                std::cout << "Checked edge source " << nearbyEdge.Source().getID() << ": (" 
-                         << nearbyEdge.Source().getCoord().x() << ", " 
-                         << nearbyEdge.Source().getCoord().y() << ")" << std::endl;
-                std::cout << "Checked edge target " << nearbyEdge.Target().getID() << ": (" 
-                         << nearbyEdge.Target().getCoord().x() << ", " 
-                         << nearbyEdge.Target().getCoord().y() << ")" << std::endl;
-                std::cout << "VEOverlap(2.1) happens" << std::endl;
-                return true;
-            }
+    // The generic predicate branches on AB alone, so the branch moves out of the loop
+    template <>
+    void markInside<AXIS_GENERIC>(std::uint64_t* h, const double* px, const double* py, int candidateNum,
+                                  double x_A, double y_A, double x_B, double y_B) {
+        const bool vertical = std::abs(x_A - x_B) < EPSILON;
+        const double* p = vertical ? py : px;
+        const double lo = vertical ? std::min(y_A, y_B) : std::min(x_A, x_B);
+        const double hi = vertical ? std::max(y_A, y_B) : std::max(x_A, x_B);
+        for (int c = 0; c < candidateNum; ++c) {
+            h[c] |= isCollinear(px[c], py[c], x_A, y_A, x_B, y_B) & (p[c] > lo) & (p[c] < hi);
         }
+    }
 
-        // 2.2. V-E检查：附近的顶点与新的出边
-        std::cout << "Checking overlap 2.2 (optimized)..." << std::endl;
-        for (const auto& newOutEdge : newOutEdges) {
-            // 获取这条边覆盖路径上的所有顶点
-            std::vector<int> verticesAlongEdge = spatialGrid->getVerticesAlongLine(
-                newOutEdge.Source().getCoord(), 
-                newOutEdge.Target().getCoord()
-            );
-            
-            for (int vertexAlongID : verticesAlongEdge) {
-                if (vertexAlongID == vertexID || 
-                    outVertexIDs.find(vertexAlongID) != outVertexIDs.end()) {
-                    continue; // 跳过当前顶点和出边相连的顶点
-                }
-                
-                BaseUGraphProperty::vertex_descriptor vAlongD = getVertexDescriptor(vertexAlongID);
-                const BaseVertexProperty& vertexAlong = graph[vAlongD];
-                
-                if (VEOverlap(vertexAlong, newOutEdge)) {
-                    std::cout << std::endl;
-                    std::cout << "Checked vertex " << vertexAlong.getID() << ": (" 
-                             << vertexAlong.getCoord().x() << ", " << vertexAlong.getCoord().y() << ")" << std::endl;
-                    std::cout << "Current edge source " << newOutEdge.Source().getID() << ": (" 
-                             << newOutEdge.Source().getCoord().x() << ", " 
-                             << newOutEdge.Source().getCoord().y() << ")" << std::endl;
-                    std::cout << "Current edge target " << newOutEdge.Target().getID() << ": (" 
-                             << newOutEdge.Target().getCoord().x() << ", " 
-                             << newOutEdge.Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "VEOverlap(2.2) happens" << std::endl;
-                    return true;
+    // h[c] |= the own edge between candidate c and N runs along AB; N is collinear with AB
+    template <SegmentAxis Axis>
+    static void markAlong(std::uint64_t* h, const double* px, const double* py, int candidateNum,
+                          double x_A, double y_A, double x_B, double y_B, double x_N, double y_N) {
+        for (int c = 0; c < candidateNum; ++c) {
+            h[c] |= segmentsOverlap<Axis>(x_A, y_A, x_B, y_B, px[c], py[c], x_N, y_N);
+        }
+    }
+
+    template <>
+    void markAlong<AXIS_GENERIC>(std::uint64_t* h, const double* px, const double* py, int candidateNum,
+                                 double x_A, double y_A, double x_B, double y_B, double x_N, double y_N) {
+        const bool vertical = std::abs(x_A - x_B) < EPSILON;
+        const double* p = vertical ? py : px;
+        const double lo = vertical ? std::min(y_A, y_B) : std::min(x_A, x_B);
+        const double hi = vertical ? std::max(y_A, y_B) : std::max(x_A, x_B);
+        const double q = vertical ? y_N : x_N;
+        for (int c = 0; c < candidateNum; ++c) {
+            double first = std::min(p[c], q), last = std::max(p[c], q);
+            h[c] |= isCollinear(px[c], py[c], x_A, y_A, x_B, y_B) & (first < hi) & (last > lo);
+        }
+    }
+
+    void OverlapBatchScratch::test( void ) {
+        const int candidateNum = static_cast<int>(cx.size());
+        const int ownNum = static_cast<int>(nx.size());
+        const double* px = cx.data();
+        const double* py = cy.data();
+        std::uint64_t* h = hit.data();
+
+        // 1. V-V and 2.2, per kept vertex
+        for (int k = 0; k < static_cast<int>(vx.size()); ++k) {
+            const double x = vx[k], y = vy[k];
+            for (int c = 0; c < candidateNum; ++c) {
+                h[c] |= (std::abs(x - px[c]) < EPSILON) & (std::abs(y - py[c]) < EPSILON);
+            }
+            if (!vUnrelated[k]) continue;
+            for (int j = 0; j < ownNum; ++j) {
+                if (!ownReach[j].contains(x, y)) continue;
+                const double x_N = nx[j], y_N = ny[j];
+                const bool isSource = ownIsSource[j];
+                for (int c = 0; c < candidateNum; ++c) {
+                    double x_A = isSource ? px[c] : x_N, y_A = isSource ? py[c] : y_N;
+                    double x_B = isSource ? x_N : px[c], y_B = isSource ? y_N : py[c];
+                    bool vertical = std::abs(x_A - x_B) < EPSILON;
+                    double p = vertical ? y : x;
+                    double lo = vertical ? std::min(y_A, y_B) : std::min(x_A, x_B);
+                    double hi = vertical ? std::max(y_A, y_B) : std::max(x_A, x_B);
+                    h[c] |= isCollinear(x, y, x_A, y_A, x_B, y_B) & (p > lo) & (p < hi);
                 }
             }
         }
 
-        // 3.1. E-E检查：新的出边与附近的其他边
-        std::cout << "Checking overlap 3.1 (optimized)..." << std::endl;
-        for (const BaseEdgeProperty& newOutEdge : newOutEdges) {
-            // 获取这条边路径上的所有边
-            std::vector<int> edgesAlongLine = spatialGrid->getEdgesAlongLine(
-                newOutEdge.Source().getCoord(),
-                newOutEdge.Target().getCoord()
-            );
-            
-            for (int edgeAlongID : edgesAlongLine) {
-                if (outEdgeIDs.find(edgeAlongID) != outEdgeIDs.end()) {
-                    continue; // 跳过出边
+        // 2.1 and 3.1, per kept edge, on the fast path of its axis
+        for (int k = 0; k < static_cast<int>(ax.size()); ++k) {
+            const double x_A = ax[k], y_A = ay[k], x_B = bx[k], y_B = by[k];
+            if (eReach[k].intersects(candidateBox)) {
+                switch (eAxis[k]) {
+                    case AXIS_HORIZONTAL:   markInside<AXIS_HORIZONTAL>(h, px, py, candidateNum, x_A, y_A, x_B, y_B); break;
+                    case AXIS_VERTICAL:     markInside<AXIS_VERTICAL>(h, px, py, candidateNum, x_A, y_A, x_B, y_B); break;
+                    default:                markInside<AXIS_GENERIC>(h, px, py, candidateNum, x_A, y_A, x_B, y_B);
                 }
-                
-                BaseUGraphProperty::edge_descriptor eAlongD = getEdgeDescriptor(edgeAlongID);
-                const BaseEdgeProperty& edgeAlong = graph[eAlongD];
-                
-                if (EEOverlap(edgeAlong, newOutEdge)) {
-                    std::cout << std::endl;
-                    std::cout << "Checked edge source " << edgeAlong.Source().getID() << ": (" 
-                             << edgeAlong.Source().getCoord().x() << ", " 
-                             << edgeAlong.Source().getCoord().y() << ")" << std::endl;
-                    std::cout << "Checked edge target " << edgeAlong.Target().getID() << ": (" 
-                             << edgeAlong.Target().getCoord().x() << ", " 
-                             << edgeAlong.Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "Current edge source " << newOutEdge.Source().getID() << ": (" 
-                             << newOutEdge.Source().getCoord().x() << ", " 
-                             << newOutEdge.Source().getCoord().y() << ")" << std::endl;
-                    std::cout << "Current edge target " << newOutEdge.Target().getID() << ": (" 
-                             << newOutEdge.Target().getCoord().x() << ", " 
-                             << newOutEdge.Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "EEOverlap(3.1) happens" << std::endl;
-                    return true;
+            }
+            for (int j = 0; j < ownNum; ++j) {
+                // the fixed endpoint of the own edge has to be on the line already
+                if (!isCollinear(nx[j], ny[j], x_A, y_A, x_B, y_B)) continue;
+                switch (eAxis[k]) {
+                    case AXIS_HORIZONTAL:   markAlong<AXIS_HORIZONTAL>(h, px, py, candidateNum, x_A, y_A, x_B, y_B, nx[j], ny[j]); break;
+                    case AXIS_VERTICAL:     markAlong<AXIS_VERTICAL>(h, px, py, candidateNum, x_A, y_A, x_B, y_B, nx[j], ny[j]); break;
+                    default:                markAlong<AXIS_GENERIC>(h, px, py, candidateNum, x_A, y_A, x_B, y_B, nx[j], ny[j]);
                 }
             }
         }
 
-        // 3.2. E-E检查：新的出边之间的重叠
-        std::cout << "Checking overlap 3.2 (optimized)..." << std::endl;
-        for (size_t i = 0; i < newOutEdges.size(); ++i) {
-            for (size_t j = i + 1; j < newOutEdges.size(); ++j) {
-                if (EEOverlap(newOutEdges[i], newOutEdges[j])) {
-                    std::cout << std::endl;
-                    std::cout << newOutEdges[i].Source().getID() << ": (" 
-                             << newOutEdges[i].Source().getCoord().x() << ", " 
-                             << newOutEdges[i].Source().getCoord().y() << ")" << std::endl;
-                    std::cout << newOutEdges[i].Target().getID() << ": (" 
-                             << newOutEdges[i].Target().getCoord().x() << ", " 
-                             << newOutEdges[i].Target().getCoord().y() << ")" << std::endl;
-                    std::cout << newOutEdges[j].Source().getID() << ": (" 
-                             << newOutEdges[j].Source().getCoord().x() << ", " 
-                             << newOutEdges[j].Source().getCoord().y() << ")" << std::endl;
-                    std::cout << newOutEdges[j].Target().getID() << ": (" 
-                             << newOutEdges[j].Target().getCoord().x() << ", " 
-                             << newOutEdges[j].Target().getCoord().y() << ")" << std::endl;
-                    std::cout << "EEOverlap(3.2) happens" << std::endl;
-                    return true;
+        // 3.2. the own edges against each other, for the candidates still free
+        if (ownNum < 2) return;
+        for (int c = 0; c < candidateNum; ++c) {
+            if (h[c]) continue;
+            for (int i = 0; i < ownNum && !h[c]; ++i) {
+                double x_A = ownIsSource[i] ? px[c] : nx[i], y_A = ownIsSource[i] ? py[c] : ny[i];
+                double x_B = ownIsSource[i] ? nx[i] : px[c], y_B = ownIsSource[i] ? ny[i] : py[c];
+                for (int j = 0; j < ownNum; ++j) {
+                    if (i == j) continue;
+                    double x_C = ownIsSource[j] ? px[c] : nx[j], y_C = ownIsSource[j] ? py[c] : ny[j];
+                    double x_D = ownIsSource[j] ? nx[j] : px[c], y_D = ownIsSource[j] ? ny[j] : py[c];
+                    if (segmentsOverlap(segmentAxis(x_A, y_A, x_B, y_B), x_A, y_A, x_B, y_B, x_C, y_C, x_D, y_D)) {
+                        h[c] = 1;
+                        break;
+                    }
                 }
             }
         }
-        
-        return false;
     }
-}
\ No newline at end of file
+
+    static boost::dynamic_bitset<> batchResult(const OverlapBatchScratch& scratch) {
+        boost::dynamic_bitset<> overlaps(scratch.hit.size());
+        for (std::size_t c = 0; c < scratch.hit.size(); ++c) {
+            if (scratch.hit[c]) overlaps.set(c);
+        }
+        return overlaps;
+    }
+
+    boost::dynamic_bitset<> overlapBatch(const OverlapGeometry& geometry, int vertexID, Span<Coord2> candidates) {
+        static thread_local OverlapBatchScratch scratch;
+        const int v = geometry.indexOf(vertexID);
+        scratch.reset(candidates);
+        if (candidates.empty()) return boost::dynamic_bitset<>();
+
+        const std::vector<int>& sources = geometry.sources;
+        const std::vector<int>& targets = geometry.targets;
+        for (int k = geometry.incidentOffsets[v]; k < geometry.incidentOffsets[v + 1]; ++k) {
+            int e = geometry.incidentEdges[k];
+            int other = sources[e] == v ? targets[e] : sources[e];
+            scratch.addOwn(geometry.vertexIDs[other], geometry.xs[other], geometry.ys[other], sources[e] == v);
+        }
+        for (int u = 0; u < geometry.vertexNum(); ++u) {
+            if (u != v) scratch.offerVertex(geometry.vertexIDs[u], geometry.xs[u], geometry.ys[u]);
+        }
+        for (int e = 0; e < geometry.edgeNum(); ++e) {
+            if (sources[e] == v || targets[e] == v) continue;
+            scratch.offerEdge(geometry.xs[sources[e]], geometry.ys[sources[e]], geometry.xs[targets[e]], geometry.ys[targets[e]],
+                              geometry.axes[e]);
+        }
+        scratch.test();
+        return batchResult(scratch);
+    }
+
+    boost::dynamic_bitset<> overlapBatch(int vertexID, Span<Coord2> candidates, const BaseUGraphProperty& graph) {
+        static thread_local OverlapBatchScratch scratch;
+        scratch.reset(candidates);
+        if (candidates.empty()) return boost::dynamic_bitset<>();
+
+        BaseUGraphProperty::vertex_descriptor VD = getVertexDescriptor(vertexID);
+        auto oep = boost::out_edges(VD, graph);
+        for (auto oeit = oep.first; oeit != oep.second; ++oeit) {
+            const BaseEdgeProperty& edge = graph[*oeit];
+            bool isSource = edge.Source().getID() == vertexID;
+            const BaseVertexProperty& other = isSource ? edge.Target() : edge.Source();
+            scratch.addOwn(other.getID(), other.getCoord().x(), other.getCoord().y(), isSource);
+        }
+        auto vp = boost::vertices(graph);
+        for (auto vit = vp.first; vit != vp.second; ++vit) {
+            const BaseVertexProperty& vertex = graph[*vit];
+            if (vertex.getID() != vertexID) scratch.offerVertex(vertex.getID(), vertex.getCoord().x(), vertex.getCoord().y());
+        }
+        auto ep = boost::edges(graph);
+        for (auto eit = ep.first; eit != ep.second; ++eit) {
+            const BaseEdgeProperty& edge = graph[*eit];
+            if (edge.Source().getID() == vertexID || edge.Target().getID() == vertexID) continue;
+            const Coord2& A = edge.Source().getCoord();
+            const Coord2& B = edge.Target().getCoord();
+            scratch.offerEdge(A.x(), A.y(), B.x(), B.y(), segmentAxis(A.x(), A.y(), B.x(), B.y()));
+        }
+        scratch.test();
+        return batchResult(scratch);
+    }
+}
@@ -0,0 +1,126 @@
+//------------------------------------------------------------------------------
+// Clustering1D.cpp - Exact optimal k-means clustering of 1D data
+//------------------------------------------------------------------------------
+
+#include "Clustering1D.h"
+#include <algorithm>
+#include <limits>
+#include <functional>
+
+namespace Map {
+
+    // Row ranges below this size are never split into pool tasks
+    const int PARALLEL_ROW_MIN = 4096;
+
+    Clustering1D::Clustering1D(const std::vector<double>& sortedValues, int maxK, ThreadPool* pool):
+        shift(0.0), maxK(0), pool(pool) {
+
+        const int n = static_cast<int>(sortedValues.size());
+        if (n == 0) {
+            optimalWCSS.assign(1, 0.0);
+            return;
+        }
+        this->maxK = std::max(1, std::min(maxK, n));
+
+        shift = sortedValues[n / 2];
+        values.resize(n);
+        prefix1.assign(n + 1, 0.0);
+        prefix2.assign(n + 1, 0.0);
+        for (int i = 0; i < n; ++i) {
+            values[i] = sortedValues[i] - shift;
+            prefix1[i + 1] = prefix1[i] + values[i];
+            prefix2[i + 1] = prefix2[i] + values[i] * values[i];
+        }
+
+        // One sweep over all k with two rolling rows
+        optimalWCSS.assign(this->maxK + 1, 0.0);
+        std::vector<double> prev, cur(n);
+        for (int k = 1; k <= this->maxK; ++k) {
+            fillRow(prev, cur, nullptr, k, k - 1, n - 1, k - 1, n - 1, 0);
+            optimalWCSS[k] = cur[n - 1];
+            std::swap(prev, cur);
+            cur.assign(n, 0.0);
+        }
+    }
+
+    double Clustering1D::cost(int j, int i) const {
+        double count = i - j + 1;
+        double sum = prefix1[i + 1] - prefix1[j];
+        double sumSq = prefix2[i + 1] - prefix2[j];
+        return std::max(0.0, sumSq - sum * sum / count);
+    }
+
+    void Clustering1D::fillRow(const std::vector<double>& prev, std::vector<double>& cur, std::vector<int>* split,
+                               int k, int lo, int hi, int optLo, int optHi, int depth) const {
+        if (lo > hi) {
+            return;
+        }
+        int mid = lo + (hi - lo) / 2;
+
+        // the last cluster is values[j..mid]; k - 1 clusters must fit in values[0..j-1]
+        double best = std::numeric_limits<double>::max();
+        int bestJ = std::max(optLo, k - 1);
+        for (int j = std::max(optLo, k - 1); j <= std::min(mid, optHi); ++j) {
+            double value = (k == 1) ? cost(0, mid) : prev[j - 1] + cost(j, mid);
+            if (value < best) {
+                best = value;
+                bestJ = j;
+            }
+            if (k == 1) break;
+        }
+        cur[mid] = best;
+        if (split) {
+            (*split)[mid] = bestJ;
+        }
+
+        // the halves write disjoint ranges of cur / split
+        if (pool && hi - lo >= PARALLEL_ROW_MIN && (1u << depth) < pool->concurrency()) {
+            std::vector<std::function<void()>> halves;
+            halves.emplace_back([&] { fillRow(prev, cur, split, k, lo, mid - 1, optLo, bestJ, depth + 1); });
+            halves.emplace_back([&] { fillRow(prev, cur, split, k, mid + 1, hi, bestJ, optHi, depth + 1); });
+            pool->run(halves);
+            return;
+        }
+        fillRow(prev, cur, split, k, lo, mid - 1, optLo, bestJ, depth + 1);
+        fillRow(prev, cur, split, k, mid + 1, hi, bestJ, optHi, depth + 1);
+    }
+
+    void Clustering1D::solveRows(int k, std::vector<double>& last, std::vector<std::vector<int>>* splits) const {
+        const int n = static_cast<int>(values.size());
+        std::vector<double> prev, cur(n);
+        for (int r = 1; r <= k; ++r) {
+            std::vector<int>* split = nullptr;
+            if (splits) {
+                (*splits)[r].assign(n, 0);
+                split = &(*splits)[r];
+            }
+            fillRow(prev, cur, split, r, r - 1, n - 1, r - 1, n - 1, 0);
+            std::swap(prev, cur);
+            cur.assign(n, 0.0);
+        }
+        last = prev;
+    }
+
+    std::vector<double> Clustering1D::getCenters(int k) const {
+        const int n = static_cast<int>(values.size());
+        if (n == 0 || k < 1) {
+            return {};
+        }
+        k = std::min(k, maxK);
+
+        std::vector<std::vector<int>> splits(k + 1);
+        std::vector<double> last;
+        solveRows(k, last, &splits);
+
+        // Walk the split points back from the last value
+        std::vector<double> centers(k);
+        int end = n - 1;
+        for (int r = k; r >= 1; --r) {
+            int start = splits[r][end];
+            centers[r - 1] = (prefix1[end + 1] - prefix1[start]) / (end - start + 1) + shift;
+            end = start - 1;
+        }
+        return centers;
+    }
+
+} // namespace Map
@@ -6,20 +6,46 @@
 #include <stdexcept>
 
 namespace Map {
+
+    // Mapping installed by ScopedDescriptorMapping on this thread, nullptr for the global maps
+    static thread_local const DescriptorMapping* threadMapping = nullptr;
     
     boost::graph_traits<BaseUGraphProperty>::vertex_descriptor getVertexDescriptor(int vertexID) {
-        auto it = vertexID2Desc.find(vertexID);
-        if (it != vertexID2Desc.end()) {
+        const auto& id2Desc = threadMapping ? threadMapping->vertexID2Desc : vertexID2Desc;
+        auto it = id2Desc.find(vertexID);
+        if (it != id2Desc.end()) {
             return it->second;
         }
         throw std::runtime_error("Vertex ID not found in global mapping");
     }
     
     boost::graph_traits<BaseUGraphProperty>::edge_descriptor getEdgeDescriptor(int edgeID) {
-        auto it = edgeID2Desc.find(edgeID);
-        if (it != edgeID2Desc.end()) {
+        const auto& id2Desc = threadMapping ? threadMapping->edgeID2Desc : edgeID2Desc;
+        auto it = id2Desc.find(edgeID);
+        if (it != id2Desc.end()) {
             return it->second;
         }
         throw std::runtime_error("Edge ID not found in global mapping");
     }
-} // namespace Map
\ No newline at end of file
+
+    DescriptorMapping buildDescriptorMapping(const BaseUGraphProperty& graph) {
+        DescriptorMapping mapping;
+        auto vp = boost::vertices(graph);
+        for (auto vit = vp.first; vit != vp.second; ++vit) {
+            mapping.vertexID2Desc[graph[*vit].getID()] = *vit;
+        }
+        auto ep = boost::edges(graph);
+        for (auto eit = ep.first; eit != ep.second; ++eit) {
+            mapping.edgeID2Desc[graph[*eit].ID()] = *eit;
+        }
+        return mapping;
+    }
+
+    ScopedDescriptorMapping::ScopedDescriptorMapping(const DescriptorMapping& mapping): previous(threadMapping) {
+        threadMapping = &mapping;
+    }
+
+    ScopedDescriptorMapping::~ScopedDescriptorMapping() {
+        threadMapping = previous;
+    }
+} // namespace Map
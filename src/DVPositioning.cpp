@@ -9,23 +9,50 @@
 #include "DynamicGrid.h"
 #include "MapFileReader.h"
 #include "VisualizeSVG.h"
+#include "MinCostFlow.h"
+#include "ThreadPool.h"
 
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <limits>
 #include <map>
+#include <set>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 
 #define EPSILON 1e-2
 
 namespace Map {
 
+    // Parameter settings for dangling vertex positioning
+    const DVPositioningMethod   DV_POSITIONING_METHOD = GREEDY_ADJACENT_LINES;  // Current method
+    const double                DV_ASSIGNMENT_RADIUS_FACTOR = 1.0;      // MIN_COST_ASSIGNMENT: search radius / average edge length
+    const int                   DV_ASSIGNMENT_MAX_CANDIDATES = 8;       // MIN_COST_ASSIGNMENT: nearest free intersections per vertex
+    const int                   DV_ASSIGNMENT_MAX_ROUNDS = 4;           // MIN_COST_ASSIGNMENT: re-assignments after rejected moves
+    const int                   DV_INTERSECTION_CANDIDATES = 4;         // Nearest free intersections tried before a new line (0: none)
+    const double                DV_INTERSECTION_MAX_DISTANCE = 100.0;   // Their search radius in map units
+    const int                   DV_INTERSECTION_MAX_PROBES = 32;        // Intersections looked at per search
+    const bool                  USE_SPECULATIVE_DV_POSITIONING = true;  // Greedy passes planned in parallel on ThreadPool::shared()
+    const int                   DV_SPECULATION_BATCH = 256;             // Vertices planned against the same layout
+    const double                DV_SPECULATION_MARGIN = 1.0;            // Footprint padding, above the membership / overlap tolerances
+    const bool                  LOG_DV_PLANNING = false;                // Per-vertex planning log; planning runs on pool workers
+
     // Find all dangling vertices in the graph (not on auxiliary line intersections)
     // Returns vertices sorted by degree (descending order) so high-impact vertices are processed first
+    // The grid keeps this list incrementally; without its occupancy table the lines are searched
     std::vector<int> findDVs(const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+        if (grid.hasOccupancy()) {
+            return grid.getDanglingVertices();
+        }
+
         std::vector<int> DVIDList;
-        std::vector<double> hPositions = grid.getHALPositions();
-        std::vector<double> vPositions = grid.getVALPositions();
+        const AxisLineIndex& hIndex = grid.getHALIndex();
+        const AxisLineIndex& vIndex = grid.getVALIndex();
         
         auto vp = boost::vertices(graph);
         for (auto vit = vp.first; vit != vp.second; ++vit) {
@@ -33,18 +60,8 @@ namespace Map {
             int vertexID = vertex.getID();
             Coord2 pos = vertex.getCoord();
             
-            bool isOnIntersection = false;
-            for (double hPos : hPositions) {
-                if (std::abs(pos.y() - hPos) < EPSILON) {
-                    for (double vPos : vPositions) {
-                        if (std::abs(pos.x() - vPos) < EPSILON) {
-                            isOnIntersection = true;
-                            break;
-                        }
-                    }
-                    if (isOnIntersection) break;
-                }
-            }
+            bool isOnIntersection = hIndex.firstWithin(pos.y(), EPSILON) >= 0 &&
+                                    vIndex.firstWithin(pos.x(), EPSILON) >= 0;
             
             if (!isOnIntersection) {
                 // the vertex does not locate on any intersections
@@ -62,47 +79,80 @@ namespace Map {
         return DVIDList;
     }
     
+    // Whether a dangling vertex blocks the way from a vertex to a neighboring line: one sharing
+    // its column (row) strictly between the two positions. O(log n) from the grid's ordered
+    // column / row indexes; without an occupancy table, one findDVs pass plus a vertex scan.
+    class DanglingBlockers {
+    private:
+        const DynamicGrid&          grid;
+        const BaseUGraphProperty&   graph;
+        std::unordered_set<int>     danglingIDs;
+
+        bool scan(bool inColumn, double fixed, double lo, double hi) const {
+            if (lo >= hi) return false;
+            auto vp = boost::vertices(graph);
+            for (auto vit = vp.first; vit != vp.second; ++vit) {
+                Coord2 pos = graph[*vit].getCoord();
+                double across = inColumn ? pos.x() : pos.y();
+                double along = inColumn ? pos.y() : pos.x();
+                if (std::abs(across - fixed) < BLOCKER_EPSILON && along > lo && along < hi &&
+                    danglingIDs.count(graph[*vit].getID())) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    public:
+        static constexpr double BLOCKER_EPSILON = 1e-6;
+
+        DanglingBlockers(const DynamicGrid& grid, const BaseUGraphProperty& graph): grid(grid), graph(graph) {
+            if (!grid.hasOccupancy()) {
+                std::vector<int> DVIDList = findDVs(grid, graph);
+                danglingIDs.insert(DVIDList.begin(), DVIDList.end());
+            }
+        }
+
+        bool inColumn(double x, double lo, double hi) const {
+            return grid.hasOccupancy() ? grid.danglingInColumn(x, lo, hi, BLOCKER_EPSILON) : scan(true, x, lo, hi);
+        }
+
+        bool inRow(double y, double lo, double hi) const {
+            return grid.hasOccupancy() ? grid.danglingInRow(y, lo, hi, BLOCKER_EPSILON) : scan(false, y, lo, hi);
+        }
+    };
+
     // Check if vertex is on any horizontal auxiliary line
     bool isOnHAL(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+        if (grid.hasOccupancy()) return grid.horizontalLineOf(vertexID) >= 0;
         auto vertexDesc = getVertexDescriptor(vertexID);
         Coord2 pos = graph[vertexDesc].getCoord();
 
-        std::vector<double> hPositions = grid.getHALPositions();
-        for (double hPos : hPositions) {
-            if (std::abs(pos.y() - hPos) < EPSILON) {
-                return true;
-            }
-        }
-        return false;
+        return grid.getHALIndex().firstWithin(pos.y(), EPSILON) >= 0;
     }
     
     // Check if vertex is on any vertical auxiliary line
     bool isOnVAL(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+        if (grid.hasOccupancy()) return grid.verticalLineOf(vertexID) >= 0;
         auto vertexDesc = getVertexDescriptor(vertexID);
         Coord2 pos = graph[vertexDesc].getCoord();
 
-        std::vector<double> vPositions = grid.getVALPositions();
-        for (double vPos : vPositions) {
-            if (std::abs(pos.x() - vPos) < EPSILON) {
-                return true;
-            }
-        }
-        return false;
+        return grid.getVALIndex().firstWithin(pos.x(), EPSILON) >= 0;
     }
     
     //---------------------------------------------------------------------------------------------------------
     //  Get adjacent auxiliary lines
     //---------------------------------------------------------------------------------------------------------
 
-    std::vector<AuxiliaryLine> getAdjHALs(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+    std::vector<AuxiliaryLine> getAdjHALs(int vertexID, const Coord2& pos, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
 
         std::vector<AuxiliaryLine> adjHALs;
         bool flagN = true, flagS = true; // flagN: above all ALs; flagS: below all ALs
 
         BaseUGraphProperty::vertex_descriptor vertexDesc = getVertexDescriptor(vertexID);
-        double currentX = graph[vertexDesc].getCoord().x();
-        double currentY = graph[vertexDesc].getCoord().y();
-        std::cout << "Initial X: " << currentX << " Initial Y: " << currentY << std::endl;
+        double currentX = pos.x();
+        double currentY = pos.y();
+        if (LOG_DV_PLANNING) std::cout << "Initial X: " << currentX << " Initial Y: " << currentY << std::endl;
 
         for (const AuxiliaryLine& hline: grid.getHorizontalAuxLines()) {
             if (currentY < hline.getPosition()) {
@@ -116,81 +166,41 @@ namespace Map {
             }
         }
 
-        auto vp = boost::vertices(graph);
-        std::vector<int> DVIDList = findDVs(grid, graph);
-        bool flag = true;
+        DanglingBlockers blockers(grid, graph);
 
         if (flagN) {
-            for (BaseUGraphProperty::vertex_iterator vit = vp.first; vit != vp.second; ++vit) {
-                auto it = std::find(DVIDList.begin(), DVIDList.end(), graph[*vit].getID());
-                if (it != DVIDList.end()) { // the vertex is dangling
-                    BaseUGraphProperty::vertex_descriptor tempVertexDesc = getVertexDescriptor(*it);
-                    if (std::abs(graph[tempVertexDesc].getCoord().x() - currentX) < 1e-6 &&
-                        graph[tempVertexDesc].getCoord().y() > currentY && 
-                        graph[tempVertexDesc].getCoord().y() < grid.getHorizontalAuxLines()[0].getPosition()) {
-                        flag = false;
-                        std::cout << "Vertex " << graph[vertexDesc].getID() << " has no adjacent HALs" << std::endl;
-                    }
-                }
+            if (blockers.inColumn(currentX, currentY, grid.getHorizontalAuxLines()[0].getPosition())) {
+                if (LOG_DV_PLANNING) std::cout << "Vertex " << graph[vertexDesc].getID() << " has no adjacent HALs" << std::endl;
             }
-            if (flag) {
+            else {
                 adjHALs.push_back(grid.getHorizontalAuxLines()[0]);
             }
         }
         else if (flagS) {
-            for (BaseUGraphProperty::vertex_iterator vit = vp.first; vit != vp.second; ++vit) {
-                auto it = std::find(DVIDList.begin(), DVIDList.end(), graph[*vit].getID());
-                if (it != DVIDList.end()) { // the vertex is dangling
-                    BaseUGraphProperty::vertex_descriptor tempVertexDesc = getVertexDescriptor(*it);
-                    if (std::abs(graph[tempVertexDesc].getCoord().x() - currentX) < 1e-6 &&
-                        graph[tempVertexDesc].getCoord().y() < currentY && 
-                        graph[tempVertexDesc].getCoord().y() > grid.getHorizontalAuxLines().back().getPosition()) {
-                        flag = false;
-                        std::cout << "Vertex " << graph[vertexDesc].getID() << " has no adjacent HALs" << std::endl;
-                    }
-                }
+            if (blockers.inColumn(currentX, grid.getHorizontalAuxLines().back().getPosition(), currentY)) {
+                if (LOG_DV_PLANNING) std::cout << "Vertex " << graph[vertexDesc].getID() << " has no adjacent HALs" << std::endl;
             }
-            if (flag) {
+            else {
                 adjHALs.push_back(grid.getHorizontalAuxLines().back());
             }
         }
         else if (!flagN && !flagS) {
 
+            // cand1 / cand2 are copies, so inserts into the grid cannot shift them
             AuxiliaryLine cand1, cand2;
-            double index1, index2;
-            bool flag1 = true, flag2 = true;
 
             for (int i = 0; i < grid.getHorizontalAuxLines().size(); i++) {
                 if (currentY < grid.getHorizontalAuxLines()[i].getPosition()) { // find the adjacent lines to be further selected
                     cand1 = grid.getHorizontalAuxLines()[i-1];
                     cand2 = grid.getHorizontalAuxLines()[i];
-                    index1 = i-1;
-                    index2 = i;
                     break;
                 }
             }
 
-            for (BaseUGraphProperty::vertex_iterator vit = vp.first; vit != vp.second; ++vit) {
-                auto it = std::find(DVIDList.begin(), DVIDList.end(), graph[*vit].getID());
-                if (it != DVIDList.end()) {
-                    BaseUGraphProperty::vertex_descriptor tempVertexDesc = getVertexDescriptor(*it);
-                    if (std::abs(graph[tempVertexDesc].getCoord().x() - currentX) < 1e-6 &&
-                        graph[tempVertexDesc].getCoord().y() < currentY && 
-                        graph[tempVertexDesc].getCoord().y() > grid.getHorizontalAuxLines()[index1].getPosition()) {
-                        flag1 = false;
-                    } else if (
-                        std::abs(graph[tempVertexDesc].getCoord().x() - currentX) < 1e-6 &&
-                        graph[tempVertexDesc].getCoord().y() > currentY && 
-                        graph[tempVertexDesc].getCoord().y() < grid.getHorizontalAuxLines()[index2].getPosition()) {
-                        flag2 = false;
-                    }
-                }
-            }
-
-            if (flag1) {
+            if (!blockers.inColumn(currentX, cand1.getPosition(), currentY)) {
                 adjHALs.push_back(cand1);
             }
-            if (flag2) {
+            if (!blockers.inColumn(currentX, currentY, cand2.getPosition())) {
                 adjHALs.push_back(cand2);
             }
         }
@@ -201,15 +211,19 @@ namespace Map {
 
         return adjHALs;
     }
+
+    std::vector<AuxiliaryLine> getAdjHALs(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+        return getAdjHALs(vertexID, graph[getVertexDescriptor(vertexID)].getCoord(), grid, graph);
+    }
     
-    std::vector<AuxiliaryLine> getAdjVALs(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+    std::vector<AuxiliaryLine> getAdjVALs(int vertexID, const Coord2& pos, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
 
         std::vector<AuxiliaryLine> adjVALs;
         bool flagW = true, flagE = true; 
 
         BaseUGraphProperty::vertex_descriptor vertexDesc = getVertexDescriptor(vertexID);
-        double currentX = graph[vertexDesc].getCoord().x();
-        double currentY = graph[vertexDesc].getCoord().y();
+        double currentX = pos.x();
+        double currentY = pos.y();
         for (const AuxiliaryLine& vline: grid.getVerticalAuxLines()) {
             if (currentX < vline.getPosition()) {
                 flagE = false;
@@ -222,81 +236,41 @@ namespace Map {
             }
         }
 
-        auto vp = boost::vertices(graph);
-        std::vector<int> DVIDList = findDVs(grid, graph);
-        bool flag = true;
+        DanglingBlockers blockers(grid, graph);
 
         if (flagW) {
-            for (BaseUGraphProperty::vertex_iterator vit = vp.first; vit != vp.second; ++vit) {
-                auto it = std::find(DVIDList.begin(), DVIDList.end(), graph[*vit].getID());
-                if (it != DVIDList.end()) { // the vertex is dangling
-                    BaseUGraphProperty::vertex_descriptor tempVertexDesc = getVertexDescriptor(*it);
-                    if (std::abs(graph[tempVertexDesc].getCoord().y() - currentY) < 1e-6 &&
-                        graph[tempVertexDesc].getCoord().x() > currentX && 
-                        graph[tempVertexDesc].getCoord().x() < grid.getVerticalAuxLines()[0].getPosition()) {
-                        flag = false;
-                        std::cout << "Vertex " << graph[vertexDesc].getID() << " has no adjacent VALs" << std::endl;
-                    }
-                }
+            if (blockers.inRow(currentY, currentX, grid.getVerticalAuxLines()[0].getPosition())) {
+                if (LOG_DV_PLANNING) std::cout << "Vertex " << graph[vertexDesc].getID() << " has no adjacent VALs" << std::endl;
             }
-            if (flag) {
+            else {
                 adjVALs.push_back(grid.getVerticalAuxLines()[0]);
             }
         }
         else if (flagE) {
-            for (BaseUGraphProperty::vertex_iterator vit = vp.first; vit != vp.second; ++vit) {
-                auto it = std::find(DVIDList.begin(), DVIDList.end(), graph[*vit].getID());
-                if (it != DVIDList.end()) { // the vertex is dangling
-                    BaseUGraphProperty::vertex_descriptor tempVertexDesc = getVertexDescriptor(*it);
-                    if (std::abs(graph[tempVertexDesc].getCoord().y() - currentY) < 1e-6 &&
-                        graph[tempVertexDesc].getCoord().x() < currentX && 
-                        graph[tempVertexDesc].getCoord().x() > grid.getVerticalAuxLines().back().getPosition()) {
-                        flag = false;
-                        std::cout << "Vertex " << graph[vertexDesc].getID() << " has no adjacent VALs" << std::endl;
-                    }
-                }
+            if (blockers.inRow(currentY, grid.getVerticalAuxLines().back().getPosition(), currentX)) {
+                if (LOG_DV_PLANNING) std::cout << "Vertex " << graph[vertexDesc].getID() << " has no adjacent VALs" << std::endl;
             }
-            if (flag) {
+            else {
                 adjVALs.push_back(grid.getVerticalAuxLines().back());
             }
         }
         else if (!flagW && !flagE) {
 
+            // cand1 / cand2 are copies, so inserts into the grid cannot shift them
             AuxiliaryLine cand1, cand2;
-            double index1, index2;
-            bool flag1 = true, flag2 = true;
 
             for (int i = 0; i < grid.getVerticalAuxLines().size(); i++) {
                 if (currentX < grid.getVerticalAuxLines()[i].getPosition()) { // find the adjacent lines to be further selected
                     cand1 = grid.getVerticalAuxLines()[i-1];
                     cand2 = grid.getVerticalAuxLines()[i];
-                    index1 = i-1;
-                    index2 = i;
                     break;
                 }
             }
 
-            for (BaseUGraphProperty::vertex_iterator vit = vp.first; vit != vp.second; ++vit) {
-                auto it = std::find(DVIDList.begin(), DVIDList.end(), graph[*vit].getID());
-                if (it != DVIDList.end()) {
-                    BaseUGraphProperty::vertex_descriptor tempVertexDesc = getVertexDescriptor(*it);
-                    if (std::abs(graph[tempVertexDesc].getCoord().y() - currentY) < 1e-6 &&
-                        graph[tempVertexDesc].getCoord().x() < currentX && 
-                        graph[tempVertexDesc].getCoord().x() > grid.getVerticalAuxLines()[index1].getPosition()) {
-                        flag1 = false;
-                    } else if (
-                        std::abs(graph[tempVertexDesc].getCoord().y() - currentY) < 1e-6 &&
-                        graph[tempVertexDesc].getCoord().x() > currentX && 
-                        graph[tempVertexDesc].getCoord().x() < grid.getVerticalAuxLines()[index2].getPosition()) {
-                        flag2 = false;
-                    }
-                }
-            }
-
-            if (flag1) {
+            if (!blockers.inRow(currentY, cand1.getPosition(), currentX)) {
                 adjVALs.push_back(cand1);
             }
-            if (flag2) {
+            if (!blockers.inRow(currentY, currentX, cand2.getPosition())) {
                 adjVALs.push_back(cand2);
             }
         }
@@ -307,6 +281,10 @@ namespace Map {
 
         return adjVALs;
     }
+
+    std::vector<AuxiliaryLine> getAdjVALs(int vertexID, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+        return getAdjVALs(vertexID, graph[getVertexDescriptor(vertexID)].getCoord(), grid, graph);
+    }
     
     //---------------------------------------------------------------------------------------------------------
     //  Add auxiliary lines
@@ -324,189 +302,539 @@ namespace Map {
     //  Process dangling vertices
     //---------------------------------------------------------------------------------------------------------
 
-    void processPDV(int vertexID, DynamicGrid& grid, BaseUGraphProperty& graph) {
-
-        BaseUGraphProperty::vertex_descriptor vertexDesc = getVertexDescriptor(vertexID);
-        Coord2 pos = graph[vertexDesc].getCoord();
-        double X_result;
-        double Y_result;
+    // False if a vertex other than vertexID is on the intersection of the two lines (handles);
+    // such a move would stack two vertices, so it is rejected before the full overlap check
+    static bool intersectionFree(int vertexID, int hLine, int vLine, const DynamicGrid& grid) {
+        return !grid.hasOccupancy() || grid.isIntersectionFree(hLine, vLine, vertexID);
+    }
 
-        if (isOnHAL(vertexID, grid, graph)) {
-            double currentX = pos.x();
-            std::vector<AuxiliaryLine> adjVALs = getAdjVALs(vertexID, grid, graph);
-            double minDistance = std::numeric_limits<double>::max();
-            double bestX = currentX;
-
-            bool flag = false;
-            for (int i = 0; i < adjVALs.size(); ++i) {
-                const AuxiliaryLine& adjVAL = adjVALs[i];
-                Coord2 newPos = Coord2(adjVAL.getPosition(), pos.y());
-
-                if (!overlapHappens(vertexID, newPos, graph)) { // there is no overlap!
-                    flag = true;
-                    double dist = std::abs(currentX - adjVAL.getPosition());
-                    if (dist < minDistance) {
-                        minDistance = dist;
-                        bestX = adjVAL.getPosition();
-                    }
-                }
-                else {
-                    continue;
-                }
+    // For each candidate line, whether moving the vertex from pos onto it (across the line's
+    // axis only) is free of overlaps. keptLine is the handle of the vertex's line on the other
+    // axis. Occupied intersections are rejected first; the other candidates share one batched
+    // overlap query instead of one full check each.
+    static std::vector<bool> feasibleCandidates(int vertexID, const Coord2& pos,
+                                                const std::vector<AuxiliaryLine>& candidates, int keptLine,
+                                                const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+        std::vector<bool> feasible(candidates.size(), false);
+        std::vector<Coord2> positions;
+        std::vector<int> checked;
+        for (int i = 0; i < candidates.size(); ++i) {
+            const AuxiliaryLine& line = candidates[i];
+            int hLine = line.getIsHorizontal() ? DynamicGrid::lineHandle(line) : keptLine;
+            int vLine = line.getIsHorizontal() ? keptLine : DynamicGrid::lineHandle(line);
+            if (!intersectionFree(vertexID, hLine, vLine, grid)) {
+                if (LOG_DV_PLANNING) std::cout << "The intersection is occupied!" << std::endl;
+                continue;
             }
+            positions.push_back(line.getIsHorizontal() ? Coord2(pos.x(), line.getPosition())
+                                                       : Coord2(line.getPosition(), pos.y()));
+            checked.push_back(i);
+        }
+
+        boost::dynamic_bitset<> overlaps = overlapBatch(vertexID, Span<Coord2>(positions), graph);
+        for (int k = 0; k < checked.size(); ++k) {
+            feasible[checked[k]] = !overlaps[k];
+        }
+        return feasible;
+    }
+
+    // Closed axis-aligned box, empty until a point is added
+    struct DVRegion {
+        double  xMin, xMax, yMin, yMax;
 
-            // update the vertex position
-            if (flag) {
-                X_result = bestX;
-                Y_result = pos.y();
-                graph[vertexDesc].setCoord(bestX, pos.y());
+        DVRegion( void ): xMin(std::numeric_limits<double>::max()), xMax(std::numeric_limits<double>::lowest()),
+                          yMin(std::numeric_limits<double>::max()), yMax(std::numeric_limits<double>::lowest()) {}
+
+        void add(const Coord2& p) {
+            xMin = std::min(xMin, p.x()); xMax = std::max(xMax, p.x());
+            yMin = std::min(yMin, p.y()); yMax = std::max(yMax, p.y());
+        }
+        void inflate(double margin) {
+            xMin -= margin; xMax += margin;
+            yMin -= margin; yMax += margin;
+        }
+        bool intersects(const DVRegion& other) const {
+            return xMin <= other.xMax && other.xMin <= xMax && yMin <= other.yMax && other.yMin <= yMax;
+        }
+    };
+
+    // One greedy step of a dangling vertex across one axis: onto the nearest feasible adjacent
+    // line of that axis, else onto the nearest feasible free intersection, else a new line
+    // through the vertex
+    struct DVStep {
+        bool        ontoVertical;       // chooses among vertical lines (x changes)
+        bool        addsLine;
+        bool        toIntersection;     // to is an intersection further away, both coordinates may change
+        Coord2      from;
+        Coord2      to;                 // from if addsLine
+        DVRegion    reads;              // vertices, edges and occupancy the choice depends on
+        double      spanLo, spanHi;     // a line inserted in [spanLo, spanHi] on the step axis can change it
+    };
+
+    // Add the positions of the vertex's neighbors (the far ends of its edges)
+    static void addNeighbors(int vertexID, const BaseUGraphProperty& graph, DVRegion& region) {
+        BaseUGraphProperty::vertex_descriptor vertexDesc = getVertexDescriptor(vertexID);
+        auto oep = boost::out_edges(vertexDesc, graph);
+        for (auto oeit = oep.first; oeit != oep.second; ++oeit) {
+            BaseUGraphProperty::vertex_descriptor other = boost::source(*oeit, graph) == vertexDesc ? boost::target(*oeit, graph) : boost::source(*oeit, graph);
+            region.add(graph[other].getCoord());
+        }
+    }
+
+    // Choose a step for the vertex at pos without applying it; keptLine is the handle of its
+    // line on the other axis
+    static DVStep planStep(int vertexID, const Coord2& pos, bool ontoVertical, int keptLine,
+                           const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+        DVStep step;
+        step.ontoVertical = ontoVertical;
+        step.addsLine = true;
+        step.toIntersection = false;
+        step.from = pos;
+        step.to = pos;
+
+        double current = ontoVertical ? pos.x() : pos.y();
+        std::vector<AuxiliaryLine> adjLines = ontoVertical ? getAdjVALs(vertexID, pos, grid, graph)
+                                                           : getAdjHALs(vertexID, pos, grid, graph);
+        std::vector<bool> feasible = feasibleCandidates(vertexID, pos, adjLines, keptLine, grid, graph);
+        double minDistance = std::numeric_limits<double>::max();
+        for (int i = 0; i < adjLines.size(); ++i) {
+            double dist = std::abs(current - adjLines[i].getPosition());
+            if (feasible[i] && dist < minDistance) { // there is no overlap!
+                minDistance = dist;
+                step.addsLine = false;
+                step.to = ontoVertical ? Coord2(adjLines[i].getPosition(), pos.y()) : Coord2(pos.x(), adjLines[i].getPosition());
             }
-            else {
-                X_result = currentX;
-                Y_result = pos.y();
-                addVAL(currentX, grid, graph);
+            else if (!feasible[i]) {
+                if (LOG_DV_PLANNING) std::cout << "Overlap at line " << adjLines[i].getPosition() << std::endl;
             }
         }
-        else if (isOnVAL(vertexID, grid, graph)) {
 
-            double currentY = pos.y();
-            std::vector<AuxiliaryLine> adjHALs = getAdjHALs(vertexID, grid, graph);
-            double minDistance = std::numeric_limits<double>::max();
-            double bestY = currentY;
-
-            std::cout << adjHALs.size() << std::endl;
-
-            bool flag = false;
-            for (int i = 0; i < adjHALs.size(); ++i) {
-                const AuxiliaryLine& adjHAL = adjHALs[i];
-                std::cout << adjHAL.getPosition() << std::endl;
-                Coord2 newPos = Coord2(pos.x(), adjHAL.getPosition());
-
-                if (!overlapHappens(vertexID, newPos, graph)) { // there is no overlap!
-                    flag = true;
-                    double dist = std::abs(currentY - adjHAL.getPosition());
-                    if (dist < minDistance) {
-                        minDistance = dist;
-                        bestY = adjHAL.getPosition();
-                    }
-                }
-                else {
-                    continue;
+        // Both adjacent lines blocked: a free intersection nearby keeps the grid from growing
+        bool searched = step.addsLine && DV_INTERSECTION_CANDIDATES > 0;
+        if (searched) {
+            std::vector<GridIntersection> nearest = grid.nearestFreeIntersections(pos, DV_INTERSECTION_CANDIDATES,
+                                                                                  DV_INTERSECTION_MAX_DISTANCE, vertexID,
+                                                                                  DV_INTERSECTION_MAX_PROBES);
+            std::vector<Coord2> positions;
+            for (const GridIntersection& intersection : nearest) {
+                positions.push_back(intersection.pos);
+            }
+            boost::dynamic_bitset<> overlaps = overlapBatch(vertexID, Span<Coord2>(positions), graph);
+            for (int i = 0; i < nearest.size(); ++i) {
+                if (!overlaps[i]) {
+                    step.addsLine = false;
+                    step.toIntersection = true;
+                    step.to = nearest[i].pos;
+                    if (LOG_DV_PLANNING) std::cout << "Moving to the free intersection (" << step.to.x() << ", " << step.to.y() << ")" << std::endl;
+                    break;
                 }
             }
-            
-            // update the vertex position
-            if (flag) {
-                X_result = pos.x();
-                Y_result = bestY;
-                graph[vertexDesc].setCoord(pos.x(), bestY);
-            }
-            else {
-                X_result = pos.x();
-                Y_result = currentY;
-                addHAL(currentY, grid, graph);
+        }
+
+        // The choice read the nearest lines on either side, the dangling vertices and
+        // intersections between them, and the surroundings of the edges at each candidate
+        const std::vector<AuxiliaryLine>& lines = ontoVertical ? grid.getVerticalAuxLines() : grid.getHorizontalAuxLines();
+        auto below = std::lower_bound(lines.begin(), lines.end(), current,
+                                      [](const AuxiliaryLine& line, double p) { return line.getPosition() < p; });
+        auto above = std::upper_bound(lines.begin(), lines.end(), current,
+                                      [](double p, const AuxiliaryLine& line) { return p < line.getPosition(); });
+        step.spanLo = below == lines.begin() ? std::numeric_limits<double>::lowest() : std::prev(below)->getPosition();
+        step.spanHi = above == lines.end() ? std::numeric_limits<double>::max() : above->getPosition();
+
+        step.reads.add(pos);
+        for (double p : {step.spanLo, step.spanHi}) {
+            if (p != std::numeric_limits<double>::lowest() && p != std::numeric_limits<double>::max()) {
+                step.reads.add(ontoVertical ? Coord2(p, pos.y()) : Coord2(pos.x(), p));
             }
-            // !!! update the adjacent edges?
+        }
+        if (searched) {
+            step.reads.add(Coord2(pos.x() - DV_INTERSECTION_MAX_DISTANCE, pos.y() - DV_INTERSECTION_MAX_DISTANCE));
+            step.reads.add(Coord2(pos.x() + DV_INTERSECTION_MAX_DISTANCE, pos.y() + DV_INTERSECTION_MAX_DISTANCE));
+        }
+        addNeighbors(vertexID, graph, step.reads);
+        step.reads.inflate(DV_SPECULATION_MARGIN);
+        return step;
+    }
+
+    static void applyStep(int vertexID, const DVStep& step, DynamicGrid& grid, BaseUGraphProperty& graph) {
+        if (step.addsLine) {
+            if (step.ontoVertical) addVAL(step.from.x(), grid, graph);
+            else addHAL(step.from.y(), grid, graph);
+            return;
+        }
+        BaseUGraphProperty::vertex_descriptor vertexDesc = getVertexDescriptor(vertexID);
+        graph[vertexDesc].setCoord(step.to.x(), step.to.y());
+        grid.moveVertex(vertexID, step.from, step.to, boost::out_degree(vertexDesc, graph));
+    }
+
+    // Partially aligned: one step onto the missing axis
+    static std::vector<DVStep> stepsPDV(int vertexID, DynamicGrid& grid, BaseUGraphProperty& graph) {
+        Coord2 pos = graph[getVertexDescriptor(vertexID)].getCoord();
+        DVStep step;
+        if (isOnHAL(vertexID, grid, graph)) {
+            step = planStep(vertexID, pos, true, grid.horizontalLineOf(vertexID), grid, graph);
+        }
+        else if (isOnVAL(vertexID, grid, graph)) {
+            step = planStep(vertexID, pos, false, grid.verticalLineOf(vertexID), grid, graph);
         }
         else {
             throw std::runtime_error("Foul and smelly!");
         }
+        applyStep(vertexID, step, grid, graph);
+        return {step};
+    }
+
+    // Fully dangling: a vertical step, then a horizontal one from where it ended (unless the
+    // first already reached an intersection)
+    static std::vector<DVStep> stepsFDV(int vertexID, DynamicGrid& grid, BaseUGraphProperty& graph) {
+        Coord2 pos = graph[getVertexDescriptor(vertexID)].getCoord();
+        std::vector<DVStep> steps;
+        steps.push_back(planStep(vertexID, pos, true, grid.horizontalLineOf(vertexID), grid, graph));
+        applyStep(vertexID, steps.back(), grid, graph);
+        if (steps.back().toIntersection) return steps;
+        steps.push_back(planStep(vertexID, steps.back().to, false, grid.verticalLineOf(vertexID), grid, graph));
+        applyStep(vertexID, steps.back(), grid, graph);
+        return steps;
+    }
 
-        std::cout << "Final coordinates: X: " << X_result << " Y: " << Y_result << std::endl;
-        return;
+    void processPDV(int vertexID, DynamicGrid& grid, BaseUGraphProperty& graph) {
+        stepsPDV(vertexID, grid, graph);
+        Coord2 pos = graph[getVertexDescriptor(vertexID)].getCoord();
+        std::cout << "Final coordinates: X: " << pos.x() << " Y: " << pos.y() << std::endl;
     }
 
     void processFDV(int vertexID, DynamicGrid& grid, BaseUGraphProperty& graph) {
+        std::cout << "Initial coordinates: X: " << graph[getVertexDescriptor(vertexID)].getCoord().x()
+                  << " Y: " << graph[getVertexDescriptor(vertexID)].getCoord().y() << std::endl;
+        stepsFDV(vertexID, grid, graph);
+        Coord2 pos = graph[getVertexDescriptor(vertexID)].getCoord();
+        std::cout << "Final coordinates: X: " << pos.x() << " Y: " << pos.y() << std::endl;
+    }
 
-        BaseUGraphProperty::vertex_descriptor vertexDesc = getVertexDescriptor(vertexID);
-        Coord2 pos = graph[vertexDesc].getCoord();
-        double X_result;
-        double Y_result;
+    //---------------------------------------------------------------------------------------------------------
+    //  Greedy passes
+    //---------------------------------------------------------------------------------------------------------
 
-        std::cout << "Initial coordinates: X: " << pos.x() << " Y: " << pos.y() << std::endl;
+    // Process one vertex of a pass against the current layout: the partially aligned ones in
+    // the first pass, the fully dangling ones in the second. Returns the steps taken, none if
+    // the vertex is not of the pass's kind (any more).
+    static std::vector<DVStep> runDV(int vertexID, bool fullyDangling, DynamicGrid& grid, BaseUGraphProperty& graph) {
+        bool isOnHorizontal = isOnHAL(vertexID, grid, graph);
+        bool isOnVertical = isOnVAL(vertexID, grid, graph);
+        if (!fullyDangling && isOnHorizontal != isOnVertical) {
+            std::cout << "Processing partially aligned vertex " << vertexID << std::endl;
+            return stepsPDV(vertexID, grid, graph);
+        }
+        if (fullyDangling && !isOnHorizontal && !isOnVertical) {
+            std::cout << "Processing fully dangling vertex " << vertexID << std::endl;
+            return stepsFDV(vertexID, grid, graph);
+        }
+        return {};
+    }
 
-        double currentX = pos.x();
-        std::vector<AuxiliaryLine> adjVALs = getAdjVALs(vertexID, grid, graph);
-        double minDistance = std::numeric_limits<double>::max();
-        double bestX = currentX;
+    // The steps runDV would take, planned against the current layout without applying them.
+    // A fully dangling vertex whose first step adds a line is left to runDV, as its second
+    // step depends on that line.
+    struct DVPlan {
+        bool                    sequential;     // could not be planned ahead
+        DVRegion                reads;          // the vertex itself, which decides its kind
+        std::vector<DVStep>     steps;
+
+        DVPlan( void ): sequential(false) {}
+    };
+
+    static DVPlan planDV(int vertexID, bool fullyDangling, const DynamicGrid& grid, const BaseUGraphProperty& graph) {
+        DVPlan plan;
+        Coord2 pos = graph[getVertexDescriptor(vertexID)].getCoord();
+        plan.reads.add(pos);
+        plan.reads.inflate(DV_SPECULATION_MARGIN);
+
+        bool isOnHorizontal = isOnHAL(vertexID, grid, graph);
+        bool isOnVertical = isOnVAL(vertexID, grid, graph);
+        if (!fullyDangling && isOnHorizontal != isOnVertical) {
+            int keptLine = isOnHorizontal ? grid.horizontalLineOf(vertexID) : grid.verticalLineOf(vertexID);
+            plan.steps.push_back(planStep(vertexID, pos, isOnHorizontal, keptLine, grid, graph));
+        }
+        else if (fullyDangling && !isOnHorizontal && !isOnVertical) {
+            plan.steps.push_back(planStep(vertexID, pos, true, grid.horizontalLineOf(vertexID), grid, graph));
+            if (plan.steps.back().addsLine) {
+                plan.sequential = true;
+                return plan;
+            }
+            if (plan.steps.back().toIntersection) return plan;
+            // the grid attaches the moved vertex to the first line within the membership tolerance
+            Coord2 to = plan.steps.back().to;
+            int line = grid.getVALIndex().firstWithin(to.x(), EPSILON);
+            int keptLine = line >= 0 ? DynamicGrid::lineHandle(grid.getVerticalAuxLines()[line]) : -1;
+            plan.steps.push_back(planStep(vertexID, to, false, keptLine, grid, graph));
+        }
+        return plan;
+    }
 
-        bool flag = false;
-        for (int i = 0; i < adjVALs.size(); ++i) {
-            const AuxiliaryLine& adjVAL = adjVALs[i];
-            Coord2 newPos = Coord2(adjVAL.getPosition(), pos.y());
+    // What an applied step changed: a new line, or the vertex and its edges at both positions
+    struct DVWrite {
+        bool        newLine;
+        bool        vertical;       // newLine: axis of the line
+        double      position;       // newLine: position of the line
+        DVRegion    region;         // move: from, to and the neighbors
+    };
+
+    static DVWrite stepWrite(int vertexID, const DVStep& step, const BaseUGraphProperty& graph) {
+        DVWrite write;
+        write.newLine = step.addsLine;
+        write.vertical = step.ontoVertical;
+        write.position = step.ontoVertical ? step.from.x() : step.from.y();
+        write.region.add(step.from);
+        write.region.add(step.to);
+        addNeighbors(vertexID, graph, write.region);
+        return write;
+    }
 
-            std::cout << "Now we have a try from West to East. New X: " << adjVAL.getPosition() << " Y: " << pos.y() << std::endl;
+    // A new line reaches across the whole region along its axis
+    static bool touches(const DVWrite& write, const DVRegion& reads) {
+        if (!write.newLine) return reads.intersects(write.region);
+        return write.vertical ? reads.xMin <= write.position && write.position <= reads.xMax
+                              : reads.yMin <= write.position && write.position <= reads.yMax;
+    }
 
-            if (!overlapHappens(vertexID, newPos, graph)) { // there is no overlap!
-                flag = true;
-                double dist = std::abs(currentX - adjVAL.getPosition());
-                if (dist < minDistance) {
-                    minDistance = dist;
-                    bestX = adjVAL.getPosition();
-                }
+    static bool conflicts(const DVPlan& plan, const DVWrite& write) {
+        if (touches(write, plan.reads)) return true;
+        for (const DVStep& step : plan.steps) {
+            if (touches(write, step.reads)) return true;
+            if (write.newLine && write.vertical == step.ontoVertical &&
+                step.spanLo <= write.position && write.position <= step.spanHi) {
+                return true;
             }
-            else {
-                std::cout << "Holy Shit! We have an overlap!" << std::endl;
-                continue;
+        }
+        return false;
+    }
+
+    int positionDanglingPass(const std::vector<int>& danglingVertices, bool fullyDangling,
+                             DynamicGrid& grid, BaseUGraphProperty& graph, ThreadPool* pool) {
+        int processedNum = 0;
+        if (pool == nullptr || pool->concurrency() < 2) {
+            for (int vertexID : danglingVertices) {
+                if (!runDV(vertexID, fullyDangling, grid, graph).empty()) ++processedNum;
             }
+            return processedNum;
         }
 
-        // update the vertex position
-        if (flag) {
-            X_result = bestX;
-            Y_result = pos.y();
-            graph[vertexDesc].setCoord(bestX, pos.y());
+        DescriptorMapping mapping = buildDescriptorMapping(graph);
+        const int vertexNum = static_cast<int>(danglingVertices.size());
+        int replannedNum = 0;
+        for (int first = 0; first < vertexNum; first += DV_SPECULATION_BATCH) {
+            int last = std::min(vertexNum, first + DV_SPECULATION_BATCH);
+
+            // Plan the batch in parallel against the layout as it is. The line index is
+            // refreshed lazily, so bring it up to date before the grid is shared.
+            grid.getHALIndex();
+            grid.getVALIndex();
+            std::vector<DVPlan> plans(last - first);
+            pool->parallelFor(first, last, [&](int i) {
+                ScopedDescriptorMapping scope(mapping);
+                try {
+                    plans[i - first] = planDV(danglingVertices[i], fullyDangling, grid, graph);
+                }
+                catch (const std::exception&) {
+                    plans[i - first].sequential = true;     // runDV throws again, in order
+                }
+            });
+
+            // Commit in degree order. A plan that read what an earlier commit of the batch
+            // changed is stale: the vertex is processed again against the current layout.
+            std::vector<DVWrite> writes;
+            for (int i = first; i < last; ++i) {
+                int vertexID = danglingVertices[i];
+                const DVPlan& plan = plans[i - first];
+                bool stale = plan.sequential || std::any_of(writes.begin(), writes.end(),
+                                                            [&plan](const DVWrite& write) { return conflicts(plan, write); });
+                std::vector<DVStep> steps;
+                if (stale) {
+                    ++replannedNum;
+                    steps = runDV(vertexID, fullyDangling, grid, graph);
+                }
+                else {
+                    steps = plan.steps;
+                    for (const DVStep& step : steps) {
+                        applyStep(vertexID, step, grid, graph);
+                    }
+                }
+                if (!steps.empty()) ++processedNum;
+                for (const DVStep& step : steps) {
+                    writes.push_back(stepWrite(vertexID, step, graph));
+                }
+            }
         }
-        else {
-            X_result = currentX;
-            Y_result = pos.y();
-            addVAL(currentX, grid, graph);
+
+        std::cout << (fullyDangling ? "Fully" : "Partially") << " dangling pass: " << processedNum << " processed, "
+                  << replannedNum << " of " << vertexNum << " re-planned in order" << std::endl;
+        return processedNum;
+    }
+
+    //---------------------------------------------------------------------------------------------------------
+    //  Global assignment of dangling vertices
+    //---------------------------------------------------------------------------------------------------------
+
+    int assignDanglingVertices(DynamicGrid& grid, BaseUGraphProperty& graph) {
+        if (!grid.hasOccupancy()) {
+            std::cout << "Dangling vertex assignment needs the grid occupancy, skipped" << std::endl;
+            return 0;
         }
 
-        pos = graph[vertexDesc].getCoord();
-        double currentY = pos.y();
-        std::vector<AuxiliaryLine> adjHALs = getAdjHALs(vertexID, grid, graph);
-        minDistance = std::numeric_limits<double>::max();
-        double bestY = currentY;
-
-        flag = false;
-        for (int i = 0; i < adjHALs.size(); ++i) {
-            const AuxiliaryLine& adjHAL = adjHALs[i];
-            Coord2 newPos = Coord2(pos.x(), adjHAL.getPosition());
-            std::cout << "Now we have a try from North to South. New X: " << pos.x() << " New Y: " << adjHAL.getPosition() << std::endl;
-
-            if (!overlapHappens(vertexID, newPos, graph)) { // there is no overlap!
-                flag = true;
-                double dist = std::abs(currentY - adjHAL.getPosition());
-                if (dist < minDistance) {
-                    minDistance = dist;
-                    bestY = adjHAL.getPosition();
+        double totalEdgeLength = 0.0;
+        int edgeNum = 0;
+        auto ep = boost::edges(graph);
+        for (auto eit = ep.first; eit != ep.second; ++eit) {
+            Coord2 d = graph[*eit].Source().getCoord() - graph[*eit].Target().getCoord();
+            totalEdgeLength += std::sqrt(d.x() * d.x() + d.y() * d.y());
+            ++edgeNum;
+        }
+        double averageEdgeLength = (edgeNum > 0 && totalEdgeLength > 0.0) ? totalEdgeLength / edgeNum : 1.0;
+        double radius = DV_ASSIGNMENT_RADIUS_FACTOR * averageEdgeLength;
+
+        // Overlap checks of the chosen moves, updated in place after every accepted one
+        OverlapGeometry geometry;
+        geometry.build(graph);
+
+        auto intersectionKey = [](int hLine, int vLine) {
+            return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(hLine)) << 32) | static_cast<std::uint32_t>(vLine);
+        };
+        std::set<std::pair<int, std::uint64_t>> banned;     // (vertex ID, intersection) found to overlap
+
+        struct Pair {
+            int     dv;             // index in dvs
+            int     intersection;   // index in intersections
+            double  cost;           // squared displacement
+        };
+
+        int movedNum = 0;
+        for (int round = 0; round < DV_ASSIGNMENT_MAX_ROUNDS; ++round) {
+            std::vector<int> dvs = grid.getDanglingVertices();
+            if (dvs.empty()) break;
+
+            const std::vector<AuxiliaryLine>& hLines = grid.getHorizontalAuxLines();
+            const std::vector<AuxiliaryLine>& vLines = grid.getVerticalAuxLines();
+            const AxisLineIndex& hIndex = grid.getHALIndex();
+            const AxisLineIndex& vIndex = grid.getVALIndex();
+
+            // Sparse bipartite graph: every vertex to its nearest free intersections in the radius
+            std::vector<std::pair<int, int>> intersections;     // (hLines index, vLines index)
+            std::unordered_map<std::uint64_t, int> intersectionOf;
+            std::vector<Pair> pairs;
+            for (int i = 0; i < dvs.size(); ++i) {
+                int vertexID = dvs[i];
+                Coord2 pos = graph[getVertexDescriptor(vertexID)].getCoord();
+                std::pair<int, int> hSlots = hIndex.range(pos.y() - radius, pos.y() + radius);
+                std::pair<int, int> vSlots = vIndex.range(pos.x() - radius, pos.x() + radius);
+
+                std::vector<Pair> candidates;
+                for (int hs = hSlots.first; hs < hSlots.second; ++hs) {
+                    int h = hIndex.lineIndex(hs);
+                    double dy = hLines[h].getPosition() - pos.y();
+                    for (int vs = vSlots.first; vs < vSlots.second; ++vs) {
+                        int v = vIndex.lineIndex(vs);
+                        double dx = vLines[v].getPosition() - pos.x();
+                        double cost = dx * dx + dy * dy;
+                        int hHandle = DynamicGrid::lineHandle(hLines[h]);
+                        int vHandle = DynamicGrid::lineHandle(vLines[v]);
+                        if (cost > radius * radius || !grid.isIntersectionFree(hHandle, vHandle, vertexID) ||
+                            banned.count({vertexID, intersectionKey(hHandle, vHandle)})) {
+                            continue;
+                        }
+                        auto it = intersectionOf.emplace(intersectionKey(hHandle, vHandle), static_cast<int>(intersections.size())).first;
+                        if (it->second == intersections.size()) {
+                            intersections.emplace_back(h, v);
+                        }
+                        candidates.push_back({i, it->second, cost});
+                    }
+                }
+
+                auto cheaper = [](const Pair& a, const Pair& b) {
+                    return a.cost < b.cost || (a.cost == b.cost && a.intersection < b.intersection);
+                };
+                if (candidates.size() > DV_ASSIGNMENT_MAX_CANDIDATES) {
+                    std::partial_sort(candidates.begin(), candidates.begin() + DV_ASSIGNMENT_MAX_CANDIDATES, candidates.end(), cheaper);
+                    candidates.resize(DV_ASSIGNMENT_MAX_CANDIDATES);
+                }
+                pairs.insert(pairs.end(), candidates.begin(), candidates.end());
+            }
+            if (pairs.empty()) break;
+
+            // Independent subproblems: connected components over the pairs
+            const int dvNum = static_cast<int>(dvs.size());
+            std::vector<int> parent(dvNum + intersections.size());
+            std::iota(parent.begin(), parent.end(), 0);
+            std::function<int(int)> find = [&](int x) { return parent[x] == x ? x : parent[x] = find(parent[x]); };
+            for (const Pair& pair : pairs) {
+                parent[find(pair.dv)] = find(dvNum + pair.intersection);
+            }
+            std::map<int, std::vector<int>> componentPairs;     // root -> pair indices
+            for (int k = 0; k < pairs.size(); ++k) {
+                componentPairs[find(pairs[k].dv)].push_back(k);
+            }
+
+            // Min-cost maximum assignment per component
+            std::vector<Pair> chosen;
+            for (const auto& [root, members] : componentPairs) {
+                MinCostFlow flow(2);
+                const int source = 0, sink = 1;
+                std::unordered_map<int, int> dvNode, intersectionNode;
+                std::vector<int> arcs;
+                for (int k : members) {
+                    auto dvIt = dvNode.find(pairs[k].dv);
+                    if (dvIt == dvNode.end()) {
+                        dvIt = dvNode.emplace(pairs[k].dv, flow.addNode()).first;
+                        flow.addArc(source, dvIt->second, 1, 0.0);
+                    }
+                    auto inIt = intersectionNode.find(pairs[k].intersection);
+                    if (inIt == intersectionNode.end()) {
+                        inIt = intersectionNode.emplace(pairs[k].intersection, flow.addNode()).first;
+                        flow.addArc(inIt->second, sink, 1, 0.0);
+                    }
+                    arcs.push_back(flow.addArc(dvIt->second, inIt->second, 1, pairs[k].cost));
+                }
+                double cost = 0.0;
+                flow.solve(source, sink, static_cast<int>(dvNode.size()), cost);
+                for (int m = 0; m < members.size(); ++m) {
+                    if (flow.flow(arcs[m]) > 0) chosen.push_back(pairs[members[m]]);
                 }
             }
-            else {
-                std::cout << "Holy Shit! We have an overlap!" << std::endl;
-                continue;
+
+            // Lazy feasibility: apply the chosen moves cheapest first against the current layout
+            std::sort(chosen.begin(), chosen.end(), [](const Pair& a, const Pair& b) {
+                return a.cost < b.cost || (a.cost == b.cost && a.dv < b.dv);
+            });
+            int rejectedNum = 0;
+            for (const Pair& pair : chosen) {
+                int vertexID = dvs[pair.dv];
+                const AuxiliaryLine& hLine = hLines[intersections[pair.intersection].first];
+                const AuxiliaryLine& vLine = vLines[intersections[pair.intersection].second];
+                int hHandle = DynamicGrid::lineHandle(hLine);
+                int vHandle = DynamicGrid::lineHandle(vLine);
+                Coord2 newPos(vLine.getPosition(), hLine.getPosition());
+
+                if (!grid.isIntersectionFree(hHandle, vHandle, vertexID) ||
+                    overlapKernel(geometry, geometry.indexOf(vertexID), newPos.x(), newPos.y())) {
+                    banned.insert({vertexID, intersectionKey(hHandle, vHandle)});
+                    ++rejectedNum;
+                    continue;
+                }
+
+                BaseUGraphProperty::vertex_descriptor vd = getVertexDescriptor(vertexID);
+                Coord2 oldPos = graph[vd].getCoord();
+                graph[vd].setCoord(newPos.x(), newPos.y());
+                grid.moveVertex(vertexID, oldPos, newPos, boost::out_degree(vd, graph));
+                geometry.setCoord(geometry.indexOf(vertexID), newPos.x(), newPos.y());
+                ++movedNum;
             }
+
+            std::cout << "Assignment round " << round << ": " << dvs.size() << " dangling, " << chosen.size()
+                      << " assigned, " << rejectedNum << " rejected by overlap" << std::endl;
+            if (rejectedNum == 0) break;
         }
-        
-        // update the vertex position
-        if (flag) {
-            X_result = pos.x();
-            Y_result = bestY;
-            graph[vertexDesc].setCoord(pos.x(), bestY);
-        }
-        else {
-            X_result = pos.x();
-            Y_result = currentY;
-            addHAL(currentY, grid, graph);
-        }
-        // !!! update the adjacent edges?
-        
-        std::cout << "Final coordinates: X: " << X_result << " Y: " << Y_result << std::endl;
-        std::cout << "Final coordinates in graph: X: " << graph[vertexDesc].getCoord().x() << " Y: " << graph[vertexDesc].getCoord().y() << std::endl;
-        return;
+        return movedNum;
     }
-    
+
     //---------------------------------------------------------------------------------------------------------
     //  Main function to position all dangling vertices
     //---------------------------------------------------------------------------------------------------------
@@ -528,8 +856,9 @@ namespace Map {
             std::map<unsigned int, int> vertexID2Index = createVertexID2Index(vertexList);
             
             // Create visualization before positioning
-            createVisualization(vertexList, edgeList, "before_dv.svg");
-            std::cout << "Created visualization: before_dv.svg" << std::endl;
+            std::string beforeFile = "output/" + testCaseName + "_before_dv.svg";
+            createVisualization(vertexList, edgeList, beforeFile);
+            std::cout << "Created visualization: " << beforeFile << std::endl;
             
             int modifiedCount = 0;
             
@@ -538,37 +867,24 @@ namespace Map {
             
             std::cout << "Found " << danglingVertices.size() << " dangling vertices" << std::endl;
             
-            // !!! 1. First process vertices that are partially aligned
-            for (int vertexID : danglingVertices) {
-                bool isOnHorizontal = isOnHAL(vertexID, grid, graph);
-                bool isOnVertical = isOnVAL(vertexID, grid, graph);
-                
-                if ((isOnHorizontal && !isOnVertical) || (!isOnHorizontal && isOnVertical)) {
-                    std::cout << std::endl;
-                    std::cout << std::endl;
-                    std::cout << "Processing partially aligned vertex " << vertexID << std::endl;
-                    processPDV(vertexID, grid, graph);
-                    modifiedCount++;
-                    std::cout << std::endl;
-                    std::cout << std::endl;
-                }
+            if (DV_POSITIONING_METHOD == MIN_COST_ASSIGNMENT) {
+                modifiedCount += assignDanglingVertices(grid, graph);
+                danglingVertices = findDVs(grid, graph);
+                std::cout << danglingVertices.size() << " dangling vertices left for the greedy pass" << std::endl;
             }
             
+            ThreadPool* pool = USE_SPECULATIVE_DV_POSITIONING ? &ThreadPool::shared() : nullptr;
+
+            // !!! 1. First process vertices that are partially aligned
+            modifiedCount += positionDanglingPass(danglingVertices, false, grid, graph, pool);
+            
+            // Moves and new lines since the build have been scored incrementally; the election
+            // can leave more vertices dangling
+            grid.electKeyAuxLines();
+            danglingVertices = findDVs(grid, graph);
+            
             // !!! 2. Then process fully dangling vertices
-            for (int vertexID : danglingVertices) {
-                bool isOnHorizontal = isOnHAL(vertexID, grid, graph);
-                bool isOnVertical = isOnVAL(vertexID, grid, graph);
-                
-                if (!isOnHorizontal && !isOnVertical) {
-                    std::cout << std::endl;
-                    std::cout << std::endl;
-                    std::cout << "Processing fully dangling vertex " << vertexID << std::endl;
-                    processFDV(vertexID, grid, graph);
-                    modifiedCount++;
-                    std::cout << std::endl;
-                    std::cout << std::endl;
-                }
-            }
+            modifiedCount += positionDanglingPass(danglingVertices, true, grid, graph, pool);
             
             std::cout << "Positioned " << modifiedCount << " dangling vertices" << std::endl;
             
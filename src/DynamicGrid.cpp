@@ -4,86 +4,215 @@
 
 #include "DynamicGrid.h"
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <functional>
 
 namespace Map {
 
-    DynamicGrid::DynamicGrid() {}
+    // Key line score: members + KEY_LINE_DEGREE_WEIGHT * degree beyond 2 + spread / KEY_LINE_SPREAD_UNIT
+    const double KEY_LINE_DEGREE_WEIGHT = 0.5;
+    const double KEY_LINE_SPREAD_UNIT = 100.0;
+    const double KEY_LINE_SCORE_MARGIN = 1.0;   // the election drops lines scoring below minVoteThreshold + this
+
+    // Distance within which a vertex is on a line once the lines are fixed
+    const double MEMBERSHIP_EPSILON = 1e-2;
+
+    void AuxLineStats::merge(const AuxLineStats& other) {
+        pinned = pinned || other.pinned;
+        count += other.count;
+        extraDegree += other.extraDegree;
+        sum += other.sum;
+        sumSq += other.sumSq;
+    }
+
+    double AuxLineStats::spread( void ) const {
+        if (count < 2) return 0.0;
+        double mean = sum / count;
+        return std::sqrt(std::max(0.0, sumSq / count - mean * mean));
+    }
+
+    DynamicGrid::DynamicGrid(): occupancyValid(false), indexValid(false) {}
 
     DynamicGrid::DynamicGrid(double tolerance, double minVotes): 
-        tolerance(tolerance), minVoteThreshold(minVotes) {
+        occupancyValid(false), tolerance(tolerance), minVoteThreshold(minVotes), indexValid(false) {
+    }
+
+    DynamicGrid::DynamicGrid(const DynamicGrid& other):
+        horizontalAuxLines(other.horizontalAuxLines), verticalAuxLines(other.verticalAuxLines),
+        memberPool(other.memberPool), lineStats(other.lineStats), electionHeap(other.electionHeap),
+        occupancy(other.occupancy), occupancyValid(other.occupancyValid), tolerance(other.tolerance), minVoteThreshold(other.minVoteThreshold), indexValid(false) {
+        bindMemberPool();
+    }
+
+    DynamicGrid& DynamicGrid::operator = (const DynamicGrid& other) {
+        if (this != &other) {
+            horizontalAuxLines = other.horizontalAuxLines;
+            verticalAuxLines = other.verticalAuxLines;
+            memberPool = other.memberPool;
+            lineStats = other.lineStats;
+            electionHeap = other.electionHeap;
+            occupancy = other.occupancy;
+            occupancyValid = other.occupancyValid;
+            tolerance = other.tolerance;
+            minVoteThreshold = other.minVoteThreshold;
+            invalidateLineIndex();
+            bindMemberPool();
+        }
+        return *this;
+    }
+
+    void DynamicGrid::bindMemberPool() {
+        for (auto& line : horizontalAuxLines) {
+            line.setMembers(&memberPool, line.getMemberList());
+        }
+        for (auto& line : verticalAuxLines) {
+            line.setMembers(&memberPool, line.getMemberList());
+        }
+    }
+
+    double DynamicGrid::lineScore(const AuxLineStats& stats) const {
+        if (stats.pinned) return std::numeric_limits<double>::infinity();
+        return stats.count + KEY_LINE_DEGREE_WEIGHT * stats.extraDegree + stats.spread() / KEY_LINE_SPREAD_UNIT;
+    }
+
+    double DynamicGrid::getLineScore(const AuxiliaryLine& line) const {
+        return lineScore(lineStats[line.getMemberList()]);
+    }
+
+    int DynamicGrid::createLine(AuxiliaryLine& line, Span<int> ids, const AuxLineStats& stats) {
+        int list = memberPool.createList(ids);
+        line.setMembers(&memberPool, list);
+        lineStats.resize(list + 1);
+        lineStats[list] = stats;
+        rescoreLine(list);
+        return list;
+    }
+
+    void DynamicGrid::placeVertex(int vertexID, const Coord2& pos) {
+        int h = getHALIndex().firstWithin(pos.y(), MEMBERSHIP_EPSILON);
+        int v = getVALIndex().firstWithin(pos.x(), MEMBERSHIP_EPSILON);
+        occupancy.place(vertexID, pos,
+                        h >= 0 ? horizontalAuxLines[h].getMemberList() : -1,
+                        v >= 0 ? verticalAuxLines[v].getMemberList() : -1);
+    }
+
+    void DynamicGrid::attachVerticesToLines(bool isHorizontal) {
+        if (!occupancyValid) return;
+        const std::vector<AuxiliaryLine>& lines = isHorizontal ? horizontalAuxLines : verticalAuxLines;
+        const AxisLineIndex& index = isHorizontal ? getHALIndex() : getVALIndex();
+        std::vector<std::pair<int, int>> attached;
+        occupancy.forEach([&](int vertexID, const Coord2& pos, int hLine, int vLine) {
+            if ((isHorizontal ? hLine : vLine) >= 0) return;
+            int line = index.firstWithin(isHorizontal ? pos.y() : pos.x(), MEMBERSHIP_EPSILON);
+            if (line >= 0) attached.emplace_back(vertexID, lines[line].getMemberList());
+        });
+        for (const auto& pair : attached) {
+            occupancy.setLine(pair.first, isHorizontal, pair.second);
+        }
+    }
+
+    // Vertex IDs by descending degree, ties kept in the given order
+    static std::vector<int> degreeOrder(const std::vector<int>& vertexIDs, const std::vector<int>& degrees) {
+        std::vector<int> order(vertexIDs.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        std::stable_sort(order.begin(), order.end(), [&degrees](int a, int b) { return degrees[a] > degrees[b]; });
+        for (int& i : order) i = vertexIDs[i];
+        return order;
+    }
+
+    // Candidate lines of one axis, in vertex order: a vertex joins the lowest existing
+    // candidate within tolerance, otherwise it opens a candidate at its own coordinate.
+    // Candidates below c - tolerance are out of reach, so each lookup is one lower_bound.
+    // Fills the ascending candidate positions and, per vertex, the rank of its candidate.
+    static void assignAxisCandidates(
+        const std::vector<double>& coords,
+        double tolerance,
+        std::vector<double>& positions,
+        std::vector<int>& candidateOfVertex) {
+
+        std::map<double, int> candidates;                   // position -> creation order
+        std::vector<int> created(coords.size());
+        for (size_t i = 0; i < coords.size(); ++i) {
+            double c = coords[i];
+            auto it = candidates.lower_bound(c - tolerance);
+            if (it != candidates.end() && std::abs(it->first - c) <= tolerance) {
+                created[i] = it->second;
+            }
+            else {
+                created[i] = static_cast<int>(candidates.size());
+                candidates.emplace(c, created[i]);
+            }
+        }
+
+        std::vector<int> rank(candidates.size());
+        positions.clear();
+        positions.reserve(candidates.size());
+        for (const auto& pair : candidates) {
+            rank[pair.second] = static_cast<int>(positions.size());
+            positions.push_back(pair.first);
+        }
+        candidateOfVertex.resize(coords.size());
+        for (size_t i = 0; i < coords.size(); ++i) {
+            candidateOfVertex[i] = rank[created[i]];
+        }
     }
 
     void DynamicGrid::buildAuxLines(const BaseUGraphProperty& graph) {
         clearAllAuxLines();
         
-        // Use dictionaries to count votes for each coordinate 
-        // !!! (sorted by coordinate value in ascending order)
-        std::map<double, int> vALVotes;                   // x-coordinate -> vote count (ascending order)
-        std::map<double, int> hALVotes;                   // y-coordinate -> vote count (ascending order)
-        std::map<double, std::vector<int>> vAL2Vertices;  // x-coordinate -> vertex IDs
-        std::map<double, std::vector<int>> hAL2Vertices;  // y-coordinate -> vertex IDs
-        
+        std::vector<int> vertexIDs, degrees;
+        std::vector<double> xs, ys;
         auto vp = boost::vertices(graph);
         for (auto vit = vp.first; vit != vp.second; ++vit) {
             const BaseVertexProperty& vertex = graph[*vit];
-            Coord2 coord = vertex.getCoord();
-            int vertexID = vertex.getID();
-            
-            double x = coord.x();
-            double y = coord.y();
+            vertexIDs.push_back(vertex.getID());
+            degrees.push_back(static_cast<int>(boost::out_degree(*vit, graph)));
+            xs.push_back(vertex.getCoord().x());
+            ys.push_back(vertex.getCoord().y());
+        }
+        
+        for (int axis = 0; axis < 2; ++axis) {
+            bool isHorizontal = (axis == 0);
+            std::vector<double> positions;
+            std::vector<int> candidateOfVertex;
+            assignAxisCandidates(isHorizontal ? ys : xs, tolerance, positions, candidateOfVertex);
             
-            // Find or create entry for x-coordinate (vertical line candidate)
-            bool foundVAL = false;
-            for (auto& pair : vALVotes) {
-                if (std::abs(pair.first - x) <= tolerance) {
-                    pair.second++;
-                    vAL2Vertices[pair.first].push_back(vertexID);
-                    foundVAL = true;
-                    break;
-                }
+            // Counting sort of the vertex IDs by candidate, keeping vertex order in each;
+            // the slices of the kept candidates are copied into the pool back to back
+            std::vector<int> offsets(positions.size() + 1, 0);
+            for (int c : candidateOfVertex) {
+                ++offsets[c + 1];
+            }
+            for (size_t c = 0; c < positions.size(); ++c) {
+                offsets[c + 1] += offsets[c];
             }
-            if (!foundVAL) {
-                vALVotes[x] = 1;
-                vAL2Vertices[x].push_back(vertexID);
+            std::vector<int> members(vertexIDs.size());
+            std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+            std::vector<AuxLineStats> stats(positions.size(), AuxLineStats(isHorizontal));
+            const std::vector<double>& along = isHorizontal ? xs : ys;
+            for (size_t i = 0; i < vertexIDs.size(); ++i) {
+                members[cursor[candidateOfVertex[i]]++] = vertexIDs[i];
+                stats[candidateOfVertex[i]].add(along[i], degrees[i]);
             }
             
-            // Find or create entry for y-coordinate (horizontal line candidate)
-            bool foundHAL = false;
-            for (auto& pair : hALVotes) {
-                if (std::abs(pair.first - y) <= tolerance) {
-                    pair.second++;
-                    hAL2Vertices[pair.first].push_back(vertexID);
-                    foundHAL = true;
-                    break;
+            // Candidates that meet the threshold become lines, in ascending position
+            std::vector<AuxiliaryLine>& lines = isHorizontal ? horizontalAuxLines : verticalAuxLines;
+            for (size_t c = 0; c < positions.size(); ++c) {
+                int voteCount = offsets[c + 1] - offsets[c];
+                if (voteCount >= minVoteThreshold) {
+                    lines.emplace_back(positions[c], isHorizontal, voteCount);
+                    createLine(lines.back(), Span<int>(members.data() + offsets[c], members.data() + offsets[c + 1]), stats[c]);
                 }
             }
-            if (!foundHAL) {
-                hALVotes[y] = 1;
-                hAL2Vertices[y].push_back(vertexID);
-            }
         }
-        
-        // Create horizontal auxiliary lines for coordinates that meet the threshold
-        for (const auto& pair : hALVotes) {
-            if (pair.second >= minVoteThreshold) {
-                AuxiliaryLine hLine(pair.first, true);
-                // !!! not elegant at all (not unified)
-                hLine.setVoteCount(pair.second);
-                hLine.setVertexIDs(hAL2Vertices[pair.first]);
-                horizontalAuxLines.push_back(hLine);
-            }
-        }
-        
-        // Create vertical auxiliary lines for coordinates that meet the threshold
-        for (const auto& pair : vALVotes) {
-            if (pair.second >= minVoteThreshold) {
-                AuxiliaryLine vLine(pair.first, false);
-                // !!! not elegant at all (not unified)
-                vLine.setVoteCount(pair.second);
-                vLine.setVertexIDs(vAL2Vertices[pair.first]);
-                verticalAuxLines.push_back(vLine);
-            }
+        invalidateLineIndex();
+
+        for (size_t i = 0; i < vertexIDs.size(); ++i) {
+            placeVertex(vertexIDs[i], Coord2(xs[i], ys[i]));
         }
+        occupancy.setPriority(degreeOrder(vertexIDs, degrees));
+        occupancyValid = true;
     }
 
     std::vector<double> DynamicGrid::getHALPositions() const {
@@ -102,6 +231,117 @@ namespace Map {
         return positions;
     }
 
+    void DynamicGrid::refreshLineIndex() const {
+        if (indexValid) return;
+        hIndex = AxisLineIndex(getHALPositions());
+        vIndex = AxisLineIndex(getVALPositions());
+        handleSlot.assign(memberPool.listCount(), -1);
+        for (const auto* lines : {&horizontalAuxLines, &verticalAuxLines}) {
+            for (size_t i = 0; i < lines->size(); ++i) {
+                handleSlot[(*lines)[i].getMemberList()] = static_cast<int>(i);
+            }
+        }
+        indexValid = true;
+    }
+
+    const AxisLineIndex& DynamicGrid::getHALIndex() const {
+        refreshLineIndex();
+        return hIndex;
+    }
+
+    const AxisLineIndex& DynamicGrid::getVALIndex() const {
+        refreshLineIndex();
+        return vIndex;
+    }
+
+    int DynamicGrid::findLine(int handle) const {
+        refreshLineIndex();
+        return (handle >= 0 && handle < static_cast<int>(handleSlot.size())) ? handleSlot[handle] : -1;
+    }
+
+    namespace {
+        // Slots of one axis in order of distance from p, generated on demand outward from p
+        struct AxisRanks {
+            const AxisLineIndex*    index;
+            double                  p;
+            int                     below;      // next slot below p
+            int                     above;      // next slot at or above p
+            std::vector<int>        slots;
+
+            void reset(const AxisLineIndex& lineIndex, double position) {
+                index = &lineIndex;
+                p = position;
+                above = lineIndex.countBelow(position);
+                below = above - 1;
+                slots.clear();
+            }
+
+            // Whether rank r exists, generating it if needed
+            bool has(int r) {
+                while (r >= static_cast<int>(slots.size())) {
+                    bool takeBelow = below >= 0 && (above >= index->size() || p - index->position(below) <= index->position(above) - p);
+                    if (takeBelow) slots.push_back(below--);
+                    else if (above < index->size()) slots.push_back(above++);
+                    else return false;
+                }
+                return true;
+            }
+            double offset(int r) const { return index->position(slots[r]) - p; }
+        };
+    }
+
+    std::vector<GridIntersection> DynamicGrid::nearestFreeIntersections(const Coord2& pos, int k, double maxDistance,
+                                                                        int ignoreVertexID, int maxProbes) const {
+        std::vector<GridIntersection> result;
+        const AxisLineIndex& hLineIndex = getHALIndex();
+        const AxisLineIndex& vLineIndex = getVALIndex();
+        if (k <= 0 || hLineIndex.empty() || vLineIndex.empty()) {
+            return result;
+        }
+
+        // Scratch reused across queries; thread_local since const queries may run concurrently
+        struct Probe {
+            double  distance2;
+            int     h, v;       // ranks on each axis
+            bool operator > (const Probe& other) const {
+                return distance2 > other.distance2 || (distance2 == other.distance2 && (h > other.h || (h == other.h && v > other.v)));
+            }
+        };
+        static thread_local AxisRanks hRanks, vRanks;
+        static thread_local std::vector<Probe> frontier;
+        hRanks.reset(hLineIndex, pos.y());
+        vRanks.reset(vLineIndex, pos.x());
+        frontier.clear();
+
+        // Sorted sums of two sorted sequences: (h, v) is pushed from (h, v - 1), or from
+        // (h - 1, 0) when v = 0, so every pair enters once and pops in ascending distance
+        auto push = [&](int h, int v) {
+            if (!hRanks.has(h) || !vRanks.has(v)) return;
+            double dy = hRanks.offset(h), dx = vRanks.offset(v);
+            frontier.push_back({dx * dx + dy * dy, h, v});
+            std::push_heap(frontier.begin(), frontier.end(), std::greater<Probe>());
+        };
+        push(0, 0);
+        for (int probeNum = 0; !frontier.empty() && probeNum < maxProbes; ++probeNum) {
+            std::pop_heap(frontier.begin(), frontier.end(), std::greater<Probe>());
+            Probe probe = frontier.back();
+            frontier.pop_back();
+            if (probe.distance2 > maxDistance * maxDistance) break;
+
+            const AuxiliaryLine& hLine = horizontalAuxLines[hLineIndex.lineIndex(hRanks.slots[probe.h])];
+            const AuxiliaryLine& vLine = verticalAuxLines[vLineIndex.lineIndex(vRanks.slots[probe.v])];
+            if (!occupancyValid || occupancy.isFree(hLine.getMemberList(), vLine.getMemberList(), ignoreVertexID)) {
+                result.push_back({hLine.getMemberList(), vLine.getMemberList(),
+                                  Coord2(vLine.getPosition(), hLine.getPosition()), std::sqrt(probe.distance2)});
+                if (static_cast<int>(result.size()) == k) break;
+            }
+
+            push(probe.h, probe.v + 1);
+            if (probe.v == 0) push(probe.h + 1, 0);
+        }
+        return result;
+    }
+
     // !!! why static type?
     int DynamicGrid::getKeyAuxLineCount() const {
         return static_cast<int>(horizontalAuxLines.size() + verticalAuxLines.size());
@@ -115,6 +355,7 @@ namespace Map {
             const auto& hLine = horizontalAuxLines[i];
             std::cout << "  H" << i << ": y=" << hLine.getPosition() 
                       << ", votes=" << hLine.getVoteCount() 
+                      << ", score=" << getLineScore(hLine)
                       << ", vertices=" << hLine.getVertexIDs().size() << std::endl;
         }
         
@@ -123,6 +364,7 @@ namespace Map {
             const auto& vLine = verticalAuxLines[i];
             std::cout << "  V" << i << ": x=" << vLine.getPosition() 
                       << ", votes=" << vLine.getVoteCount() 
+                      << ", score=" << getLineScore(vLine)
                       << ", vertices=" << vLine.getVertexIDs().size() << std::endl;
         }
         
@@ -130,62 +372,240 @@ namespace Map {
     }
 
     void DynamicGrid::clearAllAuxLines() {
+        invalidateLineIndex();
         horizontalAuxLines.clear();
         verticalAuxLines.clear();
+        memberPool.clear();
+        lineStats.clear();
+        electionHeap.clear();
+        occupancy.clear();
+        occupancyValid = false;
     }
 
-    void DynamicGrid::addHorizontalAuxLine(double position) {
-        // Check if a horizontal line already exists at this position (within tolerance)
-        for (const auto& hLine : horizontalAuxLines) {
-            if (std::abs(hLine.getPosition() - position) < 1e-9) {
-                std::cout << "Horizontal auxiliary line already exists at y=" << hLine.getPosition() << std::endl;
-                return;
-            }
+    // Lines closer than this are the same line
+    const double DUPLICATE_LINE_EPSILON = 1e-9;
+
+    static bool positionLess(const AuxiliaryLine& line, double position) {
+        return line.getPosition() < position;
+    }
+
+    int DynamicGrid::insertAuxLine(double position, bool isHorizontal) {
+        std::vector<AuxiliaryLine>& lines = isHorizontal ? horizontalAuxLines : verticalAuxLines;
+        const char* axisName = isHorizontal ? "Horizontal" : "Vertical";
+        const char* coordName = isHorizontal ? "y" : "x";
+
+        // The lines are sorted, so only the first line at or above position - epsilon can collide
+        auto it = std::lower_bound(lines.begin(), lines.end(), position - DUPLICATE_LINE_EPSILON, positionLess);
+        if (it != lines.end() && std::abs(it->getPosition() - position) < DUPLICATE_LINE_EPSILON) {
+            std::cout << axisName << " auxiliary line already exists at " << coordName << "=" << it->getPosition() << std::endl;
+            return it->getMemberList();
         }
         
-        // Create new horizontal auxiliary line with initial vote count of 1
-        AuxiliaryLine newLine(position, true, 1);
-        horizontalAuxLines.push_back(newLine);
+        // Create new auxiliary line with initial vote count of 1
+        AuxiliaryLine newLine(position, isHorizontal, 1);
+        int handle = createLine(newLine, Span<int>(), AuxLineStats(isHorizontal, true));
+        lines.insert(std::lower_bound(lines.begin(), lines.end(), position, positionLess), newLine);
+        invalidateLineIndex();
+        attachVerticesToLines(isHorizontal);
         
-        // Keep the lines sorted by position
-        std::sort(horizontalAuxLines.begin(), horizontalAuxLines.end(),
-                  [](const AuxiliaryLine& a, const AuxiliaryLine& b) {
-                      return a.getPosition() < b.getPosition();
-                  });
-        
-        std::cout << "Added horizontal auxiliary line at y=" << position << std::endl;
+        std::cout << "Added " << (isHorizontal ? "horizontal" : "vertical") << " auxiliary line at "
+                  << coordName << "=" << position << std::endl;
+        return handle;
     }
 
-    void DynamicGrid::addVerticalAuxLine(double position) {
-        // Check if a vertical line already exists at this position (within tolerance)
-        for (const auto& vLine : verticalAuxLines) {
-            if (std::abs(vLine.getPosition() - position) < 1e-9) {
-                std::cout << "Vertical auxiliary line already exists at x=" << vLine.getPosition() << std::endl;
-                return;
+    std::vector<int> DynamicGrid::insertAuxLines(const std::vector<double>& positions, bool isHorizontal) {
+        std::vector<AuxiliaryLine>& lines = isHorizontal ? horizontalAuxLines : verticalAuxLines;
+        std::vector<int> handles(positions.size(), -1);
+
+        std::vector<int> order(positions.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        std::stable_sort(order.begin(), order.end(), [&positions](int a, int b) { return positions[a] < positions[b]; });
+
+        // New lines go to the back in ascending order, then one merge restores the order
+        const size_t oldSize = lines.size();
+        auto existing = lines.begin();
+        for (int i : order) {
+            double position = positions[i];
+            existing = std::lower_bound(existing, lines.begin() + oldSize, position - DUPLICATE_LINE_EPSILON, positionLess);
+            if (existing != lines.begin() + oldSize && std::abs(existing->getPosition() - position) < DUPLICATE_LINE_EPSILON) {
+                handles[i] = existing->getMemberList();
+            }
+            else if (lines.size() > oldSize && std::abs(lines.back().getPosition() - position) < DUPLICATE_LINE_EPSILON) {
+                handles[i] = lines.back().getMemberList();
+            }
+            else {
+                size_t offset = existing - lines.begin();
+                lines.emplace_back(position, isHorizontal, 1);
+                handles[i] = createLine(lines.back(), Span<int>(), AuxLineStats(isHorizontal, true));
+                existing = lines.begin() + offset;
             }
         }
-        
-        // Create new vertical auxiliary line with initial vote count of 1
-        AuxiliaryLine newLine(position, false, 1);
-        verticalAuxLines.push_back(newLine);
-        
-        // Keep the lines sorted by position
-        std::sort(verticalAuxLines.begin(), verticalAuxLines.end(),
-                  [](const AuxiliaryLine& a, const AuxiliaryLine& b) {
-                      return a.getPosition() < b.getPosition();
-                  });
-        
-        std::cout << "Added vertical auxiliary line at x=" << position << std::endl;
+
+        if (lines.size() > oldSize) {
+            std::inplace_merge(lines.begin(), lines.begin() + oldSize, lines.end(),
+                               [](const AuxiliaryLine& a, const AuxiliaryLine& b) { return a.getPosition() < b.getPosition(); });
+            invalidateLineIndex();
+            attachVerticesToLines(isHorizontal);
+            std::cout << "Added " << (lines.size() - oldSize) << (isHorizontal ? " horizontal" : " vertical")
+                      << " auxiliary lines" << std::endl;
+        }
+        return handles;
+    }
+
+    int DynamicGrid::addHorizontalAuxLine(double position) {
+        return insertAuxLine(position, true);
+    }
+
+    int DynamicGrid::addVerticalAuxLine(double position) {
+        return insertAuxLine(position, false);
+    }
+
+    std::vector<int> DynamicGrid::addHorizontalAuxLines(const std::vector<double>& positions) {
+        return insertAuxLines(positions, true);
+    }
+
+    std::vector<int> DynamicGrid::addVerticalAuxLines(const std::vector<double>& positions) {
+        return insertAuxLines(positions, false);
+    }
+
+    void DynamicGrid::mergeAuxLines(const DynamicGrid& other) {
+        invalidateLineIndex();
+        // The other grid's vertices are not placed here; rebuildVertexLineMappings restores it
+        occupancy.clear();
+        occupancyValid = false;
+        // The merged position lies between the two merged lines, so the order is kept
+        auto mergeInto = [this, &other](std::vector<AuxiliaryLine>& lines, const std::vector<AuxiliaryLine>& incoming) {
+            for (const AuxiliaryLine& line : incoming) {
+                double position = line.getPosition();
+                auto it = std::lower_bound(lines.begin(), lines.end(), position,
+                    [](const AuxiliaryLine& l, double p) { return l.getPosition() < p; });
+
+                // closest existing line on either side
+                auto nearest = lines.end();
+                if (it != lines.end() && std::abs(it->getPosition() - position) <= tolerance) {
+                    nearest = it;
+                }
+                if (it != lines.begin() && std::abs(std::prev(it)->getPosition() - position) <= tolerance &&
+                    (nearest == lines.end() || position - std::prev(it)->getPosition() < nearest->getPosition() - position)) {
+                    nearest = std::prev(it);
+                }
+
+                const AuxLineStats& stats = other.lineStats[line.getMemberList()];
+                if (nearest == lines.end()) {
+                    AuxiliaryLine copy(line);
+                    createLine(copy, line.getVertexIDs(), stats);
+                    lines.insert(it, copy);
+                    continue;
+                }
+
+                // vertices in the overlap of two tiles come with both lines; count them once
+                Span<int> members = nearest->getVertexIDs();
+                std::vector<int> fresh;
+                for (int vertexID : line.getVertexIDs()) {
+                    if (std::find(members.begin(), members.end(), vertexID) == members.end()) fresh.push_back(vertexID);
+                }
+                int duplicates = static_cast<int>(line.getVertexIDs().size() - fresh.size());
+                int added = std::max(0, line.getVoteCount() - duplicates);
+
+                int votes = nearest->getVoteCount() + added;
+                double merged = (votes > 0)
+                    ? (nearest->getPosition() * nearest->getVoteCount() + position * added) / votes
+                    : 0.5 * (nearest->getPosition() + position);
+                nearest->setPosition(merged);
+                nearest->setVoteCount(votes);
+                memberPool.append(nearest->getMemberList(), Span<int>(fresh));
+
+                // the shared members' share of the stats is dropped pro rata
+                AuxLineStats share = stats;
+                if (duplicates > 0 && stats.count > 0) {
+                    double kept = static_cast<double>(fresh.size()) / stats.count;
+                    share.count = static_cast<int>(fresh.size());
+                    share.extraDegree = static_cast<int>(std::lround(stats.extraDegree * kept));
+                    share.sum = stats.sum * kept;
+                    share.sumSq = stats.sumSq * kept;
+                }
+                lineStats[nearest->getMemberList()].merge(share);
+                rescoreLine(nearest->getMemberList());
+            }
+        };
+
+        mergeInto(horizontalAuxLines, other.horizontalAuxLines);
+        mergeInto(verticalAuxLines, other.verticalAuxLines);
     }
 
-    // Placeholder implementation for electKeyAuxLines
-    // TODO: Implement the logic to select key auxiliary lines if needed
     void DynamicGrid::electKeyAuxLines() {
-        // Empty implementation for now
-        // Future: Add logic to filter/select key auxiliary lines based on importance
+        std::vector<char> dropped(memberPool.listCount(), 0);
+        int droppedNum = 0;
+        const double minScore = minVoteThreshold + KEY_LINE_SCORE_MARGIN;
+        while (!electionHeap.empty() && electionHeap.topKey() < minScore) {
+            int list = electionHeap.pop();
+            memberPool.clearList(list);
+            dropped[list] = 1;
+            ++droppedNum;
+        }
+        if (droppedNum == 0) return;
+
+        auto isDropped = [&dropped](const AuxiliaryLine& line) { return dropped[line.getMemberList()] != 0; };
+        horizontalAuxLines.erase(std::remove_if(horizontalAuxLines.begin(), horizontalAuxLines.end(), isDropped),
+                                 horizontalAuxLines.end());
+        verticalAuxLines.erase(std::remove_if(verticalAuxLines.begin(), verticalAuxLines.end(), isDropped),
+                               verticalAuxLines.end());
+        invalidateLineIndex();
+
+        std::vector<std::pair<int, bool>> detached;
+        occupancy.forEach([&](int vertexID, const Coord2&, int hLine, int vLine) {
+            if (hLine >= 0 && dropped[hLine]) detached.emplace_back(vertexID, true);
+            if (vLine >= 0 && dropped[vLine]) detached.emplace_back(vertexID, false);
+        });
+        for (const auto& pair : detached) {
+            occupancy.setLine(pair.first, pair.second, -1);
+        }
+        std::cout << "Elected key auxiliary lines: dropped " << droppedNum << ", kept "
+                  << getKeyAuxLineCount() << std::endl;
+    }
+
+    void DynamicGrid::moveVertex(int vertexID, const Coord2& oldPos, const Coord2& newPos, int degree) {
+        for (int axis = 0; axis < 2; ++axis) {
+            bool isHorizontal = (axis == 0);
+            const std::vector<AuxiliaryLine>& lines = isHorizontal ? horizontalAuxLines : verticalAuxLines;
+            const AxisLineIndex& index = isHorizontal ? getHALIndex() : getVALIndex();
+            double oldAcross = isHorizontal ? oldPos.y() : oldPos.x();
+            double newAcross = isHorizontal ? newPos.y() : newPos.x();
+            double oldAlong = isHorizontal ? oldPos.x() : oldPos.y();
+            double newAlong = isHorizontal ? newPos.x() : newPos.y();
+
+            // Built lines gather vertices within tolerance, so look for the old line that far
+            int from = -1;
+            std::pair<int, int> slots = index.range(oldAcross - std::max(tolerance, MEMBERSHIP_EPSILON),
+                                                    oldAcross + std::max(tolerance, MEMBERSHIP_EPSILON));
+            for (int slot = slots.first; slot < slots.second && from < 0; ++slot) {
+                int list = lines[index.lineIndex(slot)].getMemberList();
+                int memberSlot = memberPool.slotOf(list, vertexID);
+                if (memberSlot >= 0) {
+                    memberPool.removeAt(list, memberSlot);
+                    from = list;
+                    lineStats[list].remove(oldAlong, degree);
+                }
+            }
+
+            int to = index.firstWithin(newAcross, MEMBERSHIP_EPSILON);
+            if (to >= 0) {
+                int list = lines[to].getMemberList();
+                memberPool.append(list, vertexID);
+                lineStats[list].add(newAlong, degree);
+                rescoreLine(list);
+            }
+            if (from >= 0 && (to < 0 || lines[to].getMemberList() != from)) {
+                rescoreLine(from);
+            }
+        }
+        if (occupancyValid) {
+            placeVertex(vertexID, newPos);
+        }
     }
 
     void DynamicGrid::updateHorizontalLinePositions(const std::vector<double>& newPositions) {
+        invalidateLineIndex();
         if (newPositions.size() != horizontalAuxLines.size()) {
             std::cerr << "Error: Size mismatch in updateHorizontalLinePositions. Expected " 
                      << horizontalAuxLines.size() << ", got " << newPositions.size() << std::endl;
@@ -204,6 +624,7 @@ namespace Map {
     }
 
     void DynamicGrid::updateVerticalLinePositions(const std::vector<double>& newPositions) {
+        invalidateLineIndex();
         if (newPositions.size() != verticalAuxLines.size()) {
             std::cerr << "Error: Size mismatch in updateVerticalLinePositions. Expected " 
                      << verticalAuxLines.size() << ", got " << newPositions.size() << std::endl;
@@ -224,41 +645,53 @@ namespace Map {
     void DynamicGrid::rebuildVertexLineMappings(const BaseUGraphProperty& graph) {
         std::cout << "=== Rebuilding Vertex-Line Mappings ===" << std::endl;
         
-        const double EPSILON = 1e-2;
-        
-        // Clear existing vertexIDs for all lines
-        for (auto& hLine : horizontalAuxLines) {
-            hLine.setVertexIDs(std::vector<int>());
-        }
-        for (auto& vLine : verticalAuxLines) {
-            vLine.setVertexIDs(std::vector<int>());
+        // Refill the member lists in place; their slabs are kept, so a rebuild of
+        // similar memberships is linear and does not allocate
+        const AxisLineIndex& hLineIndex = getHALIndex();
+        const AxisLineIndex& vLineIndex = getVALIndex();
+        for (auto* lines : {&horizontalAuxLines, &verticalAuxLines}) {
+            for (auto& line : *lines) {
+                if (line.getMemberList() < 0) {
+                    createLine(line, Span<int>(), AuxLineStats(line.getIsHorizontal()));
+                }
+                memberPool.clearList(line.getMemberList());
+                AuxLineStats& stats = lineStats[line.getMemberList()];
+                stats = AuxLineStats(stats.isHorizontal, stats.pinned);
+            }
         }
         
-        // Scan all vertices and assign them to appropriate auxiliary lines
+        occupancy.clear();
+        std::vector<int> vertexIDs, degrees;
+        // Assign every vertex to the first line (in line order) within MEMBERSHIP_EPSILON
         auto vp = boost::vertices(graph);
         for (auto vit = vp.first; vit != vp.second; ++vit) {
             const BaseVertexProperty& vertex = graph[*vit];
             int vertexID = vertex.getID();
             Coord2 pos = vertex.getCoord();
+            int degree = static_cast<int>(boost::out_degree(*vit, graph));
+            vertexIDs.push_back(vertexID);
+            degrees.push_back(degree);
             
-            // Check horizontal auxiliary lines
-            for (auto& hLine : horizontalAuxLines) {
-                if (std::abs(pos.y() - hLine.getPosition()) < EPSILON) {
-                    std::vector<int> currentIDs = hLine.getVertexIDs();
-                    currentIDs.push_back(vertexID);
-                    hLine.setVertexIDs(currentIDs);
-                    break;
-                }
+            int h = hLineIndex.firstWithin(pos.y(), MEMBERSHIP_EPSILON);
+            if (h >= 0) {
+                memberPool.append(horizontalAuxLines[h].getMemberList(), vertexID);
+                lineStats[horizontalAuxLines[h].getMemberList()].add(pos.x(), degree);
             }
             
-            // Check vertical auxiliary lines
-            for (auto& vLine : verticalAuxLines) {
-                if (std::abs(pos.x() - vLine.getPosition()) < EPSILON) {
-                    std::vector<int> currentIDs = vLine.getVertexIDs();
-                    currentIDs.push_back(vertexID);
-                    vLine.setVertexIDs(currentIDs);
-                    break;
-                }
+            int v = vLineIndex.firstWithin(pos.x(), MEMBERSHIP_EPSILON);
+            if (v >= 0) {
+                memberPool.append(verticalAuxLines[v].getMemberList(), vertexID);
+                lineStats[verticalAuxLines[v].getMemberList()].add(pos.y(), degree);
+            }
+            occupancy.place(vertexID, pos,
+                            h >= 0 ? horizontalAuxLines[h].getMemberList() : -1,
+                            v >= 0 ? verticalAuxLines[v].getMemberList() : -1);
+        }
+        occupancy.setPriority(degreeOrder(vertexIDs, degrees));
+        occupancyValid = true;
+        for (auto* lines : {&horizontalAuxLines, &verticalAuxLines}) {
+            for (const auto& line : *lines) {
+                rescoreLine(line.getMemberList());
             }
         }
         
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <cmath>
 #include <map>
+#include <cstdint>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846  // Fallback definition for M_PI
@@ -18,6 +19,8 @@
 #include <boost/graph/iteration_macros.hpp>
 #include "MapFileReader.h"
 #include "EdgeOrientation.h"
+#include "IndexedAdjacency.h"
+#include "ThreadPool.h"
 
 namespace Map {
 
@@ -29,12 +32,167 @@ namespace Map {
     const double LAMBDA_V = 1.0;                                                    // Weight for vertical edges
     const double BIG_M = 1000.0;                                                    // Big M parameter
     const double EDGE_LENGTH_THRESHOLD = 23.15;                                     // Edge length threshold
+    const bool   USE_PARALLEL_MARKING = false;                                      // Color-class parallel anti-overlap marking
+    const int    PARALLEL_MARKING_MIN_CHUNK = 256;                                  // Vertices per task in parallel marking
+
+    // angle normalization function -> [0, 2*PI)
+    static double normalizeAngle(double angle) {
+        while (angle < 0) {
+            angle += 2 * M_PI;
+        }
+        while (angle >= 2 * M_PI) {
+            angle -= 2 * M_PI;
+        }
+        return angle;
+    }
+
+    // Calculate minimum offset to an axis (0: vertical, 1: horizontal)
+    static double calculateAxisOffset(double edgeAngle, int axis) {
+        double normAngle = normalizeAngle(edgeAngle);
+        if (axis == 0) {  // Vertical: UP (90°) or DOWN (270°)
+            double offsetUp = std::abs(normAngle - M_PI / 2);
+            double offsetDown = std::abs(normAngle - 3 * M_PI / 2);
+            return std::min(offsetUp, offsetDown);
+        } else {  // Horizontal: RIGHT (0°) or LEFT (180°)
+            double offsetRight = std::min(std::abs(normAngle), std::abs(normAngle - 2 * M_PI));
+            double offsetLeft = std::abs(normAngle - M_PI);
+            return std::min(offsetRight, offsetLeft);
+        }
+    }
+
+    // Check if edge is within axis neighborhood
+    static bool inAxisNeighborhood(double edgeAngle, int axis) {
+        return calculateAxisOffset(edgeAngle, axis) <= ANGLE_THRESHOLD_DEG * M_PI / 180.0;
+    }
+
+    // Mark the unprocessed edges of vertex v on both axes.
+    // Reads and writes only v's incident edges and the counters of v and its neighbors.
+    static void markVertexEdges(
+        int v,
+        const IndexedAdjacency& adj,
+        const std::vector<BaseEdgeProperty>& edgeList,
+        std::vector<std::int8_t>& edgeOriented2V,
+        std::vector<std::int8_t>& edgeOriented2H,
+        std::vector<int> (&alignedCount)[2]) {
+
+        // Process both axes: 0=Vertical, 1=Horizontal
+        for (int axis = 0; axis < 2; ++axis) {
+            std::vector<std::int8_t>& edgeOrientedMarks = (axis == 0) ? edgeOriented2V : edgeOriented2H;
+            std::vector<int>& counts = alignedCount[axis];
+
+            // First pass: mark edges based on conflict detection
+            for (int k = adj.begin(v); k < adj.end(v); ++k) {
+                // edgeID is equivalent to edgeIndex
+                int edgeIndex = adj.edgeIDs[k];
+                if (edgeOrientedMarks[edgeIndex] != -1) {
+                    continue;
+                }
+
+                int other = adj.neighbors[k];
+                // Align unless the other vertex already has an aligned edge in this axis
+                if (inAxisNeighborhood(edgeList[edgeIndex].Angle(), axis) && counts[other] == 0) {
+                    edgeOrientedMarks[edgeIndex] = 1;
+                    counts[v]++;
+                    counts[other]++;
+                }
+                else {
+                    edgeOrientedMarks[edgeIndex] = 0;
+                }
+            }
+
+            // Second pass: keep only the closest edge among all aligned edges (oriented=1)
+            if (counts[v] <= 1) {
+                continue;
+            }
+
+            int bestK = -1;
+            double minOffset = 0.0;
+            for (int k = adj.begin(v); k < adj.end(v); ++k) {
+                if (edgeOrientedMarks[adj.edgeIDs[k]] != 1) {
+                    continue;
+                }
+                double offset = calculateAxisOffset(edgeList[adj.edgeIDs[k]].Angle(), axis);
+                if (bestK < 0 || offset < minOffset) {
+                    minOffset = offset;
+                    bestK = k;
+                }
+            }
+
+            // Set all other edges back to 0
+            for (int k = adj.begin(v); k < adj.end(v); ++k) {
+                if (k != bestK && edgeOrientedMarks[adj.edgeIDs[k]] == 1) {
+                    edgeOrientedMarks[adj.edgeIDs[k]] = 0;
+                    counts[v]--;
+                    counts[adj.neighbors[k]]--;
+                }
+            }
+        }
+    }
+
+    void markEdgeOrientations(
+        const IndexedAdjacency& adj,
+        const std::vector<BaseEdgeProperty>& edgeList,
+        std::vector<std::int8_t>& edgeOriented2V,
+        std::vector<std::int8_t>& edgeOriented2H) {
+
+        const int vertexNum = adj.vertexCount();
+
+        // alignedCount[axis][v]: number of edges incident to v currently marked 1 on that axis.
+        // Replaces the scan over the other vertex's out-edges with an O(1) lookup.
+        std::vector<int> alignedCount[2] = { std::vector<int>(vertexNum, 0), std::vector<int>(vertexNum, 0) };
+
+        // !!! Main loop: for each vertex (sorted by out-degree)
+        for (int v : sortVerticesByDegree(adj)) {
+            markVertexEdges(v, adj, edgeList, edgeOriented2V, edgeOriented2H, alignedCount);
+        }
+    }
+
+    void markEdgeOrientationsParallel(
+        const IndexedAdjacency& adj,
+        const std::vector<BaseEdgeProperty>& edgeList,
+        std::vector<std::int8_t>& edgeOriented2V,
+        std::vector<std::int8_t>& edgeOriented2H,
+        ThreadPool& pool) {
+
+        const int vertexNum = adj.vertexCount();
+        std::vector<int> alignedCount[2] = { std::vector<int>(vertexNum, 0), std::vector<int>(vertexNum, 0) };
+
+        // A vertex reads the counters of its neighbors, which are written by every vertex
+        // within two hops, so classes must be independent in the square of the graph.
+        std::vector<int> order = sortVerticesByDegree(adj);
+        int colorNum = 0;
+        std::vector<int> colors = colorDistance2(adj, order, colorNum);
+
+        // Bucket vertices by color, keeping the degree order inside every class
+        std::vector<int> classStart(colorNum + 1, 0);
+        for (int v = 0; v < vertexNum; ++v) {
+            classStart[colors[v] + 1]++;
+        }
+        for (int c = 0; c < colorNum; ++c) {
+            classStart[c + 1] += classStart[c];
+        }
+        std::vector<int> classMembers(vertexNum);
+        std::vector<int> fill(classStart.begin(), classStart.end() - 1);
+        for (int v : order) {
+            classMembers[fill[colors[v]]++] = v;
+        }
+
+        std::cout << "Parallel marking: " << colorNum << " color classes on " 
+                  << pool.concurrency() << " threads" << std::endl;
+
+        for (int c = 0; c < colorNum; ++c) {
+            pool.parallelFor(classStart[c], classStart[c + 1], [&](int i) {
+                markVertexEdges(classMembers[i], adj, edgeList, edgeOriented2V, edgeOriented2H, alignedCount);
+            }, PARALLEL_MARKING_MIN_CHUNK);
+        }
+    }
 
     int optimizeEdgeOrientation(
         std::vector<BaseVertexProperty>& vertexList, 
         std::vector<BaseEdgeProperty>& edgeList, 
         BaseUGraphProperty& graph,
-        const std::string& testCaseName) {
+        const std::string& testCaseName,
+        const std::vector<char>* fixedVertices) {
         try {
             std::cout << "=== Starting Edge Orientation Optimization ===" << std::endl;
         
@@ -63,17 +221,21 @@ namespace Map {
         
             // Create Gurobi environment and model
             GRBEnv env(true);
-            env.set("LogFile", "edge_orientation_opt.log");
+            env.set("LogFile", "output/" + testCaseName + "_edge_orientation_opt.log");
             env.start();
             GRBModel model(env);
         
             // ---------------------------------------------------------------------------------------------------------
             // Create decision variables
             // ---------------------------------------------------------------------------------------------------------
+            auto isFixed = [fixedVertices](int i) { return fixedVertices && (*fixedVertices)[i]; };
             std::vector<GRBVar> X(vertexNum), Y(vertexNum);
             for (int i = 0; i < vertexNum; ++i) {
-                X[i] = model.addVar(x_min, x_max, 0.0, GRB_CONTINUOUS, "X_" + std::to_string(i));
-                Y[i] = model.addVar(y_min, y_max, 0.0, GRB_CONTINUOUS, "Y_" + std::to_string(i));
+                // fixed vertices: bounds collapsed onto the current position
+                double x = vertexList[i].getCoord().x();
+                double y = vertexList[i].getCoord().y();
+                X[i] = model.addVar(isFixed(i) ? x : x_min, isFixed(i) ? x : x_max, 0.0, GRB_CONTINUOUS, "X_" + std::to_string(i));
+                Y[i] = model.addVar(isFixed(i) ? y : y_min, isFixed(i) ? y : y_max, 0.0, GRB_CONTINUOUS, "Y_" + std::to_string(i));
                 
                 // Set initial values to original coordinates
                 X[i].set(GRB_DoubleAttr_Start, vertexList[i].getCoord().x());
@@ -86,206 +248,40 @@ namespace Map {
             
             std::cout << "=== Anti-overlap Processing ===" << std::endl;
 
-            std::vector<std::pair<int, size_t>> degVertIdxPairs;
-            // !!! vertex iterator
-            std::pair<BaseUGraphProperty::vertex_iterator, BaseUGraphProperty::vertex_iterator> vp = vertices(graph);
-
-            int vertexIndex = 0;
-            for (BaseUGraphProperty::vertex_iterator vi = vp.first; vi != vp.second; ++vi, ++vertexIndex) {
-                size_t out_degree = boost::out_degree(*vi, graph);
-                degVertIdxPairs.push_back({out_degree, vertexIndex});
-            }
-
-            std::sort(
-                degVertIdxPairs.begin(),
-                degVertIdxPairs.end(),
-                [](const auto& a, const auto& b) { return a.first > b.first; } );
-
-            std::cout << "Vertex processing order (by out-degree):" << std::endl;
-            for (const auto& pair : degVertIdxPairs) {
-                std::cout << "Vertex " << vertexList[pair.second].getID() << " (degree: " << pair.first << ")" << std::endl;
-            }
-
-            // Initialize edge orientation states to -1 (unprocessed)
             // -1: unprocessed, 0: explicitly not aligned, 1: aligned
-            std::vector<int> edgeOriented2V(edgeNum, -1);
-            std::vector<int> edgeOriented2H(edgeNum, -1);
+            std::vector<std::int8_t> edgeOriented2V(edgeNum, -1);
+            std::vector<std::int8_t> edgeOriented2H(edgeNum, -1);
 
-            const double ANGLE_CENTERS[2] = {M_PI / 2, 0.0};  // Vertical (UP/DOWN), Horizontal (LEFT/RIGHT)
-            const std::string AXIS_NAMES[2] = {"VERTICAL", "HORIZONTAL"};
-
-            // angle normalization function -> [0, 2*PI)
-            auto normalizeAngle = [](double angle) -> double {
-                while(angle < 0) {
-                    angle += 2 * M_PI;
-                }
-                while(angle >= 2 * M_PI) {
-                    angle -= 2 * M_PI;
-                }
-                return angle;
-            };
-
-            // Calculate minimum offset to an axis (vertical or horizontal)
-            auto calculateAxisOffset = [&](double edge_angle, int axis) -> double {
-                double norm_angle = normalizeAngle(edge_angle);
-                if (axis == 0) {  // Vertical: UP (90°) or DOWN (270°)
-                    double offsetUp = std::abs(norm_angle - M_PI / 2);
-                    double offsetDown = std::abs(norm_angle - 3 * M_PI / 2);
-                    return std::min(offsetUp, offsetDown);
-                } else {  // Horizontal: RIGHT (0°) or LEFT (180°)
-                    double offsetRight = std::min(std::abs(norm_angle), std::abs(norm_angle - 2 * M_PI));
-                    double offsetLeft = std::abs(norm_angle - M_PI);
-                    return std::min(offsetRight, offsetLeft);
-                }
-            };
-            
-            // Check if edge is within axis neighborhood
-            auto inAxisNeighborhood = [&](double edge_angle, int axis) -> bool {
-                double offset = calculateAxisOffset(edge_angle, axis);
-                double threshold_rad = ANGLE_THRESHOLD_DEG * M_PI / 180.0;
-                return offset <= threshold_rad;
-            };
-            
-            // Get the other vertex of an edge given current vertex
-            auto theOtherVertexDesc = [&](BaseUGraphProperty::edge_descriptor edge_desc, BaseUGraphProperty::vertex_descriptor current) -> BaseUGraphProperty::vertex_descriptor {
-                BaseUGraphProperty::vertex_descriptor source = boost::source(edge_desc, graph);
-                BaseUGraphProperty::vertex_descriptor target = boost::target(edge_desc, graph);
-                return (source == current) ? target : source;
-            };
-
-            // !!! Main loop: for each vertex (sorted by out-degree)
-            for (const auto& pair : degVertIdxPairs) {
-                size_t currentVertexIndex = pair.second;
-                
-                // Get corresponding vertex descriptor
-                BaseUGraphProperty::vertex_iterator vi = vp.first;
-                std::advance(vi, currentVertexIndex);
-                BaseUGraphProperty::vertex_descriptor currentVertex = *vi;
-                unsigned int currentVertexID = graph[currentVertex].getID();
-                
-                std::cout << "\n=== Processing vertex " << currentVertexIndex << " (ID: " << currentVertexID << ") ===" << std::endl;
-                
-                // Process both axes: 0=Vertical, 1=Horizontal
-                for (int axis = 0; axis < 2; ++axis) {
-                    std::vector<int>& edgeOrientedMarks = (axis == 0) ? edgeOriented2V : edgeOriented2H;
-                    bool flag = false;  // Flag to track if other vertex already has aligned edge
-                    
-                    std::cout << "\n  Processing " << AXIS_NAMES[axis] << " axis:" << std::endl;
-                    
-                    // First pass: mark edges based on conflict detection
-                    std::pair<BaseUGraphProperty::out_edge_iterator, BaseUGraphProperty::out_edge_iterator> oep = boost::out_edges(currentVertex, graph);
-                    
-                    // !!! Traverse out-edges of the current vertex
-                    for (BaseUGraphProperty::out_edge_iterator oeit = oep.first; oeit != oep.second; ++oeit) {
-                        int edgeIndex = graph[*oeit].ID();
-                        
-                        // Skip if already processed
-                        if (edgeOrientedMarks[edgeIndex] != -1) {
-                            std::cout << "    Edge " << edgeIndex << " already processed (state=" << edgeOrientedMarks[edgeIndex] << "), skip" << std::endl;
-                            continue;
-                        }
-                        
-                        // edgeID is equivalent to edgeIndex
-                        const BaseEdgeProperty& edge = edgeList[edgeIndex];
-                        double edge_angle = edge.Angle();
-                        
-                        // Check if edge is within axis neighborhood
-                        if (inAxisNeighborhood(edge_angle, axis)) {
-                            std::cout << "    Edge " << edgeIndex << " is in " << AXIS_NAMES[axis] << " neighborhood (angle=" << edge_angle * 180.0 / M_PI << "°)" << std::endl;
-                            
-                            // Get the other vertex of this edge
-                            BaseUGraphProperty::vertex_descriptor oVertex = theOtherVertexDesc(*oeit, currentVertex);
-                            
-                            // Check if other vertex already has an aligned edge in this axis
-                            flag = false;
-                            std::pair<BaseUGraphProperty::out_edge_iterator, BaseUGraphProperty::out_edge_iterator> ooep = boost::out_edges(oVertex, graph);
-                            
-                            for (BaseUGraphProperty::out_edge_iterator ooeit = ooep.first; ooeit != ooep.second; ++ooeit) {
-                                int otherEdgeIndex = graph[*ooeit].ID();
-                                if (edgeOrientedMarks[otherEdgeIndex] == 1) {
-                                    flag = true;
-                                    std::cout << "      Conflict detected! The other vertex has aligned edge " << otherEdgeIndex << std::endl;
-                                    break;
-                                }
-                            }
-                            
-                            // Mark the edge based on conflict status
-                            if (!flag) {
-                                edgeOrientedMarks[edgeIndex] = 1;
-                                std::cout << "      Set edge " << edgeIndex << " " << AXIS_NAMES[axis] << " = 1 (aligned)" << std::endl;
-                                flag = false;  // Reset for next edge
-                            } 
-                            else {
-                                edgeOrientedMarks[edgeIndex] = 0;
-                                std::cout << "      Set edge " << edgeIndex << " " << AXIS_NAMES[axis] << " = 0 (conflict)" << std::endl;
-                            }
-                        } 
-                        else {
-                            // Not in neighborhood
-                            edgeOrientedMarks[edgeIndex] = 0;
-                            std::cout << "    Edge " << edgeIndex << " not in " << AXIS_NAMES[axis] << " neighborhood, set to 0" << std::endl;
-                        }
-                    }
-                    
-                    // Second pass: keep only the closest edge among all aligned edges (oriented=1)
-                    std::vector<int> candEdges;
-                    oep = boost::out_edges(currentVertex, graph);
-                    
-                    for (BaseUGraphProperty::out_edge_iterator eit = oep.first; eit != oep.second; ++eit) {
-                        int edgeIndex = graph[*eit].ID();
-                        if (edgeOrientedMarks[edgeIndex] == 1) {
-                            candEdges.push_back(edgeIndex);
-                        }
-                    }
-                    
-                    if (candEdges.size() > 1) {
-                        std::cout << "  Multiple aligned edges detected (" << candEdges.size() << "), selecting closest to " << AXIS_NAMES[axis] << " axis" << std::endl;
-                        
-                        // Find the edge closest to the axis
-                        int bestEdge = candEdges[0];
-                        double minOffset = calculateAxisOffset(edgeList[bestEdge].Angle(), axis);
-                        
-                        for (int edgeIndex : candEdges) {
-                            double offset = calculateAxisOffset(edgeList[edgeIndex].Angle(), axis);
-                            std::cout << "    Edge " << edgeIndex << " offset: " << offset * 180.0 / M_PI << "°" << std::endl;
-                            if (offset < minOffset) {
-                                minOffset = offset;
-                                bestEdge = edgeIndex;
-                            }
-                        }
-                        
-                        // Set all other edges back to 0
-                        for (int edgeIndex : candEdges) {
-                            if (edgeIndex != bestEdge) {
-                                edgeOrientedMarks[edgeIndex] = 0;
-                                std::cout << "    Unmark edge " << edgeIndex << " (not the closest)" << std::endl;
-                            }
-                        }
-                        
-                        std::cout << "  Final choice: Edge " << bestEdge << " (offset: " << minOffset * 180.0 / M_PI << "°)" << std::endl;
+            // an edge between two fixed vertices cannot follow its orientation
+            if (fixedVertices) {
+                for (int e = 0; e < edgeNum; ++e) {
+                    if (isFixed(vertexID2Index[edgeList[e].Source().getID()]) && isFixed(vertexID2Index[edgeList[e].Target().getID()])) {
+                        edgeOriented2V[e] = 0;
+                        edgeOriented2H[e] = 0;
                     }
                 }
             }
 
-            std::cout << "\n=== Anti-overlap Processing Completed ===" << std::endl;
+            IndexedAdjacency adj = buildIndexedAdjacency(graph);
+            if (USE_PARALLEL_MARKING) {
+                markEdgeOrientationsParallel(adj, edgeList, edgeOriented2V, edgeOriented2H, ThreadPool::shared());
+            }
+            else {
+                markEdgeOrientations(adj, edgeList, edgeOriented2V, edgeOriented2H);
+            }
+
+            std::cout << "=== Anti-overlap Processing Completed ===" << std::endl;
             
             // Apply final orientation states to edgeList
-            std::cout << "\n=== Final Edge Orientations ===" << std::endl;
+            int numOriented2V = 0, numOriented2H = 0;
             for (int e = 0; e < edgeNum; ++e) {
-                if (edgeOriented2V[e] == 1) {
-                    edgeList[e].setOriented2V(true);
-                    std::cout << "Edge " << e << ": Oriented2V = true" << std::endl;
-                } else {
-                    edgeList[e].setOriented2V(false);
-                }
-                
-                if (edgeOriented2H[e] == 1) {
-                    edgeList[e].setOriented2H(true);
-                    std::cout << "Edge " << e << ": Oriented2H = true" << std::endl;
-                } else {
-                    edgeList[e].setOriented2H(false);
-                }
+                edgeList[e].setOriented2V(edgeOriented2V[e] == 1);
+                edgeList[e].setOriented2H(edgeOriented2H[e] == 1);
+                numOriented2V += (edgeOriented2V[e] == 1);
+                numOriented2H += (edgeOriented2H[e] == 1);
             }
+            std::cout << "Edges oriented to V: " << numOriented2V << ", to H: " << numOriented2H 
+                      << " (of " << edgeNum << ")" << std::endl;
 
             // ---------------------------------------------------------------------------------------------------------
             // Add constraints
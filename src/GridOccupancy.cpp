@@ -0,0 +1,124 @@
+//------------------------------------------------------------------------------
+// GridOccupancy.cpp - Which auxiliary line intersection every vertex sits on
+//------------------------------------------------------------------------------
+
+#include "GridOccupancy.h"
+#include <limits>
+#include <utility>
+
+namespace Map {
+
+    void GridOccupancy::clear( void ) {
+        cells.clear();
+        counts.clear();
+        priority.clear();
+        danglingNum = 0;
+        danglingColumns.clear();
+        danglingRows.clear();
+    }
+
+    void GridOccupancy::bucket(AxisBuckets& buckets, double key, double order, int vertexID, int delta) {
+        if (delta > 0) {
+            buckets[key].emplace(order, vertexID);
+            return;
+        }
+        auto it = buckets.find(key);
+        if (it == buckets.end()) return;
+        it->second.erase(std::make_pair(order, vertexID));
+        if (it->second.empty()) buckets.erase(it);
+    }
+
+    // Every cell is counted once, either on its intersection or as dangling
+    void GridOccupancy::count(int vertexID, const Cell& cell, int delta) {
+        if (cell.hLine < 0 || cell.vLine < 0) {
+            danglingNum += delta;
+            bucket(danglingColumns, cell.pos.x(), cell.pos.y(), vertexID, delta);
+            bucket(danglingRows, cell.pos.y(), cell.pos.x(), vertexID, delta);
+            return;
+        }
+        auto it = counts.emplace(key(cell.hLine, cell.vLine), 0).first;
+        it->second += delta;
+        if (it->second == 0) counts.erase(it);
+    }
+
+    void GridOccupancy::place(int vertexID, const Coord2& pos, int hLine, int vLine) {
+        auto it = cells.find(vertexID);
+        if (it != cells.end()) {
+            count(vertexID, it->second, -1);
+            it->second = {pos, hLine, vLine};
+        }
+        else {
+            it = cells.emplace(vertexID, Cell{pos, hLine, vLine}).first;
+        }
+        count(vertexID, it->second, +1);
+    }
+
+    void GridOccupancy::setLine(int vertexID, bool isHorizontal, int line) {
+        auto it = cells.find(vertexID);
+        if (it == cells.end()) return;
+        count(vertexID, it->second, -1);
+        (isHorizontal ? it->second.hLine : it->second.vLine) = line;
+        count(vertexID, it->second, +1);
+    }
+
+    int GridOccupancy::hLine(int vertexID) const {
+        auto it = cells.find(vertexID);
+        return it == cells.end() ? -1 : it->second.hLine;
+    }
+
+    int GridOccupancy::vLine(int vertexID) const {
+        auto it = cells.find(vertexID);
+        return it == cells.end() ? -1 : it->second.vLine;
+    }
+
+    bool GridOccupancy::isOnIntersection(int vertexID) const {
+        auto it = cells.find(vertexID);
+        return it != cells.end() && it->second.hLine >= 0 && it->second.vLine >= 0;
+    }
+
+    bool GridOccupancy::anyBetween(const AxisBuckets& buckets, double key, double tolerance, double lo, double hi) {
+        if (lo >= hi) return false;
+        // buckets whose key is within tolerance; normally a single one
+        for (auto it = buckets.upper_bound(key - tolerance); it != buckets.end() && it->first < key + tolerance; ++it) {
+            auto first = it->second.upper_bound(std::make_pair(lo, std::numeric_limits<int>::max()));
+            if (first != it->second.end() && first->first < hi) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool GridOccupancy::danglingInColumn(double column, double lo, double hi, double tolerance) const {
+        return anyBetween(danglingColumns, column, tolerance, lo, hi);
+    }
+
+    bool GridOccupancy::danglingInRow(double row, double lo, double hi, double tolerance) const {
+        return anyBetween(danglingRows, row, tolerance, lo, hi);
+    }
+
+    std::vector<int> GridOccupancy::danglingVertices( void ) const {
+        std::vector<int> vertexIDs;
+        vertexIDs.reserve(danglingNum);
+        for (int vertexID : priority) {
+            if (cells.count(vertexID) && isDangling(vertexID)) {
+                vertexIDs.push_back(vertexID);
+            }
+        }
+        return vertexIDs;
+    }
+
+    int GridOccupancy::occupants(int hLine, int vLine) const {
+        if (hLine < 0 || vLine < 0) return 0;
+        auto it = counts.find(key(hLine, vLine));
+        return it == counts.end() ? 0 : it->second;
+    }
+
+    bool GridOccupancy::isFree(int hLine, int vLine, int ignoreVertexID) const {
+        int n = occupants(hLine, vLine);
+        if (n > 0 && ignoreVertexID >= 0 && this->hLine(ignoreVertexID) == hLine && this->vLine(ignoreVertexID) == vLine) {
+            --n;
+        }
+        return n == 0;
+    }
+
+} // namespace Map
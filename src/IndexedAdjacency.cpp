@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+// IndexedAdjacency.cpp - Compact index-based adjacency implementation
+//------------------------------------------------------------------------------
+
+#include "IndexedAdjacency.h"
+#include <unordered_map>
+
+namespace Map {
+
+    IndexedAdjacency buildIndexedAdjacency(const BaseUGraphProperty& graph) {
+        IndexedAdjacency adj;
+
+        const int vertexNum = static_cast<int>(boost::num_vertices(graph));
+        adj.vertexDescs.reserve(vertexNum);
+        adj.offsets.assign(vertexNum + 1, 0);
+        adj.edgeIDs.reserve(2 * boost::num_edges(graph));
+        adj.neighbors.reserve(2 * boost::num_edges(graph));
+
+        std::unordered_map<BaseUGraphProperty::vertex_descriptor, int> desc2Index;
+        desc2Index.reserve(vertexNum);
+
+        auto vp = boost::vertices(graph);
+        for (auto vit = vp.first; vit != vp.second; ++vit) {
+            desc2Index[*vit] = static_cast<int>(adj.vertexDescs.size());
+            adj.vertexDescs.push_back(*vit);
+        }
+
+        for (int v = 0; v < vertexNum; ++v) {
+            BaseUGraphProperty::vertex_descriptor vd = adj.vertexDescs[v];
+            auto oep = boost::out_edges(vd, graph);
+            for (auto oeit = oep.first; oeit != oep.second; ++oeit) {
+                BaseUGraphProperty::vertex_descriptor source = boost::source(*oeit, graph);
+                BaseUGraphProperty::vertex_descriptor target = boost::target(*oeit, graph);
+                BaseUGraphProperty::vertex_descriptor other = (source == vd) ? target : source;
+
+                adj.edgeIDs.push_back(graph[*oeit].ID());
+                adj.neighbors.push_back(desc2Index[other]);
+            }
+            adj.offsets[v + 1] = static_cast<int>(adj.edgeIDs.size());
+        }
+
+        return adj;
+    }
+
+    std::vector<int> sortVerticesByDegree(const IndexedAdjacency& adj) {
+        const int vertexNum = adj.vertexCount();
+
+        int maxDegree = 0;
+        for (int v = 0; v < vertexNum; ++v) {
+            maxDegree = std::max(maxDegree, adj.degree(v));
+        }
+
+        // bucket start positions, highest degree first
+        std::vector<int> bucketStart(maxDegree + 2, 0);
+        for (int v = 0; v < vertexNum; ++v) {
+            bucketStart[maxDegree - adj.degree(v) + 1]++;
+        }
+        for (int d = 1; d < static_cast<int>(bucketStart.size()); ++d) {
+            bucketStart[d] += bucketStart[d - 1];
+        }
+
+        std::vector<int> order(vertexNum);
+        for (int v = 0; v < vertexNum; ++v) {
+            order[bucketStart[maxDegree - adj.degree(v)]++] = v;
+        }
+        return order;
+    }
+
+    std::vector<int> colorDistance2(const IndexedAdjacency& adj, const std::vector<int>& order, int& colorNum) {
+        const int vertexNum = adj.vertexCount();
+        std::vector<int> colors(vertexNum, -1);
+
+        // forbiddenStamp[c] == v + 1 means color c is taken within two hops of v
+        std::vector<int> forbiddenStamp;
+        colorNum = 0;
+
+        for (int v : order) {
+            int stamp = v + 1;
+            auto forbid = [&](int u) {
+                if (colors[u] >= 0) {
+                    forbiddenStamp[colors[u]] = stamp;
+                }
+            };
+
+            for (int k = adj.begin(v); k < adj.end(v); ++k) {
+                int u = adj.neighbors[k];
+                forbid(u);
+                for (int kk = adj.begin(u); kk < adj.end(u); ++kk) {
+                    if (adj.neighbors[kk] != v) {
+                        forbid(adj.neighbors[kk]);
+                    }
+                }
+            }
+
+            int color = 0;
+            while (color < colorNum && forbiddenStamp[color] == stamp) {
+                ++color;
+            }
+            if (color == colorNum) {
+                forbiddenStamp.push_back(0);
+                ++colorNum;
+            }
+            colors[v] = color;
+        }
+
+        return colors;
+    }
+
+} // namespace Map
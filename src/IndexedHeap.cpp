@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------------
+// IndexedHeap.cpp - Binary min-heap over integer IDs with key updates
+//------------------------------------------------------------------------------
+
+#include "IndexedHeap.h"
+
+namespace Map {
+
+    bool IndexedMinHeap::less(int a, int b) const {
+        return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+    }
+
+    void IndexedMinHeap::place(int i, int id) {
+        heap[i] = id;
+        slot[id] = i;
+    }
+
+    void IndexedMinHeap::siftUp(int i) {
+        int id = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!less(id, heap[parent])) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, id);
+    }
+
+    void IndexedMinHeap::siftDown(int i) {
+        int id = heap[i];
+        int n = static_cast<int>(heap.size());
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && less(heap[child + 1], heap[child])) ++child;
+            if (!less(heap[child], id)) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, id);
+    }
+
+    void IndexedMinHeap::update(int id, double key) {
+        if (id >= static_cast<int>(slot.size())) {
+            slot.resize(id + 1, -1);
+            keys.resize(id + 1, 0.0);
+        }
+        if (slot[id] < 0) {
+            keys[id] = key;
+            heap.push_back(id);
+            siftUp(static_cast<int>(heap.size()) - 1);
+            return;
+        }
+        double old = keys[id];
+        keys[id] = key;
+        if (key < old) siftUp(slot[id]);
+        else siftDown(slot[id]);
+    }
+
+    void IndexedMinHeap::erase(int id) {
+        if (!contains(id)) return;
+        int i = slot[id];
+        int last = heap.back();
+        heap.pop_back();
+        slot[id] = -1;
+        if (last != id) {
+            place(i, last);
+            siftUp(i);
+            siftDown(slot[last]);
+        }
+    }
+
+    int IndexedMinHeap::pop( void ) {
+        int id = heap.front();
+        erase(id);
+        return id;
+    }
+
+    void IndexedMinHeap::clear( void ) {
+        heap.clear();
+        slot.clear();
+        keys.clear();
+    }
+
+} // namespace Map
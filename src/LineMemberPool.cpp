@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+// LineMemberPool.cpp - Shared CSR-style storage of auxiliary line members
+//------------------------------------------------------------------------------
+
+#include "LineMemberPool.h"
+#include <algorithm>
+
+namespace Map {
+
+    // Abandoned slabs are only compacted above this many entries
+    const int COMPACT_MIN_DEAD = 1024;
+
+    int LineMemberPool::createList(int capacity) {
+        capacity = std::max(capacity, 0);
+        slabs.push_back({static_cast<int>(data.size()), 0, capacity});
+        data.resize(data.size() + capacity);
+        return static_cast<int>(slabs.size()) - 1;
+    }
+
+    int LineMemberPool::createList(Span<int> ids) {
+        int list = createList(static_cast<int>(ids.size()));
+        std::copy(ids.begin(), ids.end(), data.begin() + slabs[list].offset);
+        slabs[list].size = static_cast<int>(ids.size());
+        for (int slot = 0; slot < slabs[list].size; ++slot) {
+            slots[slotKey(list, ids[slot])] = slot;
+        }
+        return list;
+    }
+
+    void LineMemberPool::relocate(int list, int minCapacity) {
+        Slab& slab = slabs[list];
+        int capacity = std::max(minCapacity, std::max(4, 2 * slab.capacity));
+
+        // the list already ends the array: grow in place
+        if (slab.offset + slab.capacity == static_cast<int>(data.size())) {
+            data.resize(slab.offset + capacity);
+            slab.capacity = capacity;
+            return;
+        }
+
+        int offset = static_cast<int>(data.size());
+        data.resize(offset + capacity);
+        std::copy(data.begin() + slab.offset, data.begin() + slab.offset + slab.size, data.begin() + offset);
+        deadNum += slab.capacity;
+        slab.offset = offset;
+        slab.capacity = capacity;
+
+        if (deadNum >= COMPACT_MIN_DEAD && 2 * deadNum >= static_cast<int>(data.size())) {
+            compact();
+        }
+    }
+
+    void LineMemberPool::compact( void ) {
+        std::vector<int> packed;
+        packed.reserve(data.size() - deadNum);
+        for (Slab& slab : slabs) {
+            int offset = static_cast<int>(packed.size());
+            packed.insert(packed.end(), data.begin() + slab.offset, data.begin() + slab.offset + slab.capacity);
+            slab.offset = offset;
+        }
+        data.swap(packed);
+        deadNum = 0;
+    }
+
+    void LineMemberPool::append(int list, int id) {
+        if (slabs[list].size == slabs[list].capacity) {
+            relocate(list, slabs[list].size + 1);
+        }
+        Slab& slab = slabs[list];
+        slots[slotKey(list, id)] = slab.size;
+        data[slab.offset + slab.size++] = id;
+    }
+
+    void LineMemberPool::append(int list, Span<int> ids) {
+        for (std::size_t k = 0; k < ids.size(); ++k) {
+            slots[slotKey(list, ids[k])] = slabs[list].size + static_cast<int>(k);
+        }
+        int needed = slabs[list].size + static_cast<int>(ids.size());
+        if (needed > slabs[list].capacity) {
+            // ids may point into this pool
+            std::vector<int> copy = ids.toVector();
+            relocate(list, needed);
+            Slab& slab = slabs[list];
+            std::copy(copy.begin(), copy.end(), data.begin() + slab.offset + slab.size);
+            slab.size = needed;
+            return;
+        }
+        Slab& slab = slabs[list];
+        std::copy(ids.begin(), ids.end(), data.begin() + slab.offset + slab.size);
+        slab.size = needed;
+    }
+
+    void LineMemberPool::removeAt(int list, int slot) {
+        Slab& slab = slabs[list];
+        slots.erase(slotKey(list, data[slab.offset + slot]));
+        int last = data[slab.offset + slab.size - 1];
+        if (slot != slab.size - 1) {
+            data[slab.offset + slot] = last;
+            slots[slotKey(list, last)] = slot;
+        }
+        --slab.size;
+    }
+
+    bool LineMemberPool::remove(int list, int id) {
+        int slot = slotOf(list, id);
+        if (slot < 0) {
+            return false;
+        }
+        removeAt(list, slot);
+        return true;
+    }
+
+    void LineMemberPool::clearList(int list) {
+        Slab& slab = slabs[list];
+        for (int slot = 0; slot < slab.size; ++slot) {
+            slots.erase(slotKey(list, data[slab.offset + slot]));
+        }
+        slab.size = 0;
+    }
+
+    void LineMemberPool::clear( void ) {
+        data.clear();
+        slabs.clear();
+        slots.clear();
+        deadNum = 0;
+    }
+
+    int LineMemberPool::slotOf(int list, int id) const {
+        auto it = slots.find(slotKey(list, id));
+        return it == slots.end() ? -1 : it->second;
+    }
+
+    Span<int> LineMemberPool::members(int list) const {
+        const Slab& slab = slabs[list];
+        return Span<int>(data.data() + slab.offset, data.data() + slab.offset + slab.size);
+    }
+
+} // namespace Map
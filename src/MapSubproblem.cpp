@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------------
+// MapSubproblem.cpp - Self-contained reduced copy of a map for the solve stages
+//------------------------------------------------------------------------------
+
+#include "MapSubproblem.h"
+#include "MapFileReader.h"
+#include <iostream>
+
+namespace Map {
+
+    //------------------------------------------------------------------------------
+    // Copy the vertices and connect them by ID; edges reference vertexList entries
+    // (like readMapFile) and the graph gets its own copies (like buildGraph)
+    //------------------------------------------------------------------------------
+    bool MapSubproblem::build(
+        const std::vector<BaseVertexProperty>& vertices,
+        const std::vector<std::pair<unsigned int, unsigned int>>& edgeEnds) {
+
+        vertexList = vertices;
+        edgeList.clear();
+        edgeList.reserve(edgeEnds.size());
+        graph.clear();
+
+        std::map<unsigned int, int> vertexID2Index = createVertexID2Index(vertexList);
+        std::vector<BaseUGraphProperty::vertex_descriptor> descs;
+        descs.reserve(vertexList.size());
+        for (const BaseVertexProperty& vertex : vertexList) {
+            descs.push_back(boost::add_vertex(vertex, graph));
+        }
+
+        for (unsigned int e = 0; e < edgeEnds.size(); ++e) {
+            auto sourceIt = vertexID2Index.find(edgeEnds[e].first);
+            auto targetIt = vertexID2Index.find(edgeEnds[e].second);
+            if (sourceIt == vertexID2Index.end() || targetIt == vertexID2Index.end()) {
+                std::cerr << "error: subproblem edge " << edgeEnds[e].first << " - "
+                          << edgeEnds[e].second << " has an unknown endpoint" << std::endl;
+                return false;
+            }
+
+            BaseVertexProperty& source = vertexList[sourceIt->second];
+            BaseVertexProperty& target = vertexList[targetIt->second];
+            double angle = calculateAngle(source, target);
+            edgeList.emplace_back(source, target, e, angle);
+
+            BaseUGraphProperty::vertex_descriptor sourceDesc = descs[sourceIt->second];
+            BaseUGraphProperty::vertex_descriptor targetDesc = descs[targetIt->second];
+            BaseEdgeProperty graphEdge(graph[sourceDesc], graph[targetDesc], e, angle);
+            boost::add_edge(sourceDesc, targetDesc, graphEdge, graph);
+        }
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    // Rebuild the global ID -> descriptor maps for this graph
+    //------------------------------------------------------------------------------
+    void MapSubproblem::activate( void ) const {
+        buildVertexMapping(graph);
+        buildEdgeMapping(graph);
+    }
+
+    std::map<unsigned int, Coord2> MapSubproblem::coordinates( void ) const {
+        std::map<unsigned int, Coord2> coords;
+        for (const BaseVertexProperty& vertex : vertexList) {
+            coords[vertex.getID()] = vertex.getCoord();
+        }
+        return coords;
+    }
+
+    //------------------------------------------------------------------------------
+    // Recompute edge angles from the current vertex coordinates
+    //------------------------------------------------------------------------------
+    void updateEdgeAngles(std::vector<BaseEdgeProperty>& edgeList, BaseUGraphProperty& graph) {
+        std::pair<BaseUGraphProperty::edge_iterator, BaseUGraphProperty::edge_iterator> ep = boost::edges(graph);
+        for (BaseUGraphProperty::edge_iterator ei = ep.first; ei != ep.second; ++ei) {
+            BaseEdgeProperty& edge = graph[*ei];
+            double newAngle = calculateAngle(graph[boost::source(*ei, graph)], graph[boost::target(*ei, graph)]);
+            edge.setAngle(newAngle);
+            edgeList[edge.ID()].setAngle(newAngle);
+        }
+    }
+
+} // namespace Map
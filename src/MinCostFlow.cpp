@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------------
+// MinCostFlow.cpp - Min-cost flow by successive shortest paths
+//------------------------------------------------------------------------------
+
+#include "MinCostFlow.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace Map {
+
+    int MinCostFlow::addArc(int from, int to, int capacity, double cost) {
+        int id = static_cast<int>(arcs.size());
+        arcs.push_back({to, capacity, cost});
+        arcs.push_back({from, 0, -cost});
+        outArcs[from].push_back(id);
+        outArcs[to].push_back(id + 1);
+        return id;
+    }
+
+    int MinCostFlow::solve(int source, int sink, int maxFlow, double& totalCost) {
+        const double INF = std::numeric_limits<double>::infinity();
+        const int n = nodeNum();
+        std::vector<double> potential(n, 0.0), dist(n);
+        std::vector<int> parentArc(n);
+        typedef std::pair<double, int> Entry;
+
+        int sent = 0;
+        totalCost = 0.0;
+        while (sent < maxFlow) {
+            std::fill(dist.begin(), dist.end(), INF);
+            std::fill(parentArc.begin(), parentArc.end(), -1);
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+            dist[source] = 0.0;
+            queue.emplace(0.0, source);
+            while (!queue.empty()) {
+                auto [d, u] = queue.top();
+                queue.pop();
+                if (d > dist[u]) continue;
+                for (int id : outArcs[u]) {
+                    const Arc& arc = arcs[id];
+                    if (arc.capacity <= 0) continue;
+                    // reduced costs are >= 0 up to rounding
+                    double reduced = std::max(0.0, arc.cost + potential[u] - potential[arc.to]);
+                    if (d + reduced < dist[arc.to]) {
+                        dist[arc.to] = d + reduced;
+                        parentArc[arc.to] = id;
+                        queue.emplace(dist[arc.to], arc.to);
+                    }
+                }
+            }
+            if (dist[sink] == INF) break;
+
+            for (int v = 0; v < n; ++v) {
+                if (dist[v] < INF) potential[v] += dist[v];
+            }
+
+            int push = maxFlow - sent;
+            for (int v = sink; v != source; v = arcs[parentArc[v] ^ 1].to) {
+                push = std::min(push, arcs[parentArc[v]].capacity);
+            }
+            for (int v = sink; v != source; v = arcs[parentArc[v] ^ 1].to) {
+                arcs[parentArc[v]].capacity -= push;
+                arcs[parentArc[v] ^ 1].capacity += push;
+                totalCost += push * arcs[parentArc[v]].cost;
+            }
+            sent += push;
+        }
+        return sent;
+    }
+
+} // namespace Map
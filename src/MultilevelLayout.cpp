@@ -0,0 +1,340 @@
+//------------------------------------------------------------------------------
+// MultilevelLayout.cpp - Coarsen / solve / refine driver for very large maps
+//------------------------------------------------------------------------------
+
+#include "MultilevelLayout.h"
+#include "MapSubproblem.h"
+#include "EdgeOrientation.h"
+#include "VertexAlignment.h"
+#include "VisualizeSVG.h"
+#include "MapFileReader.h"
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <set>
+
+namespace Map {
+
+    // Parameter settings for the multilevel driver
+    const int    MULTILEVEL_COARSEST_SIZE = 2000;       // Stop coarsening at this many vertices
+    const int    MULTILEVEL_MAX_LEVELS = 20;            // Hard limit on the hierarchy depth
+    const double MULTILEVEL_MIN_REDUCTION = 0.95;       // Stop if a level keeps more than this fraction
+    const int    REFINE_WINDOW_VERTICES = 400;          // Target core size of a refinement window
+
+    //------------------------------------------------------------------------------
+    // Incident edge lists of a level
+    //------------------------------------------------------------------------------
+    static std::vector<std::vector<int>> incidentEdges(const CoarseLevel& level) {
+        std::vector<std::vector<int>> incident(level.vertices.size());
+        for (int e = 0; e < static_cast<int>(level.edges.size()); ++e) {
+            incident[level.edges[e].first].push_back(e);
+            incident[level.edges[e].second].push_back(e);
+        }
+        return incident;
+    }
+
+    CoarseLevel coarsenLevel(CoarseLevel& fine) {
+        const int vertexNum = static_cast<int>(fine.vertices.size());
+        std::vector<std::vector<int>> incident = incidentEdges(fine);
+
+        // Low-degree vertices pick first so leaves are not stranded
+        std::vector<int> order(vertexNum);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+            [&incident](int a, int b) { return incident[a].size() < incident[b].size(); });
+
+        std::vector<int> match(vertexNum, -1);
+        for (int u : order) {
+            if (match[u] != -1) continue;
+            int best = -1;
+            double bestLength = std::numeric_limits<double>::max();
+            for (int e : incident[u]) {
+                int w = (fine.edges[e].first == u) ? fine.edges[e].second : fine.edges[e].first;
+                if (w == u || match[w] != -1) continue;
+                Coord2 d = fine.vertices[w].getCoord() - fine.vertices[u].getCoord();
+                double length = d.x() * d.x() + d.y() * d.y();
+                if (length < bestLength) {
+                    bestLength = length;
+                    best = w;
+                }
+            }
+            match[u] = (best >= 0) ? best : u;
+            if (best >= 0) {
+                match[best] = u;
+            }
+        }
+
+        CoarseLevel coarse;
+        fine.parent.assign(vertexNum, -1);
+        for (int u = 0; u < vertexNum; ++u) {
+            if (fine.parent[u] != -1) continue;
+            int w = match[u];
+            int c = static_cast<int>(coarse.vertices.size());
+            fine.parent[u] = c;
+            fine.parent[w] = c;
+
+            const BaseVertexProperty& a = fine.vertices[u];
+            const BaseVertexProperty& b = fine.vertices[w];
+            const BaseVertexProperty& representative = (a.getID() <= b.getID()) ? a : b;
+            BaseVertexProperty merged(representative.getID(),
+                                      0.5 * (a.getCoord().x() + b.getCoord().x()),
+                                      0.5 * (a.getCoord().y() + b.getCoord().y()),
+                                      representative.getName());
+            merged.setWeight((w == u) ? a.getWeight() : a.getWeight() + b.getWeight());
+            coarse.vertices.push_back(merged);
+            coarse.positions.push_back(merged.getCoord());
+        }
+
+        std::set<std::pair<int, int>> seen;
+        for (const auto& edge : fine.edges) {
+            int ca = fine.parent[edge.first];
+            int cb = fine.parent[edge.second];
+            if (ca == cb) continue;
+            std::pair<int, int> key(std::min(ca, cb), std::max(ca, cb));
+            if (seen.insert(key).second) {
+                coarse.edges.push_back(key);
+            }
+        }
+        return coarse;
+    }
+
+    //------------------------------------------------------------------------------
+    // Run both stages on core + one-ring halo. The halo is pinned at its current
+    // positions: final if its window was solved before, prolonged otherwise. Positions
+    // are written back for core vertices only. Every window edge takes its orientation
+    // from this solve, so an edge between two windows keeps the one of the window
+    // solved last, when the other end is already final.
+    //------------------------------------------------------------------------------
+    static int solveWindow(
+        CoarseLevel& level,
+        const std::vector<std::vector<int>>& incident,
+        const std::vector<int>& core,
+        const std::vector<double>* hLines,
+        const std::vector<double>* vLines,
+        std::vector<char>& oriented2H,
+        std::vector<char>& oriented2V,
+        const std::string& stageName) {
+
+        std::map<int, int> level2Sub;
+        std::vector<int> windowVertices;
+        std::vector<char> isCore(level.vertices.size(), 0);
+        for (int v : core) {
+            isCore[v] = 1;
+            level2Sub[v] = static_cast<int>(windowVertices.size());
+            windowVertices.push_back(v);
+        }
+
+        std::vector<int> windowEdges;
+        for (int v : core) {
+            for (int e : incident[v]) {
+                int w = (level.edges[e].first == v) ? level.edges[e].second : level.edges[e].first;
+                if (isCore[w] && w < v) continue;       // core-core edges once
+                if (!level2Sub.count(w)) {
+                    level2Sub[w] = static_cast<int>(windowVertices.size());
+                    windowVertices.push_back(w);
+                }
+                windowEdges.push_back(e);
+            }
+        }
+
+        if (windowEdges.empty()) {
+            return 0;
+        }
+
+        std::vector<BaseVertexProperty> subVertices;
+        std::vector<char> isHalo;
+        subVertices.reserve(windowVertices.size());
+        for (int v : windowVertices) {
+            subVertices.push_back(level.vertices[v]);
+            subVertices.back().setCoord(level.positions[v]);
+            isHalo.push_back(!isCore[v]);
+        }
+        std::vector<std::pair<unsigned int, unsigned int>> edgeEnds;
+        edgeEnds.reserve(windowEdges.size());
+        for (int e : windowEdges) {
+            edgeEnds.emplace_back(level.vertices[level.edges[e].first].getID(),
+                                  level.vertices[level.edges[e].second].getID());
+        }
+
+        MapSubproblem sub;
+        if (!sub.build(subVertices, edgeEnds)) {
+            return -1;
+        }
+        sub.activate();
+        int result = optimizeEdgeOrientation(sub.VertexList(), sub.EdgeList(), sub.Graph(), stageName, &isHalo);
+        if (result == 0) {
+            result = optimizeVertexAlignment(sub.VertexList(), sub.EdgeList(), sub.Graph(), stageName, &isHalo, hLines, vLines);
+        }
+        if (result != 0) {
+            return result;
+        }
+
+        for (size_t k = 0; k < core.size(); ++k) {
+            level.positions[core[k]] = sub.VertexList()[k].getCoord();
+        }
+        for (size_t k = 0; k < windowEdges.size(); ++k) {
+            oriented2H[windowEdges[k]] = sub.EdgeList()[k].Oriented2H();
+            oriented2V[windowEdges[k]] = sub.EdgeList()[k].Oriented2V();
+        }
+        return 0;
+    }
+
+    //------------------------------------------------------------------------------
+    // Bucket the level into square windows of ~REFINE_WINDOW_VERTICES vertices
+    //------------------------------------------------------------------------------
+    static std::vector<std::vector<int>> partitionWindows(const CoarseLevel& level) {
+        const int vertexNum = static_cast<int>(level.positions.size());
+        double minX = std::numeric_limits<double>::max(), minY = minX;
+        double maxX = std::numeric_limits<double>::lowest(), maxY = maxX;
+        for (const Coord2& p : level.positions) {
+            minX = std::min(minX, p.x()); maxX = std::max(maxX, p.x());
+            minY = std::min(minY, p.y()); maxY = std::max(maxY, p.y());
+        }
+
+        double area = (maxX - minX) * (maxY - minY);
+        if (vertexNum <= REFINE_WINDOW_VERTICES || area <= 0.0) {
+            std::vector<int> all(vertexNum);
+            std::iota(all.begin(), all.end(), 0);
+            return std::vector<std::vector<int>>(1, all);
+        }
+
+        double cellSize = std::sqrt(area * REFINE_WINDOW_VERTICES / vertexNum);
+        std::map<std::pair<int, int>, std::vector<int>> buckets;
+        for (int v = 0; v < vertexNum; ++v) {
+            int cx = static_cast<int>((level.positions[v].x() - minX) / cellSize);
+            int cy = static_cast<int>((level.positions[v].y() - minY) / cellSize);
+            buckets[std::make_pair(cx, cy)].push_back(v);
+        }
+
+        std::vector<std::vector<int>> windows;
+        windows.reserve(buckets.size());
+        for (auto& bucket : buckets) {
+            windows.push_back(std::move(bucket.second));
+        }
+        return windows;
+    }
+
+    int optimizeMultilevel(
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph,
+        const std::string& testCaseName) {
+
+        std::cout << "\n=== Multilevel Coarsening ===" << std::endl;
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        // Level 0: the input map, level edge index = edge ID
+        std::vector<CoarseLevel> levels(1);
+        std::map<unsigned int, int> vertexID2Index = createVertexID2Index(vertexList);
+        levels[0].vertices = vertexList;
+        for (const BaseVertexProperty& vertex : vertexList) {
+            levels[0].positions.push_back(vertex.getCoord());
+        }
+        for (const BaseEdgeProperty& edge : edgeList) {
+            levels[0].edges.emplace_back(vertexID2Index[edge.Source().getID()], vertexID2Index[edge.Target().getID()]);
+        }
+
+        while (static_cast<int>(levels.back().vertices.size()) > MULTILEVEL_COARSEST_SIZE &&
+               static_cast<int>(levels.size()) < MULTILEVEL_MAX_LEVELS) {
+            CoarseLevel next = coarsenLevel(levels.back());
+            if (next.vertices.size() > MULTILEVEL_MIN_REDUCTION * levels.back().vertices.size()) {
+                levels.back().parent.clear();
+                break;
+            }
+            levels.push_back(std::move(next));
+        }
+        for (size_t l = 0; l < levels.size(); ++l) {
+            std::cout << "Level " << l << ": " << levels[l].vertices.size() << " vertices, "
+                      << levels[l].edges.size() << " edges" << std::endl;
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        int result = 0;
+        std::vector<char> oriented2H, oriented2V;
+
+        // Coarsest level in one piece, finer levels window by window
+        for (int l = static_cast<int>(levels.size()) - 1; l >= 0 && result == 0; --l) {
+            CoarseLevel& level = levels[l];
+            if (l + 1 < static_cast<int>(levels.size())) {
+                const CoarseLevel& coarse = levels[l + 1];
+                for (size_t v = 0; v < level.vertices.size(); ++v) {
+                    int c = level.parent[v];
+                    level.positions[v] = level.vertices[v].getCoord() + (coarse.positions[c] - coarse.vertices[c].getCoord());
+                }
+            }
+
+            std::vector<std::vector<int>> windows;
+            if (l + 1 == static_cast<int>(levels.size())) {
+                windows.push_back(std::vector<int>(level.vertices.size()));
+                std::iota(windows[0].begin(), windows[0].end(), 0);
+            }
+            else {
+                windows = partitionWindows(level);
+            }
+
+            // Lines of the whole level, so that windows meeting at a border share them
+            std::vector<double> hLines, vLines;
+            if (windows.size() > 1) {
+                std::vector<double> xCoords, yCoords;
+                for (const Coord2& p : level.positions) {
+                    xCoords.push_back(p.x());
+                    yCoords.push_back(p.y());
+                }
+                int k = 0;
+                hLines = clusterCoordinates1D(yCoords, k);
+                vLines = clusterCoordinates1D(xCoords, k);
+            }
+
+            std::cout << "\n=== Multilevel: solving level " << l << " in " << windows.size() << " window(s) ===" << std::endl;
+            std::vector<std::vector<int>> incident = incidentEdges(level);
+            oriented2H.assign(level.edges.size(), 0);
+            oriented2V.assign(level.edges.size(), 0);
+            for (const std::vector<int>& core : windows) {
+                result = solveWindow(level, incident, core, windows.size() > 1 ? &hLines : nullptr,
+                                     windows.size() > 1 ? &vLines : nullptr, oriented2H, oriented2V, testCaseName + "_multilevel");
+                if (result != 0) break;
+            }
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        // Point the global maps back at the full graph
+        buildVertexMapping(graph);
+        buildEdgeMapping(graph);
+        if (result != 0) {
+            std::cerr << "Multilevel solve failed with error code " << result << std::endl;
+            return result;
+        }
+
+        for (size_t v = 0; v < vertexList.size(); ++v) {
+            vertexList[v].setCoord(levels[0].positions[v]);
+        }
+        std::pair<BaseUGraphProperty::vertex_iterator, BaseUGraphProperty::vertex_iterator> vp = boost::vertices(graph);
+        for (BaseUGraphProperty::vertex_iterator vi = vp.first; vi != vp.second; ++vi) {
+            graph[*vi].setCoord(levels[0].positions[vertexID2Index[graph[*vi].getID()]]);
+        }
+        for (size_t e = 0; e < edgeList.size(); ++e) {
+            edgeList[e].setOriented2H(oriented2H[e] != 0);
+            edgeList[e].setOriented2V(oriented2V[e] != 0);
+        }
+        std::pair<BaseUGraphProperty::edge_iterator, BaseUGraphProperty::edge_iterator> ep = boost::edges(graph);
+        for (BaseUGraphProperty::edge_iterator ei = ep.first; ei != ep.second; ++ei) {
+            BaseEdgeProperty& edge = graph[*ei];
+            edge.setOriented2H(edgeList[edge.ID()].Oriented2H());
+            edge.setOriented2V(edgeList[edge.ID()].Oriented2V());
+        }
+        updateEdgeAngles(edgeList, graph);
+
+        std::cout << "Multilevel: coarsening "
+                  << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms, solve + refine "
+                  << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms" << std::endl;
+
+        std::string outputFile = "output/" + testCaseName + "_3.svg";
+        createVisualization(vertexList, edgeList, outputFile);
+        return 0;
+    }
+
+} // namespace Map
@@ -1,6 +1,7 @@
 #include "SpatialGrid.h"
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <boost/graph/graph_traits.hpp>
 
 namespace Map {
@@ -61,85 +62,62 @@ void SpatialGrid::insertEdge(int edgeID, const Coord2& start, const Coord2& end)
     }
 }
 
-std::vector<SpatialGrid::GridKey> SpatialGrid::getGridCellsAlongLine(
-    const Coord2& start, const Coord2& end) const {
-    
-    std::vector<GridKey> cells;
-    
-    GridKey startCell = worldToGrid(start);
-    GridKey endCell = worldToGrid(end);
-    
-    int x0 = startCell.first;
-    int y0 = startCell.second;
-    int x1 = endCell.first;
-    int y1 = endCell.second;
-    
-    // 使用DDA算法（Digital Differential Analyzer）遍历线段经过的网格
-    int dx = std::abs(x1 - x0);
-    int dy = std::abs(y1 - y0);
-    int steps = std::max(dx, dy) + 1;
-    
-    // 为了保证覆盖，额外检查线段实际经过的单元
-    // 使用参数方程遍历
-    for (int i = 0; i <= steps; ++i) {
-        double t = (steps > 0) ? static_cast<double>(i) / steps : 0.0;
-        double x = start.x() + t * (end.x() - start.x());
-        double y = start.y() + t * (end.y() - start.y());
-        
-        GridKey cell = worldToGrid(x, y);
-        
-        // 避免重复添加
-        if (cells.empty() || cells.back() != cell) {
-            cells.push_back(cell);
+void SpatialGrid::removeVertex(int vertexID, const Coord2& pos) {
+    auto it = m_grid.find(worldToGrid(pos));
+    if (it == m_grid.end()) {
+        return;
+    }
+    it->second.vertexIDs.erase(vertexID);
+    if (it->second.vertexIDs.empty() && it->second.edgeIDs.empty()) {
+        m_grid.erase(it);
+    }
+}
+
+void SpatialGrid::removeEdge(int edgeID, const Coord2& start, const Coord2& end) {
+    for (const auto& cell : getGridCellsAlongLine(start, end)) {
+        auto it = m_grid.find(cell);
+        if (it == m_grid.end()) {
+            continue;
+        }
+        it->second.edgeIDs.erase(edgeID);
+        if (it->second.vertexIDs.empty() && it->second.edgeIDs.empty()) {
+            m_grid.erase(it);
         }
     }
+}
+
+void SpatialGrid::moveVertex(int vertexID, const Coord2& oldPos, const Coord2& newPos) {
+    removeVertex(vertexID, oldPos);
+    insertVertex(vertexID, newPos);
+}
+
+void SpatialGrid::moveEdge(int edgeID, const Coord2& oldStart, const Coord2& oldEnd,
+                           const Coord2& newStart, const Coord2& newEnd) {
+    removeEdge(edgeID, oldStart, oldEnd);
+    insertEdge(edgeID, newStart, newEnd);
+}
+
+std::vector<SpatialGrid::GridKey> SpatialGrid::getGridCellsAlongLine(
+    const Coord2& start, const Coord2& end) const {
     
-    // 额外检查线段端点的邻近单元（为了处理边界情况）
-    // 这确保了线段与网格边界相交的情况也能被正确处理
-    std::unordered_set<GridKey, GridKeyHash> cellSet(cells.begin(), cells.end());
-    
-    // 检查起点和终点周围的单元
-    for (int dx = -1; dx <= 1; ++dx) {
-        for (int dy = -1; dy <= 1; ++dy) {
-            GridKey startNeighbor = {startCell.first + dx, startCell.second + dy};
-            GridKey endNeighbor = {endCell.first + dx, endCell.second + dy};
-            
-            // 简单的边界框检查：只添加可能与线段相交的邻近单元
-            double startX = start.x();
-            double startY = start.y();
-            double endX = end.x();
-            double endY = end.y();
-            
-            double minX = std::min(startX, endX) - m_cellSize;
-            double maxX = std::max(startX, endX) + m_cellSize;
-            double minY = std::min(startY, endY) - m_cellSize;
-            double maxY = std::max(startY, endY) + m_cellSize;
-            
-            // 检查邻近单元是否在边界框内
-            double neighborMinX = startNeighbor.first * m_cellSize;
-            double neighborMaxX = (startNeighbor.first + 1) * m_cellSize;
-            double neighborMinY = startNeighbor.second * m_cellSize;
-            double neighborMaxY = (startNeighbor.second + 1) * m_cellSize;
-            
-            if (neighborMaxX >= minX && neighborMinX <= maxX &&
-                neighborMaxY >= minY && neighborMinY <= maxY) {
-                cellSet.insert(startNeighbor);
-            }
-            
-            neighborMinX = endNeighbor.first * m_cellSize;
-            neighborMaxX = (endNeighbor.first + 1) * m_cellSize;
-            neighborMinY = endNeighbor.second * m_cellSize;
-            neighborMaxY = (endNeighbor.second + 1) * m_cellSize;
-            
-            if (neighborMaxX >= minX && neighborMinX <= maxX &&
-                neighborMaxY >= minY && neighborMinY <= maxY) {
-                cellSet.insert(endNeighbor);
+    // 逐格遍历线段真正经过的所有单元（Amanatides-Woo），不会漏掉斜线切过的角落单元
+    std::vector<GridKey> path;
+    forEachPathCell(start, end, [&path](const GridKey& cell) {
+        path.push_back(cell);
+        return false;
+    });
+    
+    // 加入8邻域，使落在单元边界附近（重叠判断的容差内）的元素也能被查询到
+    std::unordered_set<GridKey, GridKeyHash> cellSet;
+    for (const auto& c : path) {
+        for (int ox = -1; ox <= 1; ++ox) {
+            for (int oy = -1; oy <= 1; ++oy) {
+                cellSet.insert({c.first + ox, c.second + oy});
             }
         }
     }
     
-    cells.assign(cellSet.begin(), cellSet.end());
-    return cells;
+    return std::vector<GridKey>(cellSet.begin(), cellSet.end());
 }
 
 std::vector<SpatialGrid::GridKey> SpatialGrid::getNeighboringCells(
@@ -9,6 +9,19 @@
 #include "DVPositioning.h"
 #include "AuxLineSpacing.h"
 #include "VisualizeSVG.h"
+#include "ChainContraction.h"
+#include "MultilevelLayout.h"
+#include "TiledLayout.h"
+
+// Pipeline mode for the EdgeOrientation + VertexAlignment stages
+enum PipelineMode {
+    FULL_PIPELINE = 0,          // Solve the whole map
+    CHAIN_CONTRACTION = 1,      // Contract degree-2 chains, solve the reduced map, re-expand
+    MULTILEVEL = 2,             // Coarsen, solve the coarsest map, refine windows level by level
+    TILED = 3                   // Full pipeline per overlapping tile in parallel, then stitch the seams
+};
+const PipelineMode PIPELINE_MODE = FULL_PIPELINE;
+const double TILE_SIZE = 2000.0;        // Tile core edge length for TILED mode
 
 int main() {
     std::cout << "=== Metro Map Optimization Test ===" << std::endl;
@@ -50,29 +63,68 @@ int main() {
     Map::createVisualization(vertexList, edgeList, initialFile);
     std::cout << "Created initial visualization: " << initialFile << std::endl;
     
-    std::cout << "\n=== Starting Edge Orientation Optimization ===" << std::endl;
-    int result_2 = Map::optimizeEdgeOrientation(vertexList, edgeList, graph, testCaseName);
-    
-    if (result_2 == 0) {
-        std::cout << "\n=== Edge Orientation Test completed successfully! ===" << std::endl;
-    } else {
-        std::cout << "\n=== Edge Orientation Test failed with error code: " << result_2 << " ===" << std::endl;
-        return result_2;
+    if (PIPELINE_MODE == TILED) {
+        std::cout << "\n=== Starting Tiled Pipeline ===" << std::endl;
+        Map::DynamicGrid grid(2.315, 2);
+        Map::TileConfig tileConfig;
+        tileConfig.tileSize = TILE_SIZE;
+        int result_t = Map::optimizeTiled(vertexList, edgeList, graph, grid, tileConfig, testCaseName);
+
+        if (result_t == 0) {
+            grid.printAuxLineInfo();
+            std::cout << "\n=== Tiled Pipeline completed successfully! ===" << std::endl;
+        } else {
+            std::cout << "\n=== Tiled Pipeline failed with error code: " << result_t << " ===" << std::endl;
+        }
+        return result_t;
     }
 
-    std::cout << "\n=== Starting Vertex Alignment Optimization ===" << std::endl;
-    int result_3 = Map::optimizeVertexAlignment(vertexList, edgeList, graph, testCaseName);
+    if (PIPELINE_MODE == CHAIN_CONTRACTION) {
+        std::cout << "\n=== Starting Chain-Contracted Orientation and Alignment ===" << std::endl;
+        int result_23 = Map::optimizeWithChainContraction(vertexList, edgeList, graph, testCaseName);
+
+        if (result_23 == 0) {
+            std::cout << "\n=== Chain-Contracted Optimization completed successfully! ===" << std::endl;
+        } else {
+            std::cout << "\n=== Chain-Contracted Optimization failed with error code: " << result_23 << " ===" << std::endl;
+            return result_23;
+        }
+    } else if (PIPELINE_MODE == MULTILEVEL) {
+        std::cout << "\n=== Starting Multilevel Orientation and Alignment ===" << std::endl;
+        int result_23 = Map::optimizeMultilevel(vertexList, edgeList, graph, testCaseName);
 
-    if (result_3 == 0) {
-        std::cout << "\n=== Vertex Alignment Test completed successfully! ===" << std::endl;
+        if (result_23 == 0) {
+            std::cout << "\n=== Multilevel Optimization completed successfully! ===" << std::endl;
+        } else {
+            std::cout << "\n=== Multilevel Optimization failed with error code: " << result_23 << " ===" << std::endl;
+            return result_23;
+        }
     } else {
-        std::cout << "\n=== Vertex Alignment Test failed with error code: " << result_3 << " ===" << std::endl;
-        return result_3;
-    }
+        std::cout << "\n=== Starting Edge Orientation Optimization ===" << std::endl;
+        int result_2 = Map::optimizeEdgeOrientation(vertexList, edgeList, graph, testCaseName);
     
+        if (result_2 == 0) {
+            std::cout << "\n=== Edge Orientation Test completed successfully! ===" << std::endl;
+        } else {
+            std::cout << "\n=== Edge Orientation Test failed with error code: " << result_2 << " ===" << std::endl;
+            return result_2;
+        }
+
+        std::cout << "\n=== Starting Vertex Alignment Optimization ===" << std::endl;
+        int result_3 = Map::optimizeVertexAlignment(vertexList, edgeList, graph, testCaseName);
+
+        if (result_3 == 0) {
+            std::cout << "\n=== Vertex Alignment Test completed successfully! ===" << std::endl;
+        } else {
+            std::cout << "\n=== Vertex Alignment Test failed with error code: " << result_3 << " ===" << std::endl;
+            return result_3;
+        }
+    }
+
     std::cout << "\n=== Building Dynamic Grid ===" << std::endl;
     Map::DynamicGrid grid(2.315, 2);
     grid.buildAuxLines(graph);
+    grid.electKeyAuxLines();
     grid.printAuxLineInfo();
 
     std::cout << "\n=== Starting Dangling Vertex Positioning ===" << std::endl;
@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------------
+// ThreadPool.cpp - Shared worker pool implementation
+//------------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <algorithm>
+
+namespace Map {
+
+    ThreadPool::ThreadPool(int numWorkers): stopping(false) {
+        if (numWorkers < 0) {
+            unsigned int hardware = std::thread::hardware_concurrency();
+            numWorkers = (hardware > 1) ? static_cast<int>(hardware) - 1 : 0;
+        }
+        for (int i = 0; i < numWorkers; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueCV.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool& ThreadPool::shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void ThreadPool::workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCV.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    bool ThreadPool::runPendingTask() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (tasks.empty()) {
+                return false;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+        return true;
+    }
+
+    void ThreadPool::run(std::vector<std::function<void()>>& jobs) {
+        if (jobs.empty()) {
+            return;
+        }
+        if (workers.empty() || jobs.size() == 1) {
+            for (auto& job : jobs) {
+                job();
+            }
+            return;
+        }
+
+        // Completion state shared with the queued wrappers
+        struct Group {
+            std::atomic<int>        remaining;
+            std::mutex              doneMutex;
+            std::condition_variable doneCV;
+            std::exception_ptr      error;
+        };
+        auto group = std::make_shared<Group>();
+        group->remaining = static_cast<int>(jobs.size());
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (auto& job : jobs) {
+                tasks.emplace_back([group, &job] {
+                    try {
+                        job();
+                    } catch (...) {
+                        std::lock_guard<std::mutex> doneLock(group->doneMutex);
+                        if (!group->error) {
+                            group->error = std::current_exception();
+                        }
+                    }
+                    if (--group->remaining == 0) {
+                        std::lock_guard<std::mutex> doneLock(group->doneMutex);
+                        group->doneCV.notify_all();
+                    }
+                });
+            }
+        }
+        queueCV.notify_all();
+
+        // Help with queued work (ours or a nested group's) until our group is done
+        while (group->remaining > 0) {
+            if (!runPendingTask()) {
+                std::unique_lock<std::mutex> doneLock(group->doneMutex);
+                group->doneCV.wait_for(doneLock, std::chrono::milliseconds(1),
+                                       [&group] { return group->remaining == 0; });
+            }
+        }
+
+        if (group->error) {
+            std::rethrow_exception(group->error);
+        }
+    }
+
+    void ThreadPool::parallelFor(int begin, int end, const std::function<void(int)>& body, int minChunk) {
+        int count = end - begin;
+        if (count <= 0) {
+            return;
+        }
+
+        int chunkNum = std::min(static_cast<int>(concurrency()), std::max(1, count / std::max(1, minChunk)));
+        if (chunkNum <= 1) {
+            for (int i = begin; i < end; ++i) {
+                body(i);
+            }
+            return;
+        }
+
+        std::vector<std::function<void()>> jobs;
+        jobs.reserve(chunkNum);
+        for (int c = 0; c < chunkNum; ++c) {
+            int chunkBegin = begin + static_cast<int>(static_cast<long long>(count) * c / chunkNum);
+            int chunkEnd = begin + static_cast<int>(static_cast<long long>(count) * (c + 1) / chunkNum);
+            jobs.emplace_back([&body, chunkBegin, chunkEnd] {
+                for (int i = chunkBegin; i < chunkEnd; ++i) {
+                    body(i);
+                }
+            });
+        }
+        run(jobs);
+    }
+
+} // namespace Map
@@ -0,0 +1,409 @@
+//------------------------------------------------------------------------------
+// TiledLayout.cpp - Overlapping spatial tiles solved in parallel, then stitched
+//------------------------------------------------------------------------------
+
+#include "TiledLayout.h"
+#include "MapSubproblem.h"
+#include "EdgeOrientation.h"
+#include "VertexAlignment.h"
+#include "DVPositioning.h"
+#include "AuxLineSpacing.h"
+#include "CheckOverlap.h"
+#include "VisualizeSVG.h"
+#include "MapFileReader.h"
+#include "ThreadPool.h"
+#include "Commons.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <chrono>
+#include <cmath>
+
+namespace Map {
+
+    struct Tile {
+        std::vector<int>        vertexIndices;      // into vertexList, core and overlap
+        std::vector<int>        edgeIndices;        // into edgeList, both ends in the tile
+        MapSubproblem           sub;
+        DynamicGrid             grid;
+        TileReport              report;
+
+        Tile(double tolerance, double minVotes): grid(tolerance, minVotes) {}
+    };
+
+    //------------------------------------------------------------------------------
+    // Full pipeline on one tile, resolving IDs through the tile's own mapping
+    //------------------------------------------------------------------------------
+    static int solveTile(Tile& tile, const std::string& stageName) {
+        DescriptorMapping mapping = buildDescriptorMapping(tile.sub.Graph());
+        ScopedDescriptorMapping scope(mapping);
+
+        std::vector<BaseVertexProperty>& vertices = tile.sub.VertexList();
+        std::vector<BaseEdgeProperty>& edges = tile.sub.EdgeList();
+        BaseUGraphProperty& graph = tile.sub.Graph();
+
+        int result = optimizeEdgeOrientation(vertices, edges, graph, stageName);
+        if (result != 0) return result;
+        result = optimizeVertexAlignment(vertices, edges, graph, stageName);
+        if (result != 0) return result;
+
+        tile.grid.buildAuxLines(graph);
+        tile.grid.electKeyAuxLines();
+        if (positionDanglingVertices(vertices, edges, graph, tile.grid, stageName) < 0) {
+            return -1;
+        }
+        tile.grid.rebuildVertexLineMappings(graph);
+        return 0;
+    }
+
+    int optimizeTiled(
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph,
+        DynamicGrid& grid,
+        const TileConfig& config,
+        const std::string& testCaseName) {
+
+        const int vertexNum = static_cast<int>(vertexList.size());
+        const int edgeNum = static_cast<int>(edgeList.size());
+        if (vertexNum == 0) {
+            return 0;
+        }
+        std::map<unsigned int, int> vertexID2Index = createVertexID2Index(vertexList);
+
+        // ---------------------------------------------------------------------------------------------------------
+        // Partition
+        // ---------------------------------------------------------------------------------------------------------
+        double minX = std::numeric_limits<double>::max(), minY = minX;
+        double maxX = std::numeric_limits<double>::lowest(), maxY = maxX;
+        for (const BaseVertexProperty& vertex : vertexList) {
+            minX = std::min(minX, vertex.getCoord().x()); maxX = std::max(maxX, vertex.getCoord().x());
+            minY = std::min(minY, vertex.getCoord().y()); maxY = std::max(maxY, vertex.getCoord().y());
+        }
+        const double tileSize = std::max(config.tileSize, 1e-6);
+        const int tilesX = static_cast<int>((maxX - minX) / tileSize) + 1;
+        const int tilesY = static_cast<int>((maxY - minY) / tileSize) + 1;
+        auto cell = [tileSize, tilesX, tilesY](double offset, bool alongX) {
+            int c = static_cast<int>(std::floor(offset / tileSize));
+            return std::max(0, std::min(c, (alongX ? tilesX : tilesY) - 1));
+        };
+
+        std::vector<std::unique_ptr<Tile>> tiles;
+        for (int t = 0; t < tilesX * tilesY; ++t) {
+            tiles.push_back(std::make_unique<Tile>(config.gridTolerance, config.gridMinVotes));
+        }
+
+        std::vector<int> coreTile(vertexNum);
+        std::vector<std::vector<int>> vertexTiles(vertexNum);
+        for (int v = 0; v < vertexNum; ++v) {
+            double ox = vertexList[v].getCoord().x() - minX;
+            double oy = vertexList[v].getCoord().y() - minY;
+            coreTile[v] = cell(oy, false) * tilesX + cell(ox, true);
+            for (int ty = cell(oy - config.overlap, false); ty <= cell(oy + config.overlap, false); ++ty) {
+                for (int tx = cell(ox - config.overlap, true); tx <= cell(ox + config.overlap, true); ++tx) {
+                    int t = ty * tilesX + tx;
+                    vertexTiles[v].push_back(t);
+                    tiles[t]->vertexIndices.push_back(v);
+                }
+            }
+        }
+
+        // an edge longer than the overlap may have its ends in no common tile; no tile solves
+        // it, the seam pass does
+        std::vector<int> edgeEnds(2 * edgeNum);
+        std::vector<char> untiled(edgeNum, 1);
+        for (int e = 0; e < edgeNum; ++e) {
+            int s = vertexID2Index[edgeList[e].Source().getID()];
+            int d = vertexID2Index[edgeList[e].Target().getID()];
+            edgeEnds[2 * e] = s;
+            edgeEnds[2 * e + 1] = d;
+            for (int t : vertexTiles[s]) {
+                if (std::find(vertexTiles[d].begin(), vertexTiles[d].end(), t) != vertexTiles[d].end()) {
+                    tiles[t]->edgeIndices.push_back(e);
+                    untiled[e] = 0;
+                }
+            }
+        }
+
+        // ---------------------------------------------------------------------------------------------------------
+        // Parallel tile solves
+        // ---------------------------------------------------------------------------------------------------------
+        std::vector<std::function<void()>> jobs;
+        for (int t = 0; t < static_cast<int>(tiles.size()); ++t) {
+            Tile& tile = *tiles[t];
+            tile.report = TileReport{t, 0, static_cast<int>(tile.vertexIndices.size()),
+                                     static_cast<int>(tile.edgeIndices.size()), 0.0, 0};
+            for (int v : tile.vertexIndices) {
+                tile.report.coreVertexNum += (coreTile[v] == t);
+            }
+            if (tile.edgeIndices.empty()) {
+                continue;
+            }
+
+            std::vector<BaseVertexProperty> vertices;
+            for (int v : tile.vertexIndices) {
+                vertices.push_back(vertexList[v]);
+            }
+            std::vector<std::pair<unsigned int, unsigned int>> ends;
+            for (int e : tile.edgeIndices) {
+                ends.emplace_back(edgeList[e].Source().getID(), edgeList[e].Target().getID());
+            }
+            if (!tile.sub.build(vertices, ends)) {
+                return -1;
+            }
+
+            std::string stageName = testCaseName + "_tile" + std::to_string(t);
+            jobs.emplace_back([&tile, stageName] {
+                auto start = std::chrono::high_resolution_clock::now();
+                tile.report.result = solveTile(tile, stageName);
+                tile.report.solveMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::high_resolution_clock::now() - start).count();
+            });
+        }
+
+        std::cout << "\n=== Tiled: solving " << jobs.size() << " of " << tiles.size() << " tiles ("
+                  << tilesX << " x " << tilesY << ", tile size " << tileSize << ", overlap " << config.overlap
+                  << ") on " << ThreadPool::shared().concurrency() << " threads ===" << std::endl;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        ThreadPool::shared().run(jobs);
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        for (const auto& tile : tiles) {
+            if (tile->report.result != 0) {
+                std::cerr << "Tile " << tile->report.tileIndex << " failed with error code " << tile->report.result << std::endl;
+                return tile->report.result;
+            }
+        }
+
+        // Every vertex from its core tile, every edge's orientation from its source's core tile
+        std::vector<Coord2> positions(vertexNum);
+        for (int v = 0; v < vertexNum; ++v) {
+            positions[v] = vertexList[v].getCoord();
+        }
+        std::vector<char> oriented2H(edgeNum), oriented2V(edgeNum);
+        for (int e = 0; e < edgeNum; ++e) {
+            oriented2H[e] = edgeList[e].Oriented2H();
+            oriented2V[e] = edgeList[e].Oriented2V();
+        }
+        for (int t = 0; t < static_cast<int>(tiles.size()); ++t) {
+            const Tile& tile = *tiles[t];
+            if (tile.edgeIndices.empty()) continue;
+            for (size_t k = 0; k < tile.vertexIndices.size(); ++k) {
+                if (coreTile[tile.vertexIndices[k]] == t) {
+                    positions[tile.vertexIndices[k]] = tile.sub.VertexList()[k].getCoord();
+                }
+            }
+            for (size_t k = 0; k < tile.edgeIndices.size(); ++k) {
+                int e = tile.edgeIndices[k];
+                if (coreTile[edgeEnds[2 * e]] == t) {
+                    oriented2H[e] = tile.sub.EdgeList()[k].Oriented2H();
+                    oriented2V[e] = tile.sub.EdgeList()[k].Oriented2V();
+                }
+            }
+        }
+
+        // ---------------------------------------------------------------------------------------------------------
+        // Merge the tile grids and snap vertices onto the merged lines where that overlaps nothing
+        // ---------------------------------------------------------------------------------------------------------
+        grid.clearAllAuxLines();
+        for (const auto& tile : tiles) {
+            if (!tile->edgeIndices.empty()) {
+                grid.mergeAuxLines(tile->grid);
+            }
+        }
+        std::vector<double> hPositions = grid.getHALPositions();
+        std::vector<double> vPositions = grid.getVALPositions();
+        auto snap = [&config](double value, const std::vector<double>& lines) {
+            auto it = std::lower_bound(lines.begin(), lines.end(), value);
+            double best = value;
+            double bestDistance = config.gridTolerance;
+            if (it != lines.end() && std::abs(*it - value) <= bestDistance) {
+                best = *it;
+                bestDistance = std::abs(*it - value);
+            }
+            if (it != lines.begin() && std::abs(*std::prev(it) - value) < bestDistance) {
+                best = *std::prev(it);
+            }
+            return best;
+        };
+
+        OverlapGeometry geometry;
+        geometry.build(graph);
+        std::vector<int> geometryIndex(vertexNum);
+        for (int v = 0; v < vertexNum; ++v) {
+            geometryIndex[v] = geometry.indexOf(vertexList[v].getID());
+            geometry.setCoord(geometryIndex[v], positions[v].x(), positions[v].y());
+        }
+        int snappedNum = 0, blockedNum = 0;
+        for (int v = 0; v < vertexNum; ++v) {
+            double x = snap(positions[v].x(), vPositions);
+            double y = snap(positions[v].y(), hPositions);
+            if (x == positions[v].x() && y == positions[v].y()) continue;
+            // both axes, else either one alone
+            Coord2 candidates[3] = {Coord2(x, y), Coord2(x, positions[v].y()), Coord2(positions[v].x(), y)};
+            boost::dynamic_bitset<> overlaps = overlapBatch(geometry, vertexList[v].getID(),
+                                                            Span<Coord2>(candidates, candidates + 3));
+            int c = 0;
+            while (c < 3 && overlaps[c]) ++c;
+            if (c == 3) {
+                ++blockedNum;
+                continue;
+            }
+            positions[v] = candidates[c];
+            geometry.setCoord(geometryIndex[v], positions[v].x(), positions[v].y());
+            ++snappedNum;
+        }
+
+        // ---------------------------------------------------------------------------------------------------------
+        // Seam pass: vertices near an inner tile border re-solved on the merged lines, with
+        // their neighbors pinned as context; untiled edges join with their ends pinned
+        // ---------------------------------------------------------------------------------------------------------
+        auto nearInnerBorder = [&](double offset, int tiles1D) {
+            for (int b = 1; b < tiles1D; ++b) {
+                if (std::abs(offset - b * tileSize) < config.overlap) return true;
+            }
+            return false;
+        };
+        std::vector<char> inSeam(vertexNum, 0);
+        for (int v = 0; v < vertexNum; ++v) {
+            inSeam[v] = nearInnerBorder(vertexList[v].getCoord().x() - minX, tilesX) ||
+                        nearInnerBorder(vertexList[v].getCoord().y() - minY, tilesY);
+        }
+
+        std::vector<int> seamVertices, seamEdges;
+        std::vector<int> seamLocal(vertexNum, -1);
+        for (int v = 0; v < vertexNum; ++v) {
+            if (inSeam[v]) {
+                seamLocal[v] = static_cast<int>(seamVertices.size());
+                seamVertices.push_back(v);
+            }
+        }
+        const int seamCoreNum = static_cast<int>(seamVertices.size());
+        for (int e = 0; e < edgeNum; ++e) {
+            int s = edgeEnds[2 * e], d = edgeEnds[2 * e + 1];
+            if (!inSeam[s] && !inSeam[d] && !untiled[e]) continue;
+            for (int v : {s, d}) {
+                if (seamLocal[v] < 0) {
+                    seamLocal[v] = static_cast<int>(seamVertices.size());
+                    seamVertices.push_back(v);
+                }
+            }
+        }
+        // every edge among them, so that the pinned context blocks the seam vertices in
+        // both solves; edges between two context vertices keep their tile orientation unless untiled
+        for (int e = 0; e < edgeNum; ++e) {
+            if (seamLocal[edgeEnds[2 * e]] >= 0 && seamLocal[edgeEnds[2 * e + 1]] >= 0) {
+                seamEdges.push_back(e);
+            }
+        }
+
+        auto t2 = std::chrono::high_resolution_clock::now();
+        auto t3 = t2;
+        if (!seamEdges.empty()) {
+            std::vector<BaseVertexProperty> vertices;
+            std::vector<char> pinned;
+            for (int v : seamVertices) {
+                vertices.push_back(vertexList[v]);
+                vertices.back().setCoord(positions[v]);
+                pinned.push_back(!inSeam[v]);
+            }
+            std::vector<std::pair<unsigned int, unsigned int>> ends;
+            for (int e : seamEdges) {
+                ends.emplace_back(edgeList[e].Source().getID(), edgeList[e].Target().getID());
+            }
+
+            MapSubproblem seam;
+            if (!seam.build(vertices, ends)) {
+                return -1;
+            }
+            std::cout << "\n=== Tiled: seam pass over " << seamCoreNum << " vertices, "
+                      << seamVertices.size() - seamCoreNum << " pinned, " << seamEdges.size() << " edges ===" << std::endl;
+
+            DescriptorMapping mapping = buildDescriptorMapping(seam.Graph());
+            ScopedDescriptorMapping scope(mapping);
+            std::string stageName = testCaseName + "_seam";
+            int result = optimizeEdgeOrientation(seam.VertexList(), seam.EdgeList(), seam.Graph(), stageName, &pinned);
+            if (result == 0) {
+                result = optimizeVertexAlignment(seam.VertexList(), seam.EdgeList(), seam.Graph(), stageName,
+                                                 &pinned, &hPositions, &vPositions);
+            }
+            if (result != 0) {
+                return result;
+            }
+
+            for (int k = 0; k < seamCoreNum; ++k) {
+                positions[seamVertices[k]] = seam.VertexList()[k].getCoord();
+            }
+            for (size_t k = 0; k < seamEdges.size(); ++k) {
+                int e = seamEdges[k];
+                if (inSeam[edgeEnds[2 * e]] || inSeam[edgeEnds[2 * e + 1]] || untiled[e]) {
+                    oriented2H[e] = seam.EdgeList()[k].Oriented2H();
+                    oriented2V[e] = seam.EdgeList()[k].Oriented2V();
+                }
+            }
+            t3 = std::chrono::high_resolution_clock::now();
+        }
+
+        // ---------------------------------------------------------------------------------------------------------
+        // Write back
+        // ---------------------------------------------------------------------------------------------------------
+        for (int v = 0; v < vertexNum; ++v) {
+            vertexList[v].setCoord(positions[v]);
+        }
+        std::pair<BaseUGraphProperty::vertex_iterator, BaseUGraphProperty::vertex_iterator> vp = boost::vertices(graph);
+        for (BaseUGraphProperty::vertex_iterator vi = vp.first; vi != vp.second; ++vi) {
+            graph[*vi].setCoord(positions[vertexID2Index[graph[*vi].getID()]]);
+        }
+        for (int e = 0; e < edgeNum; ++e) {
+            edgeList[e].setOriented2H(oriented2H[e] != 0);
+            edgeList[e].setOriented2V(oriented2V[e] != 0);
+        }
+        std::pair<BaseUGraphProperty::edge_iterator, BaseUGraphProperty::edge_iterator> ep = boost::edges(graph);
+        for (BaseUGraphProperty::edge_iterator ei = ep.first; ei != ep.second; ++ei) {
+            BaseEdgeProperty& edge = graph[*ei];
+            edge.setOriented2H(edgeList[edge.ID()].Oriented2H());
+            edge.setOriented2V(edgeList[edge.ID()].Oriented2V());
+        }
+        updateEdgeAngles(edgeList, graph);
+
+        // Spacing once on the merged lines: per tile it would rescale each tile on its own
+        int result = uniformAuxLineSpacing(vertexList, edgeList, graph, grid, config.minSpacing, testCaseName);
+        if (result != 0) {
+            return result;
+        }
+
+        // ---------------------------------------------------------------------------------------------------------
+        // Scaling report
+        // ---------------------------------------------------------------------------------------------------------
+        double wallMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double seamMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+        double sumMs = 0.0, maxMs = 0.0;
+        std::cout << "\n=== Tiled: scaling report ===" << std::endl;
+        std::cout << std::fixed << std::setprecision(1);
+        for (const auto& tile : tiles) {
+            const TileReport& r = tile->report;
+            if (r.edgeNum == 0) continue;
+            sumMs += r.solveMs;
+            maxMs = std::max(maxMs, r.solveMs);
+            std::cout << "  Tile " << r.tileIndex << ": " << r.coreVertexNum << " core / " << r.vertexNum
+                      << " vertices, " << r.edgeNum << " edges, " << r.solveMs << " ms" << std::endl;
+        }
+        unsigned int threads = ThreadPool::shared().concurrency();
+        std::cout << "Tiles: " << wallMs << " ms wall, " << sumMs << " ms summed, slowest tile " << maxMs << " ms" << std::endl;
+        std::cout << "Speedup over sequential tiles: " << std::setprecision(2) << (wallMs > 0 ? sumMs / wallMs : 0.0)
+                  << "x on " << threads << " threads (efficiency "
+                  << (wallMs > 0 ? 100.0 * sumMs / (wallMs * threads) : 0.0) << "%)" << std::endl;
+        std::cout << "Seam pass: " << std::setprecision(1) << seamMs << " ms, merged grid: "
+                  << hPositions.size() << " horizontal / " << vPositions.size() << " vertical lines, "
+                  << snappedNum << " vertices snapped, " << blockedNum << " kept off by an overlap" << std::endl;
+        std::cout << std::defaultfloat;
+
+        std::string outputFile = "output/" + testCaseName + "_tiled.svg";
+        createVisualization(vertexList, edgeList, outputFile);
+        return 0;
+    }
+
+} // namespace Map
@@ -1,6 +1,9 @@
 #include "VertexAlignment.h"
 #include "VisualizeSVG.h"
 #include "CheckOverlap.h"
+#include "Clustering1D.h"
+#include "AxisLineIndex.h"
+#include "ThreadPool.h"
 #define _USE_MATH_DEFINES  // Enable M_PI and other math constants
 #include "BaseUGraphProperty.h"
 #include "gurobi_c++.h"
@@ -10,6 +13,8 @@
 #include <cmath>
 #include <map>
 #include <numeric>
+#include <functional>
+#include <set>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846  // Fallback definition for M_PI
@@ -20,6 +25,7 @@
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/iteration_macros.hpp>
 #include "MapFileReader.h"
+#include "Commons.h"
 
 namespace Map {
 
@@ -34,6 +40,12 @@ namespace Map {
     const double            MIN_CLUSTER_SIZE = 3;                       // Minimum vertices needed to form a cluster
     const double            DEFAULT_VERTEX_WEIGHT = 1.0;                // Default weight for vertices
     const bool              USE_DEGREE_BASED_WEIGHT = false;            // Enable degree-based weighting (future extension)
+    const bool              USE_PARALLEL_LINE_DETECTION = true;         // H/V phases as tasks on ThreadPool::shared()
+    const double            OVERLAP_GRID_CELL_FACTOR = 1.0;             // Phase 2.5 / MILP lazy overlap spatial grid cell size / average edge length
+    const int               OVERLAP_INDEX_MIN_VERTICES = 256;           // Phase 2.5: smaller graphs are checked against every element
+    const bool              USE_CLOSED_FORM_PROJECTION = true;          // Phase 3 as a projection; Gurobi only as fallback
+    const double            MILP_ALIGNMENT_REWARD = 2.0 * ALIGNMENT_TOLERANCE * ALIGNMENT_TOLERANCE;  // MIXED_INTEGER: gain per aligned coordinate
+    const double            MILP_TIME_LIMIT = 120.0;                    // MIXED_INTEGER: seconds; the incumbent is used on timeout
 
     // Helper function to calculate vertex weight (reserved for future extensions)
     double calculateVWeight(const BaseVertexProperty& vertex, const BaseUGraphProperty& graph) {
@@ -46,7 +58,7 @@ namespace Map {
         return DEFAULT_VERTEX_WEIGHT;
     }
 
-    // K-means clustering for 1D coordinates
+    // Optimal 1D k-means clustering (exact dynamic program, see Clustering1D)
     std::vector<double> clusterCoordinates1D(const std::vector<double>& coords, int& optimalK) {
         if (coords.size() < MIN_CLUSTER_SIZE) {
             optimalK = 0;
@@ -66,84 +78,25 @@ namespace Map {
 
         // Auto-determine optimal k using simplified elbow method
         int maxK = std::min(static_cast<int>(sortedCoords.size() / MIN_CLUSTER_SIZE), static_cast<int>(std::sqrt(sortedCoords.size())) + 2);
+
+        // Optimal WCSS for every k in one pass (large rows are split across the pool)
+        Clustering1D clustering(sortedCoords, maxK, USE_PARALLEL_LINE_DETECTION ? &ThreadPool::shared() : nullptr);
         
         double bestScore = std::numeric_limits<double>::max();
         int bestK = 1;
-        std::vector<double> bestCenters;
-
-        for (int k = 1; k <= maxK; ++k) {
-            // Initialize centroids evenly spaced
-            std::vector<double> centroids(k);
-            for (int i = 0; i < k; ++i) {
-                int idx;
-                if (k == 1) {
-                    idx = sortedCoords.size() / 2;
-                } 
-                else {
-                    // !!! thinking !!!
-                    idx = i * (sortedCoords.size() - 1) / (k - 1);
-                }
-                centroids[i] = sortedCoords[idx];
-            }
-
-            // K-means iterations
-            bool converged = false;
-            for (int iter = 0; iter < 50 && !converged; ++iter) {
-                std::vector<std::vector<double>> clusters(k);
-                
-                // !!! Assign points to nearest centroid
-                for (double coord : sortedCoords) {
-                    int nearestCluster = 0;
-                    double minDist = std::abs(coord - centroids[0]);
-                    
-                    // !!! k centroids
-                    for (int i = 1; i < k; ++i) {
-                        double dist = std::abs(coord - centroids[i]);
-                        if (dist < minDist) {
-                            minDist = dist;
-                            nearestCluster = i;
-                        }
-                    }
-                    // the current coord is closet to the nearestCluster
-                    clusters[nearestCluster].push_back(coord);
-                }
-
-                // !!! Update centroids
-                converged = true;
-                for (int i = 0; i < k; ++i) {
-                    if (!clusters[i].empty()) {
-                        double newCentroid = std::accumulate(clusters[i].begin(), clusters[i].end(), 0.0) / clusters[i].size();
-                        if (std::abs(newCentroid - centroids[i]) > 1e-6) {
-                            converged = false;
-                        }
-                        centroids[i] = newCentroid;
-                    }
-                }
-            }
-
-            // Calculate within-cluster sum of squares (WCSS)
-            double wcss = 0.0;
-            for (double coord : sortedCoords) {
-                double minDist = std::numeric_limits<double>::max();
-                for (double centroid : centroids) {
-                    minDist = std::min(minDist, std::abs(coord - centroid));
-                }
-                wcss += minDist * minDist;
-            }
-
+        for (int k = 1; k <= clustering.getMaxK(); ++k) {
             // Simple elbow method: prefer fewer clusters with reasonable WCSS
-            double score = wcss + k * 50.0;  // Penalty for more clusters
+            double score = clustering.getWCSS(k) + k * 50.0;  // Penalty for more clusters
             
+            // strict comparison in k order: ties keep the smallest k
             if (score < bestScore) {
                 bestScore = score;
                 bestK = k;
-                bestCenters = centroids;
             }
         }
 
         optimalK = bestK;
-        std::sort(bestCenters.begin(), bestCenters.end());
-        return bestCenters;
+        return clustering.getCenters(bestK);
     }
 
     // Structure for vertex-line candidate assignments
@@ -155,54 +108,424 @@ namespace Map {
         double linePosition;
     };
 
+    // Closest line within tolerance on one axis for every vertex (-1 if none)
+    static std::vector<int> nearestLinePerVertex(
+        const std::vector<BaseVertexProperty>& vertexList,
+        const std::vector<double>& lines,
+        bool isHorizontal) {
+
+        std::vector<double> coords(vertexList.size());
+        for (int i = 0; i < vertexList.size(); ++i) {
+            coords[i] = isHorizontal ? vertexList[i].getCoord().y() : vertexList[i].getCoord().x();
+        }
+        return AxisLineIndex(lines).nearestWithin(coords, ALIGNMENT_TOLERANCE);
+    }
+
     // Pre-select vertices for alignment based on closest line within tolerance
     std::vector<VertexLineCandidate> preSelect(
         const std::vector<BaseVertexProperty>& vertexList,
         const std::vector<double>& hLines,
         const std::vector<double>& vLines) {
         
+        // The H and V halves are independent
+        std::vector<int> bestHLIdx, bestVLIdx;
+        std::vector<std::function<void()>> halves;
+        halves.emplace_back([&] { bestHLIdx = nearestLinePerVertex(vertexList, hLines, true); });
+        halves.emplace_back([&] { bestVLIdx = nearestLinePerVertex(vertexList, vLines, false); });
+        if (USE_PARALLEL_LINE_DETECTION) {
+            ThreadPool::shared().run(halves);
+        }
+        else {
+            for (auto& half : halves) half();
+        }
+
+        // Allow both horizontal and vertical alignment if within tolerance
         std::vector<VertexLineCandidate> candidates;
-        
         for (int i = 0; i < vertexList.size(); ++i) {
-            double minHDist = std::numeric_limits<double>::max();
-            double minVDist = std::numeric_limits<double>::max();
-            int bestHLIdx = -1, bestVLIdx = -1;
+            if (bestHLIdx[i] != -1) {
+                double dist = std::abs(vertexList[i].getCoord().y() - hLines[bestHLIdx[i]]);
+                candidates.push_back({i, bestHLIdx[i], true, dist, hLines[bestHLIdx[i]]});
+            }
+            if (bestVLIdx[i] != -1) {
+                double dist = std::abs(vertexList[i].getCoord().x() - vLines[bestVLIdx[i]]);
+                candidates.push_back({i, bestVLIdx[i], false, dist, vLines[bestVLIdx[i]]});
+            }
+        }
+        
+        return candidates;
+    }
+
+    // Write the solved coordinates to vertexList and graph, refresh edge angles and draw
+    static void applyAlignedCoordinates(
+        std::vector<BaseVertexProperty>& vertexList,
+        std::vector<BaseEdgeProperty>& edgeList,
+        BaseUGraphProperty& graph,
+        const std::vector<VertexLineCandidate>& alignmentCandidates,
+        const std::vector<double>& newXs,
+        const std::vector<double>& newYs,
+        const std::string& testCaseName) {
+
+        int vertexNum = vertexList.size();
+        std::map<unsigned int, int> vertexID2Index = createVertexID2Index(vertexList);
+
+        // Print results and update coordinates
+        std::cout << "\n=== Aligned coordinates ===" << std::endl;
+        
+        // Group alignment candidates by vertex index for display
+        std::map<int, std::vector<VertexLineCandidate>> vertexToCandidates;
+        for (const auto& candidate : alignmentCandidates) {
+            vertexToCandidates[candidate.vertexIdx].push_back(candidate);
+        }
+        
+        for (int i = 0; i < vertexNum; ++i) {
+            double newX = newXs[i];
+            double newY = newYs[i];
             
-            // Find closest horizontal line within tolerance
-            for (int h = 0; h < hLines.size(); ++h) {
-                double dist = std::abs(vertexList[i].getCoord().y() - hLines[h]);
-                if (dist < minHDist && dist <= ALIGNMENT_TOLERANCE) {
-                    minHDist = dist;
-                    bestHLIdx = h;
+            // Check if this vertex was in the alignment candidates
+            auto it = vertexToCandidates.find(i);
+            if (it != vertexToCandidates.end()) {
+                const auto& candidates = it->second;
+                std::cout << "Vertex " << vertexList[i].getID() << " aligned to ";
+                
+                for (int j = 0; j < candidates.size(); ++j) {
+                    if (j > 0) std::cout << " and ";
+                    const auto& candidate = candidates[j];
+                    std::cout << (candidate.isHorizontal ? "H-line y=" : "V-line x=") 
+                             << candidate.linePosition;
                 }
+                std::cout << " (" << newX << ", " << newY << ")" << std::endl;
             }
             
-            // Find closest vertical line within tolerance
-            for (int v = 0; v < vLines.size(); ++v) {
-                double dist = std::abs(vertexList[i].getCoord().x() - vLines[v]);
-                if (dist < minVDist && dist <= ALIGNMENT_TOLERANCE) {
-                    minVDist = dist;
-                    bestVLIdx = v;
-                }
+            // Update vertices in graph and vertexList
+            vertexList[i].setCoord(newX, newY);
+        }
+
+        std::cout << "Total aligned vertices: " << vertexToCandidates.size() << "/" << vertexNum << std::endl;
+
+        // Update graph vertices (similar to EdgeOrientation)
+        std::pair<BaseUGraphProperty::vertex_iterator, BaseUGraphProperty::vertex_iterator> vp = vertices(graph);
+        for (BaseUGraphProperty::vertex_iterator vi = vp.first; vi != vp.second; ++vi) {
+            BaseVertexProperty& vertex = graph[*vi];
+            auto it = vertexID2Index.find(vertex.getID());
+            if (it != vertexID2Index.end()) {
+                int idx = it->second;
+                vertex.setCoord(newXs[idx], newYs[idx]);
             }
+        }
+
+        // Update edge angles (similar to EdgeOrientation)
+        std::pair<BaseUGraphProperty::edge_iterator, BaseUGraphProperty::edge_iterator> ep = edges(graph);
+        for (BaseUGraphProperty::edge_iterator ei = ep.first; ei != ep.second; ++ei) {
+            BaseEdgeProperty& edge = graph[*ei];
+            
+            BaseUGraphProperty::vertex_descriptor source_desc = boost::source(*ei, graph);
+            BaseUGraphProperty::vertex_descriptor target_desc = boost::target(*ei, graph);
             
-            // Allow both horizontal and vertical alignment if within tolerance
-            if (bestHLIdx != -1) {
-                candidates.push_back({i, bestHLIdx, true, minHDist, hLines[bestHLIdx]});
+            // Recalculate angle with updated coordinates
+            double newAngle = calculateAngle(graph[source_desc], graph[target_desc]);
+            edge.setAngle(newAngle);
+            edgeList[edge.ID()].setAngle(newAngle);
+        }
+
+        std::string outputFile = "output/" + testCaseName + "_3.svg";
+        createVisualization(vertexList, edgeList, outputFile);
+    }
+
+    bool solveAlignmentProjection(
+        const std::vector<BaseVertexProperty>& vertexList,
+        const std::vector<AxisConstraint>& constraints,
+        double x_min, double x_max, double y_min, double y_max,
+        std::vector<double>& X,
+        std::vector<double>& Y) {
+
+        const int vertexNum = vertexList.size();
+        std::vector<double> newX(vertexNum), newY(vertexNum);
+        std::vector<char> fixedX(vertexNum, 0), fixedY(vertexNum, 0);
+
+        // Forced coordinates
+        for (const auto& constraint : constraints) {
+            if (constraint.vertexIdx < 0 || constraint.vertexIdx >= vertexNum) {
+                return false;
+            }
+            double lo = constraint.isHorizontal ? y_min : x_min;
+            double hi = constraint.isHorizontal ? y_max : x_max;
+            if (constraint.value < lo || constraint.value > hi) {
+                return false;
             }
-            if (bestVLIdx != -1) {
-                candidates.push_back({i, bestVLIdx, false, minVDist, vLines[bestVLIdx]});
+            std::vector<double>& value = constraint.isHorizontal ? newY : newX;
+            std::vector<char>& fixed = constraint.isHorizontal ? fixedY : fixedX;
+            if (fixed[constraint.vertexIdx] && value[constraint.vertexIdx] != constraint.value) {
+                return false;
             }
+            value[constraint.vertexIdx] = constraint.value;
+            fixed[constraint.vertexIdx] = 1;
         }
-        
-        return candidates;
+
+        // Free coordinates stay where they are
+        for (int i = 0; i < vertexNum; ++i) {
+            if (!fixedX[i]) newX[i] = std::min(std::max(vertexList[i].getCoord().x(), x_min), x_max);
+            if (!fixedY[i]) newY[i] = std::min(std::max(vertexList[i].getCoord().y(), y_min), y_max);
+        }
+
+        X.swap(newX);
+        Y.swap(newY);
+        return true;
+    }
+
+    // ----------------------------------------------------------------------------------------------------
+    // MIXED_INTEGER: joint vertex-to-line assignment
+    // ----------------------------------------------------------------------------------------------------
+
+    // Alignment options of one vertex on one axis: z[k] == 1 moves the coordinate to position[k]
+    struct AxisOptions {
+        std::vector<GRBVar>     z;
+        std::vector<int>        lineIdx;
+        std::vector<double>     position;
+    };
+
+    // On every incumbent, places the vertices as the binaries say and checks the moved
+    // vertices and their edges for overlaps. Each overlap adds a no-good over the binaries
+    // of the vertices involved, which cuts off exactly their current combination.
+    class AlignmentOverlapCallback : public GRBCallback {
+    private:
+        const std::vector<BaseVertexProperty>&          vertexList;
+        const std::vector<std::pair<int, int>>&         edgeEnds;       // vertexList indices, edge ID = index
+        const std::vector<std::vector<int>>&            incidentEdges;
+        const std::vector<AxisOptions>&                 hOptions;
+        const std::vector<AxisOptions>&                 vOptions;
+        double                                          cellSize;
+
+    public:
+        int                                             lazyNum;
+
+        AlignmentOverlapCallback(const std::vector<BaseVertexProperty>& vertexList,
+                                 const std::vector<std::pair<int, int>>& edgeEnds,
+                                 const std::vector<std::vector<int>>& incidentEdges,
+                                 const std::vector<AxisOptions>& hOptions,
+                                 const std::vector<AxisOptions>& vOptions,
+                                 double cellSize):
+            vertexList(vertexList), edgeEnds(edgeEnds), incidentEdges(incidentEdges),
+            hOptions(hOptions), vOptions(vOptions), cellSize(cellSize), lazyNum(0) {}
+
+    protected:
+        void callback() {
+            if (where != GRB_CB_MIPSOL) {
+                return;
+            }
+            try {
+                const int vertexNum = vertexList.size();
+
+                // Incumbent geometry
+                std::vector<BaseVertexProperty> placed(vertexList);
+                std::vector<std::vector<double>> hValue(vertexNum), vValue(vertexNum);
+                std::vector<int> moved;
+                for (int i = 0; i < vertexNum; ++i) {
+                    Coord2 pos = vertexList[i].getCoord();
+                    bool isMoved = false;
+                    for (int k = 0; k < hOptions[i].z.size(); ++k) {
+                        hValue[i].push_back(getSolution(hOptions[i].z[k]));
+                        if (hValue[i][k] > 0.5) { pos.setY(hOptions[i].position[k]); isMoved = true; }
+                    }
+                    for (int k = 0; k < vOptions[i].z.size(); ++k) {
+                        vValue[i].push_back(getSolution(vOptions[i].z[k]));
+                        if (vValue[i][k] > 0.5) { pos.setX(vOptions[i].position[k]); isMoved = true; }
+                    }
+                    placed[i].setCoord(pos);
+                    if (isMoved) moved.push_back(i);
+                }
+
+                std::vector<BaseEdgeProperty> placedEdges;
+                placedEdges.reserve(edgeEnds.size());
+                SpatialGrid spatialGrid(cellSize);
+                for (int i = 0; i < vertexNum; ++i) {
+                    spatialGrid.insertVertex(i, placed[i].getCoord());
+                }
+                for (int e = 0; e < edgeEnds.size(); ++e) {
+                    placedEdges.emplace_back(placed[edgeEnds[e].first], placed[edgeEnds[e].second], e, 0.0);
+                    spatialGrid.insertEdge(e, placed[edgeEnds[e].first].getCoord(), placed[edgeEnds[e].second].getCoord());
+                }
+
+                // Overlapping configurations, as the sorted vertex indices involved
+                std::set<std::vector<int>> conflicts;
+                auto isEndpoint = [&](int vertexIdx, int e) {
+                    return edgeEnds[e].first == vertexIdx || edgeEnds[e].second == vertexIdx;
+                };
+                auto addConflict = [&](std::vector<int> involved) {
+                    std::sort(involved.begin(), involved.end());
+                    involved.erase(std::unique(involved.begin(), involved.end()), involved.end());
+                    conflicts.insert(involved);
+                };
+                for (int v : moved) {
+                    const Coord2& pos = placed[v].getCoord();
+                    for (int u : spatialGrid.getNearbyVertices(pos, 1)) {
+                        if (u != v && VVOverlap(placed[v], placed[u])) addConflict({v, u});
+                    }
+                    for (int e : spatialGrid.getNearbyEdges(pos, 1)) {
+                        if (!isEndpoint(v, e) && VEOverlap(placed[v], placedEdges[e])) {
+                            addConflict({v, edgeEnds[e].first, edgeEnds[e].second});
+                        }
+                    }
+                    for (int e : incidentEdges[v]) {
+                        const Coord2& start = placed[edgeEnds[e].first].getCoord();
+                        const Coord2& end = placed[edgeEnds[e].second].getCoord();
+                        for (int u : spatialGrid.getVerticesAlongLine(start, end)) {
+                            if (!isEndpoint(u, e) && VEOverlap(placed[u], placedEdges[e])) {
+                                addConflict({u, edgeEnds[e].first, edgeEnds[e].second});
+                            }
+                        }
+                        for (int f : spatialGrid.getEdgesAlongLine(start, end)) {
+                            if (f != e && EEOverlap(placedEdges[e], placedEdges[f])) {
+                                addConflict({edgeEnds[e].first, edgeEnds[e].second, edgeEnds[f].first, edgeEnds[f].second});
+                            }
+                        }
+                    }
+                }
+
+                // No-good: at least one involved binary has to flip
+                for (const auto& involved : conflicts) {
+                    GRBLinExpr flips = 0;
+                    int termNum = 0;
+                    for (int u : involved) {
+                        for (int k = 0; k < hOptions[u].z.size(); ++k, ++termNum) {
+                            flips += (hValue[u][k] > 0.5) ? 1 - hOptions[u].z[k] : GRBLinExpr(hOptions[u].z[k]);
+                        }
+                        for (int k = 0; k < vOptions[u].z.size(); ++k, ++termNum) {
+                            flips += (vValue[u][k] > 0.5) ? 1 - vOptions[u].z[k] : GRBLinExpr(vOptions[u].z[k]);
+                        }
+                    }
+                    if (termNum > 0) {
+                        addLazy(flips >= 1);
+                        ++lazyNum;
+                    }
+                }
+            } catch (GRBException e) {
+                std::cerr << "Gurobi error in overlap callback: " << e.getErrorCode() << " " << e.getMessage() << std::endl;
+            }
+        }
+    };
+
+    // Every vertex may move each coordinate onto any detected line within ALIGNMENT_TOLERANCE,
+    // or keep it. Objective per vertex: weighted squared displacement minus MILP_ALIGNMENT_REWARD
+    // per aligned coordinate; with one-hot options both are linear in the binaries. Overlaps are
+    // excluded lazily by AlignmentOverlapCallback, so Phase 2.5 is not needed.
+    // Fills newXs / newYs and the chosen assignments; false if no overlap-free solution is found.
+    static bool solveAlignmentMILP(
+        const std::vector<BaseVertexProperty>& vertexList,
+        const std::vector<BaseEdgeProperty>& edgeList,
+        const BaseUGraphProperty& graph,
+        const std::vector<double>& hLines,
+        const std::vector<double>& vLines,
+        const std::vector<char>* fixedVertices,
+        std::vector<VertexLineCandidate>& chosen,
+        std::vector<double>& newXs,
+        std::vector<double>& newYs,
+        const std::string& testCaseName) {
+
+        const int vertexNum = vertexList.size();
+        std::map<unsigned int, int> vertexID2Index = createVertexID2Index(vertexList);
+
+        std::vector<std::pair<int, int>> edgeEnds(edgeList.size());
+        std::vector<std::vector<int>> incidentEdges(vertexNum);
+        double totalEdgeLength = 0.0;
+        for (int e = 0; e < edgeList.size(); ++e) {
+            edgeEnds[e] = {vertexID2Index[edgeList[e].Source().getID()], vertexID2Index[edgeList[e].Target().getID()]};
+            incidentEdges[edgeEnds[e].first].push_back(e);
+            incidentEdges[edgeEnds[e].second].push_back(e);
+            Coord2 d = edgeList[e].Source().getCoord() - edgeList[e].Target().getCoord();
+            totalEdgeLength += std::sqrt(d.x() * d.x() + d.y() * d.y());
+        }
+
+        GRBEnv env(true);
+        env.set("LogFile", "output/" + testCaseName + "_vertex_alignment_milp.log");
+        env.start();
+        GRBModel model(env);
+        model.set(GRB_IntParam_LazyConstraints, 1);
+        model.set(GRB_DoubleParam_TimeLimit, MILP_TIME_LIMIT);
+
+        AxisLineIndex hIndex(hLines), vIndex(vLines);
+        std::vector<AxisOptions> hOptions(vertexNum), vOptions(vertexNum);
+        GRBLinExpr objective = 0;
+        int optionNum = 0;
+        for (int i = 0; i < vertexNum; ++i) {
+            if (fixedVertices && (*fixedVertices)[i]) {
+                continue;       // no options: keeps its coordinates
+            }
+            double weight = calculateVWeight(vertexList[i], graph);
+            for (int axis = 0; axis < 2; ++axis) {
+                bool isHorizontal = (axis == 0);
+                const AxisLineIndex& index = isHorizontal ? hIndex : vIndex;
+                AxisOptions& options = isHorizontal ? hOptions[i] : vOptions[i];
+                double p = isHorizontal ? vertexList[i].getCoord().y() : vertexList[i].getCoord().x();
+
+                std::pair<int, int> slots = index.range(p - ALIGNMENT_TOLERANCE, p + ALIGNMENT_TOLERANCE);
+                GRBLinExpr oneHot = 0;
+                for (int slot = slots.first; slot < slots.second; ++slot) {
+                    double d = index.position(slot) - p;
+                    GRBVar z = model.addVar(0.0, 1.0, 0.0, GRB_BINARY,
+                        std::string(isHorizontal ? "zh_" : "zv_") + std::to_string(i) + "_" + std::to_string(index.lineIndex(slot)));
+                    options.z.push_back(z);
+                    options.lineIdx.push_back(index.lineIndex(slot));
+                    options.position.push_back(index.position(slot));
+                    oneHot += z;
+                    objective += (weight * d * d - MILP_ALIGNMENT_REWARD) * z;
+                    ++optionNum;
+                }
+                if (options.z.size() > 1) {
+                    model.addConstr(oneHot <= 1, std::string(isHorizontal ? "one_h_" : "one_v_") + std::to_string(i));
+                }
+            }
+        }
+        std::cout << "MILP: " << optionNum << " binary alignment options" << std::endl;
+
+        model.setObjective(objective, GRB_MINIMIZE);
+        AlignmentOverlapCallback callback(vertexList, edgeEnds, incidentEdges, hOptions, vOptions,
+            edgeList.empty() ? 1.0 : OVERLAP_GRID_CELL_FACTOR * totalEdgeLength / edgeList.size());
+        model.setCallback(&callback);
+
+        std::cout << "Solving MILP with lazy overlap constraints..." << std::endl;
+        model.optimize();
+
+        int status = model.get(GRB_IntAttr_Status);
+        if (status != GRB_OPTIMAL && !(status == GRB_TIME_LIMIT && model.get(GRB_IntAttr_SolCount) > 0)) {
+            std::cerr << "MILP ended with status " << status << std::endl;
+            return false;
+        }
+        std::cout << "\n=== MILP completed" << (status == GRB_OPTIMAL ? "" : " (time limit, best incumbent)") << " ===" << std::endl;
+        std::cout << "Objective value: " << model.get(GRB_DoubleAttr_ObjVal) << std::endl;
+        std::cout << "Lazy overlap constraints added: " << callback.lazyNum << std::endl;
+
+        newXs.resize(vertexNum);
+        newYs.resize(vertexNum);
+        chosen.clear();
+        for (int i = 0; i < vertexNum; ++i) {
+            newXs[i] = vertexList[i].getCoord().x();
+            newYs[i] = vertexList[i].getCoord().y();
+            for (int k = 0; k < hOptions[i].z.size(); ++k) {
+                if (hOptions[i].z[k].get(GRB_DoubleAttr_X) > 0.5) {
+                    chosen.push_back({i, hOptions[i].lineIdx[k], true, std::abs(hOptions[i].position[k] - newYs[i]), hOptions[i].position[k]});
+                    newYs[i] = hOptions[i].position[k];
+                    break;
+                }
+            }
+            for (int k = 0; k < vOptions[i].z.size(); ++k) {
+                if (vOptions[i].z[k].get(GRB_DoubleAttr_X) > 0.5) {
+                    chosen.push_back({i, vOptions[i].lineIdx[k], false, std::abs(vOptions[i].position[k] - newXs[i]), vOptions[i].position[k]});
+                    newXs[i] = vOptions[i].position[k];
+                    break;
+                }
+            }
+        }
+        return true;
     }
 
     int optimizeVertexAlignment(
         std::vector<BaseVertexProperty>& vertexList, 
         std::vector<BaseEdgeProperty>& edgeList, 
         BaseUGraphProperty& graph,
-        const std::string& testCaseName) {
+        const std::string& testCaseName,
+        const std::vector<char>* fixedVertices,
+        const std::vector<double>* sharedHLines,
+        const std::vector<double>* sharedVLines) {
         try {
             std::cout << "=== Starting Vertex Alignment Optimization ===" << std::endl;
         
@@ -213,9 +536,6 @@ namespace Map {
                 return 0;
             }
             
-            // Create vertex ID to index mapping
-            std::map<unsigned int, int> vertexID2Index = createVertexID2Index(vertexList);
-        
             // Calculate coordinate boundaries
             double x_min = vertexList[0].getCoord().x();
             double x_max = vertexList[0].getCoord().x();
@@ -243,8 +563,18 @@ namespace Map {
             std::cout << "\n=== Phase 1: Line Detection ===" << std::endl;
             
             int optimalHorizontalK, optimalVerticalK;
-            std::vector<double> hLines = clusterCoordinates1D(yCoords, optimalHorizontalK);
-            std::vector<double> vLines = clusterCoordinates1D(xCoords, optimalVerticalK);
+            std::vector<double> hLines, vLines;
+            std::vector<std::function<void()>> axisJobs;
+            if (sharedHLines) hLines = *sharedHLines;
+            else axisJobs.emplace_back([&] { hLines = clusterCoordinates1D(yCoords, optimalHorizontalK); });
+            if (sharedVLines) vLines = *sharedVLines;
+            else axisJobs.emplace_back([&] { vLines = clusterCoordinates1D(xCoords, optimalVerticalK); });
+            if (USE_PARALLEL_LINE_DETECTION) {
+                ThreadPool::shared().run(axisJobs);
+            }
+            else {
+                for (auto& job : axisJobs) job();
+            }
             
             std::cout << "Detected " << hLines.size() << " horizontal alignment lines" << std::endl;
             for (int i = 0; i < hLines.size(); ++i) {
@@ -262,6 +592,18 @@ namespace Map {
                 return 0;
             }
 
+            if (ALIGNMENT_METHOD == MIXED_INTEGER) {
+                // Joint assignment with lazy overlap constraints replaces Phases 2 - 3
+                std::cout << "\n=== Phase 2-3: Joint MILP Assignment ===" << std::endl;
+                std::vector<VertexLineCandidate> chosen;
+                std::vector<double> newXs, newYs;
+                if (!solveAlignmentMILP(vertexList, edgeList, graph, hLines, vLines, fixedVertices, chosen, newXs, newYs, testCaseName)) {
+                    return -1;
+                }
+                applyAlignedCoordinates(vertexList, edgeList, graph, chosen, newXs, newYs, testCaseName);
+                return 0;
+            }
+
             // ----------------------------------------------------------------------------------------------------
             // Phase 2: Pre-select vertices for alignment
             // ----------------------------------------------------------------------------------------------------
@@ -269,6 +611,11 @@ namespace Map {
             std::cout << "\n=== Phase 2: Pre-selection ===" << std::endl;
             
             std::vector<VertexLineCandidate> alignmentCandidates = preSelect(vertexList, hLines, vLines);
+            if (fixedVertices) {
+                alignmentCandidates.erase(std::remove_if(alignmentCandidates.begin(), alignmentCandidates.end(),
+                    [fixedVertices](const VertexLineCandidate& candidate) { return (*fixedVertices)[candidate.vertexIdx] != 0; }),
+                    alignmentCandidates.end());
+            }
             
             std::cout << "Selected " << alignmentCandidates.size() << " alignment constraints:" << std::endl;
             
@@ -298,6 +645,27 @@ namespace Map {
             
             std::vector<VertexLineCandidate> validCandidates;
             
+            // Flat geometry for the overlap checks, updated in place after every accepted move. On
+            // large graphs its spatial index limits each check to the candidate's neighbourhood.
+            OverlapGeometry geometry;
+            geometry.build(graph);
+            if (geometry.vertexNum() >= OVERLAP_INDEX_MIN_VERTICES) {
+                double totalEdgeLength = 0.0;
+                for (const auto& edge : edgeList) {
+                    Coord2 d = edge.Source().getCoord() - edge.Target().getCoord();
+                    totalEdgeLength += std::sqrt(d.x() * d.x() + d.y() * d.y());
+                }
+                geometry.buildSpatialIndex(edgeList.empty() ? 1.0 : OVERLAP_GRID_CELL_FACTOR * totalEdgeLength / edgeList.size());
+            }
+            
+            // vertexList index -> descriptor and geometry index, resolved once
+            std::vector<BaseUGraphProperty::vertex_descriptor> idx2Desc(vertexList.size());
+            std::vector<int> idx2Geometry(vertexList.size());
+            for (int i = 0; i < vertexList.size(); ++i) {
+                idx2Desc[i] = getVertexDescriptor(vertexList[i].getID());
+                idx2Geometry[i] = geometry.indexOf(vertexList[i].getID());
+            }
+            
             // Process each line group
             // !!! lineKey: {lineIdx, isHorizontal}
             // !!! group: vector<VertexLineCandidate>
@@ -325,32 +693,24 @@ namespace Map {
                              << " at (" << newPos.x() << ", " << newPos.y() << ")..." << std::endl;
                     
                     // Check overlap
-                    if (!overlapHappens(vertexID, newPos, graph)) {
+                    if (!overlapKernel(geometry, idx2Geometry[vertexIdx], newPos.x(), newPos.y())) {
                         // No overlap - accept this alignment
                         validCandidates.push_back(cand);
                         
-                        // Immediately update graph
-                        std::pair<BaseUGraphProperty::vertex_iterator, BaseUGraphProperty::vertex_iterator> tvp = vertices(graph);
-                        for (BaseUGraphProperty::vertex_iterator vit = tvp.first; vit != tvp.second; ++vit) {
-                            if (graph[*vit].getID() == vertexID) {
-                                graph[*vit].setCoord(newPos.x(), newPos.y());
-                                break;
-                            }
-                        }
-                        
-                        // Update vertexList
+                        // Immediately update graph, vertexList and the geometry
+                        BaseUGraphProperty::vertex_descriptor vd = idx2Desc[vertexIdx];
+                        graph[vd].setCoord(newPos.x(), newPos.y());
                         vertexList[vertexIdx].setCoord(newPos.x(), newPos.y());
+                        geometry.setCoord(idx2Geometry[vertexIdx], newPos.x(), newPos.y());
                         
-                        // Update related edges in graph and edgeList
-                        std::pair<BaseUGraphProperty::edge_iterator, BaseUGraphProperty::edge_iterator> ep_temp = edges(graph);
-                        for (BaseUGraphProperty::edge_iterator ei = ep_temp.first; ei != ep_temp.second; ++ei) {
-                            if (graph[*ei].Source().getID() == vertexID || graph[*ei].Target().getID() == vertexID) {
-                                BaseUGraphProperty::vertex_descriptor source_desc = boost::source(*ei, graph);
-                                BaseUGraphProperty::vertex_descriptor target_desc = boost::target(*ei, graph);
-                                double newAngle = calculateAngle(graph[source_desc], graph[target_desc]);
-                                graph[*ei].setAngle(newAngle);
-                                edgeList[graph[*ei].ID()].setAngle(newAngle);
-                            }
+                        // Update incident edges only
+                        auto oep = boost::out_edges(vd, graph);
+                        for (auto oeit = oep.first; oeit != oep.second; ++oeit) {
+                            BaseUGraphProperty::vertex_descriptor source_desc = boost::source(*oeit, graph);
+                            BaseUGraphProperty::vertex_descriptor target_desc = boost::target(*oeit, graph);
+                            double newAngle = calculateAngle(graph[source_desc], graph[target_desc]);
+                            graph[*oeit].setAngle(newAngle);
+                            edgeList[graph[*oeit].ID()].setAngle(newAngle);
                         }
                         
                         std::cout << "    Aligned successfully" << std::endl;
@@ -372,138 +732,111 @@ namespace Map {
                 return 0;
             }
 
-            // Phase 3: Gurobi optimization
+            // Phase 3: Optimization
             std::cout << "\n=== Phase 3: Optimization ===" << std::endl;
             
-            // Create Gurobi environment and model
-            GRBEnv env(true);
-            env.set("LogFile", "vertex_alignment_opt.log");
-            env.start();
-            GRBModel model(env);
-
-            // Create decision variables for new coordinates
-            std::vector<GRBVar> X(vertexNum), Y(vertexNum);
-            for (int i = 0; i < vertexNum; ++i) {
-                X[i] = model.addVar(x_min, x_max, 0.0, GRB_CONTINUOUS, "X_" + std::to_string(i));
-                Y[i] = model.addVar(y_min, y_max, 0.0, GRB_CONTINUOUS, "Y_" + std::to_string(i));
-                
-                // Set initial values to original coordinates
-                X[i].set(GRB_DoubleAttr_Start, vertexList[i].getCoord().x());
-                Y[i].set(GRB_DoubleAttr_Start, vertexList[i].getCoord().y());
-            }
-
-            // Add forced alignment constraints for pre-selected vertices
-            for (const auto& candidate : alignmentCandidates) {
-                if (candidate.isHorizontal) {
-                    model.addConstr(Y[candidate.vertexIdx] == candidate.linePosition, 
-                                   "force_h_align_" + std::to_string(candidate.vertexIdx));
-                } 
+            std::vector<double> newXs, newYs;
+            bool solved = false;
+            
+            // Only forced equalities and the bounding box: the optimum is the projection
+            if (USE_CLOSED_FORM_PROJECTION) {
+                std::vector<AxisConstraint> constraints;
+                constraints.reserve(alignmentCandidates.size());
+                for (const auto& candidate : alignmentCandidates) {
+                    constraints.push_back({candidate.vertexIdx, candidate.isHorizontal, candidate.linePosition});
+                }
+                solved = solveAlignmentProjection(vertexList, constraints, x_min, x_max, y_min, y_max, newXs, newYs);
+                if (solved) {
+                    double objectiveValue = 0.0;
+                    for (int i = 0; i < vertexNum; ++i) {
+                        double dx = newXs[i] - vertexList[i].getCoord().x();
+                        double dy = newYs[i] - vertexList[i].getCoord().y();
+                        objectiveValue += calculateVWeight(vertexList[i], graph) * (dx * dx + dy * dy);
+                    }
+                    std::cout << "\n=== Optimization completed successfully! (closed-form projection) ===" << std::endl;
+                    std::cout << "Optimal objective value: " << objectiveValue << std::endl;
+                }
                 else {
-                    model.addConstr(X[candidate.vertexIdx] == candidate.linePosition, 
-                                   "force_v_align_" + std::to_string(candidate.vertexIdx));
+                    std::cout << "Constraints are not separable, falling back to Gurobi" << std::endl;
                 }
             }
-
-            // Set objective: minimize coordinate displacement (same as EdgeOrientation)
-            
-            GRBQuadExpr objective = 0;
-            for (int i = 0; i < vertexNum; ++i) {
-                double weight = calculateVWeight(vertexList[i], graph);
-                objective += weight * ((X[i] - vertexList[i].getCoord().x()) * (X[i] - vertexList[i].getCoord().x()) + 
-                            (Y[i] - vertexList[i].getCoord().y()) * (Y[i] - vertexList[i].getCoord().y()));
-            }
             
-            model.setObjective(objective, GRB_MINIMIZE);
-            
-            // Solve the optimization problem
-            std::cout << "Solving optimization problem..." << std::endl;
-            model.optimize();
-            
-            // Check optimization status and update coordinates
-            int status = model.get(GRB_IntAttr_Status);
-            if (status == GRB_OPTIMAL) {
-                std::cout << "\n=== Optimization completed successfully! ===" << std::endl;
-                std::cout << "Optimal objective value: " << model.get(GRB_DoubleAttr_ObjVal) << std::endl;
-                
-                // Print results and update coordinates
-                std::cout << "\n=== Aligned coordinates ===" << std::endl;
-                
-                // Group alignment candidates by vertex index for display
-                std::map<int, std::vector<VertexLineCandidate>> vertexToCandidates;
-                for (const auto& candidate : alignmentCandidates) {
-                    vertexToCandidates[candidate.vertexIdx].push_back(candidate);
-                }
-                
+            if (!solved) {
+                // Create Gurobi environment and model
+                GRBEnv env(true);
+                env.set("LogFile", "output/" + testCaseName + "_vertex_alignment_opt.log");
+                env.start();
+                GRBModel model(env);
+
+                // Create decision variables for new coordinates
+                std::vector<GRBVar> X(vertexNum), Y(vertexNum);
                 for (int i = 0; i < vertexNum; ++i) {
-                    double newX = X[i].get(GRB_DoubleAttr_X);
-                    double newY = Y[i].get(GRB_DoubleAttr_X);
+                    bool fixed = fixedVertices && (*fixedVertices)[i];
+                    double x = vertexList[i].getCoord().x();
+                    double y = vertexList[i].getCoord().y();
+                    X[i] = model.addVar(fixed ? x : x_min, fixed ? x : x_max, 0.0, GRB_CONTINUOUS, "X_" + std::to_string(i));
+                    Y[i] = model.addVar(fixed ? y : y_min, fixed ? y : y_max, 0.0, GRB_CONTINUOUS, "Y_" + std::to_string(i));
                     
-                    // Check if this vertex was in the alignment candidates
-                    auto it = vertexToCandidates.find(i);
-                    if (it != vertexToCandidates.end()) {
-                        const auto& candidates = it->second;
-                        std::cout << "Vertex " << vertexList[i].getID() << " aligned to ";
-                        
-                        for (int j = 0; j < candidates.size(); ++j) {
-                            if (j > 0) std::cout << " and ";
-                            const auto& candidate = candidates[j];
-                            std::cout << (candidate.isHorizontal ? "H-line y=" : "V-line x=") 
-                                     << candidate.linePosition;
-                        }
-                        std::cout << " (" << newX << ", " << newY << ")" << std::endl;
-                    }
-                    
-                    // Update vertices in graph and vertexList
-                    vertexList[i].setCoord(newX, newY);
+                    // Set initial values to original coordinates
+                    X[i].set(GRB_DoubleAttr_Start, vertexList[i].getCoord().x());
+                    Y[i].set(GRB_DoubleAttr_Start, vertexList[i].getCoord().y());
                 }
 
-                std::cout << "Total aligned vertices: " << vertexToCandidates.size() << "/" << vertexNum << std::endl;
-
-                // Update graph vertices (similar to EdgeOrientation)
-                std::pair<BaseUGraphProperty::vertex_iterator, BaseUGraphProperty::vertex_iterator> vp = vertices(graph);
-                for (BaseUGraphProperty::vertex_iterator vi = vp.first; vi != vp.second; ++vi) {
-                    BaseVertexProperty& vertex = graph[*vi];
-                    auto it = vertexID2Index.find(vertex.getID());
-                    if (it != vertexID2Index.end()) {
-                        int idx = it->second;
-                        double newX = X[idx].get(GRB_DoubleAttr_X);
-                        double newY = Y[idx].get(GRB_DoubleAttr_X);
-                        vertex.setCoord(newX, newY);
-
+                // Add forced alignment constraints for pre-selected vertices
+                for (const auto& candidate : alignmentCandidates) {
+                    if (candidate.isHorizontal) {
+                        model.addConstr(Y[candidate.vertexIdx] == candidate.linePosition, 
+                                       "force_h_align_" + std::to_string(candidate.vertexIdx));
+                    } 
+                    else {
+                        model.addConstr(X[candidate.vertexIdx] == candidate.linePosition, 
+                                       "force_v_align_" + std::to_string(candidate.vertexIdx));
                     }
                 }
 
-                // Update edge angles (similar to EdgeOrientation)
-                std::pair<BaseUGraphProperty::edge_iterator, BaseUGraphProperty::edge_iterator> ep = edges(graph);
-                for (BaseUGraphProperty::edge_iterator ei = ep.first; ei != ep.second; ++ei) {
-                    BaseEdgeProperty& edge = graph[*ei];
-                    
-                    BaseUGraphProperty::vertex_descriptor source_desc = boost::source(*ei, graph);
-                    BaseUGraphProperty::vertex_descriptor target_desc = boost::target(*ei, graph);
-                    
-                    // Recalculate angle with updated coordinates
-                    double newAngle = calculateAngle(graph[source_desc], graph[target_desc]);
-                    edge.setAngle(newAngle);
-                    edgeList[edge.ID()].setAngle(newAngle);
+                // Set objective: minimize coordinate displacement (same as EdgeOrientation)
+                
+                GRBQuadExpr objective = 0;
+                for (int i = 0; i < vertexNum; ++i) {
+                    double weight = calculateVWeight(vertexList[i], graph);
+                    objective += weight * ((X[i] - vertexList[i].getCoord().x()) * (X[i] - vertexList[i].getCoord().x()) + 
+                                (Y[i] - vertexList[i].getCoord().y()) * (Y[i] - vertexList[i].getCoord().y()));
+                }
+                
+                model.setObjective(objective, GRB_MINIMIZE);
+                
+                // Solve the optimization problem
+                std::cout << "Solving optimization problem..." << std::endl;
+                model.optimize();
+                
+                // Check optimization status
+                int status = model.get(GRB_IntAttr_Status);
+                if (status == GRB_INFEASIBLE) {
+                    std::cerr << "Model is infeasible!" << std::endl;
+                    return -1;
+                } 
+                else if (status == GRB_UNBOUNDED) {
+                    std::cerr << "Model is unbounded!" << std::endl;
+                    return -1;
+                } 
+                else if (status != GRB_OPTIMAL) {
+                    std::cerr << "Optimization ended with status " << status << std::endl;
+                    return -1;
+                }
+                
+                std::cout << "\n=== Optimization completed successfully! ===" << std::endl;
+                std::cout << "Optimal objective value: " << model.get(GRB_DoubleAttr_ObjVal) << std::endl;
+                
+                newXs.resize(vertexNum);
+                newYs.resize(vertexNum);
+                for (int i = 0; i < vertexNum; ++i) {
+                    newXs[i] = X[i].get(GRB_DoubleAttr_X);
+                    newYs[i] = Y[i].get(GRB_DoubleAttr_X);
                 }
-
-                std::string outputFile = "output/" + testCaseName + "_3.svg";
-                createVisualization(vertexList, edgeList, outputFile);
-
-            } 
-            else if (status == GRB_INFEASIBLE) {
-                std::cerr << "Model is infeasible!" << std::endl;
-                return -1;
-            } 
-            else if (status == GRB_UNBOUNDED) {
-                std::cerr << "Model is unbounded!" << std::endl;
-                return -1;
-            } 
-            else {
-                std::cerr << "Optimization ended with status " << status << std::endl;
-                return -1;
             }
             
+            applyAlignedCoordinates(vertexList, edgeList, graph, alignmentCandidates, newXs, newYs, testCaseName);
+            
         } catch (GRBException e) {
             std::cerr << "Gurobi error code: " << e.getErrorCode() << std::endl;
             std::cerr << e.getMessage() << std::endl;